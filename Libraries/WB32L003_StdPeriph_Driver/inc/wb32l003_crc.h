@@ -27,6 +27,17 @@
   */
 
 /* Exported types ------------------------------------------------------------*/
+
+/** 
+  * @brief  CRC streaming context, holds the running CRC between chunks
+  */
+typedef struct
+{
+  uint32_t State;     /*!< Raw CRC register, restored into CRC->RESULT on every update */
+  uint32_t Result;    /*!< CRC as read from CRC->RESULT after the last update */
+  uint32_t Length;    /*!< Number of bytes accumulated so far */
+} CRC_ContextTypeDef;
+
 /* Exported constants --------------------------------------------------------*/
 
 /** @defgroup TEMPLATE_Exported_Constants
@@ -34,6 +45,7 @@
   */
 
 #define CRC_DataAddress (CRC_BASE + 0x80) /*!< 0x80 ~ 0xFF is allowable */
+#define CRC_DataWindow  (0x80U)           /*!< Size in bytes of the data window */
 
 /**
   * @}
@@ -47,6 +59,10 @@ void CRC_DeInit(void);
 uint32_t CRC_Accumulate(const uint8_t *ptr_data, uint32_t bufferLength);
 uint32_t CRC_Calculate(const uint8_t *ptr_data, uint32_t bufferLength);
 
+void CRC_ContextInit(CRC_ContextTypeDef *ctx);
+void CRC_ContextUpdate(CRC_ContextTypeDef *ctx, const uint8_t *ptr_data, uint32_t bufferLength);
+uint32_t CRC_ContextFinal(const CRC_ContextTypeDef *ctx);
+
 /**
   * @}
   */
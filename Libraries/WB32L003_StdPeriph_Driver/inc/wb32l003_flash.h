@@ -81,6 +81,7 @@ typedef enum
   * @{
   */ 
 #define FLASH_PAGE_SIZE                        0x200U
+#define FLASH_SECTOR_SIZE                      0x400U /*!< Erase/write protect granularity of SLOCK0/1 */
 #define FLASH_SIZE_32K                         0x8000U
 #define FLASH_SIZE_64K                         0x10000U
 #define FLASH_ALLPAGE_SELECTED                 0xFFFFFFFFU
@@ -107,6 +108,8 @@ FLASH_Status FLASH_WaitForLastOperation(uint32_t Timeout);
 FLASH_Status FLASH_ProgramByte(uint32_t Addr, uint8_t Data);
 FLASH_Status FLASH_ProgramHalfWord(uint32_t Addr, uint16_t Data);
 FLASH_Status FLASH_ProgramWord(uint32_t Addr, uint32_t Data);
+FLASH_Status FLASH_ProgramBuffer(uint32_t Addr, const uint32_t *pData, uint32_t WordCount);
+FLASH_Status FLASH_ProgramPage(uint32_t PageAddr, const uint32_t *pData);
 FLASH_Status FLASH_EraseChip(void);
 FLASH_Status FLASH_ErasePage(uint32_t PageAddr);
 
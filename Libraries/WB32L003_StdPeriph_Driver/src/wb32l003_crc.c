@@ -26,6 +26,60 @@
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
+/**
+  * @brief  Feeds a buffer to the CRC data window with the widest aligned writes.
+  * @note   A word or halfword write is processed as its bytes in little endian
+  *         order, the same as the byte by byte feed. The 0x80 ~ 0xFF window
+  *         lets consecutive words go to consecutive addresses, so the compiler
+  *         can emit LDM/STM bursts.
+  * @param  pBuffer: pointer to the buffer containing the data to be computed
+  * @param  bufferLength: length of the buffer to be computed (in bytes)
+  * @retval None
+  */
+static void CRC_Feed(const uint8_t *pBuffer, uint32_t bufferLength)
+{
+  const uint32_t *pWord;
+
+  /* Bytes up to the first word boundary */
+  while((bufferLength != 0U) && (((uintptr_t)pBuffer & 0x3U) != 0U))
+  {
+    M8(CRC_DataAddress) = *pBuffer++;
+    bufferLength--;
+  }
+
+  /* Bursts of 4 words */
+  pWord = (const uint32_t *)pBuffer;
+  while(bufferLength >= 16U)
+  {
+    M32(CRC_DataAddress + 0x0U) = pWord[0];
+    M32(CRC_DataAddress + 0x4U) = pWord[1];
+    M32(CRC_DataAddress + 0x8U) = pWord[2];
+    M32(CRC_DataAddress + 0xCU) = pWord[3];
+    pWord += 4;
+    bufferLength -= 16U;
+  }
+
+  while(bufferLength >= 4U)
+  {
+    M32(CRC_DataAddress) = *pWord++;
+    bufferLength -= 4U;
+  }
+
+  /* Tail */
+  pBuffer = (const uint8_t *)pWord;
+  if(bufferLength >= 2U)
+  {
+    M16(CRC_DataAddress) = *(const uint16_t *)pBuffer;
+    pBuffer += 2;
+    bufferLength -= 2U;
+  }
+
+  if(bufferLength != 0U)
+  {
+    M8(CRC_DataAddress) = *pBuffer;
+  }
+}
+
 /** @defgroup CRC_Private_Functions
   * @{
   */
@@ -66,7 +120,7 @@ uint32_t CRC_Accumulate(const uint8_t *pBuffer, uint32_t bufferLength)
   /* Enter Data to the CRC calculator */
   for(index = 0U; index < bufferLength; index++)
   {
-    *(uint8_t*)(CRC_DataAddress) = *pBuffer++;
+    M8(CRC_DataAddress) = *pBuffer++;
   }
     
   /* Return the CRC computed value */
@@ -93,13 +147,67 @@ uint32_t CRC_Calculate(const uint8_t *pBuffer, uint32_t bufferLength)
   /* Enter Data to the CRC calculator */
   for(index = 0U; index < bufferLength; index++)
   {
-    *(uint8_t*)(CRC_DataAddress) = *pBuffer++;
+    M8(CRC_DataAddress) = *pBuffer++;
   }
   
   /* Return the CRC computed value */
   return (CRC->RESULT & CRC_RESULT_RESULT_Msk);
 }
 
+/**
+  * @brief  Initializes a CRC streaming context.
+  * @note   The peripheral is not reset. The seed is written once to learn
+  *         the CRC of an empty stream, so the CRC clock must be enabled.
+  * @param  ctx: pointer to a CRC_ContextTypeDef structure
+  * @retval None
+  */
+void CRC_ContextInit(CRC_ContextTypeDef *ctx)
+{
+  WRITE_REG(CRC->RESULT, CRC_RESULT_RESULT);
+
+  ctx->State = CRC_RESULT_RESULT;
+  ctx->Result = CRC->RESULT & CRC_RESULT_RESULT_Msk;
+  ctx->Length = 0U;
+}
+
+/**
+  * @brief  Accumulates a chunk into a CRC streaming context.
+  * @note   The raw CRC register is restored into CRC->RESULT first, so
+  *         several contexts can be interleaved. A write to RESULT loads the
+  *         register while a read may return it with an output xor applied,
+  *         so the value read back right after the restore gives that xor
+  *         and the raw state is saved without it. Chunks may be of any
+  *         length and alignment, a scatter-gather frame is one update per
+  *         segment.
+  * @param  ctx: pointer to a CRC_ContextTypeDef structure
+  * @param  pBuffer: pointer to the buffer containing the data to be computed
+  * @param  bufferLength: length of the buffer to be computed (in bytes)
+  * @retval None
+  */
+void CRC_ContextUpdate(CRC_ContextTypeDef *ctx, const uint8_t *pBuffer, uint32_t bufferLength)
+{
+  uint32_t xorout;
+
+  WRITE_REG(CRC->RESULT, ctx->State);
+  xorout = (CRC->RESULT ^ ctx->State) & CRC_RESULT_RESULT_Msk;
+
+  CRC_Feed(pBuffer, bufferLength);
+
+  ctx->Result = CRC->RESULT & CRC_RESULT_RESULT_Msk;
+  ctx->State = ctx->Result ^ xorout;
+  ctx->Length += bufferLength;
+}
+
+/**
+  * @brief  Returns the CRC of all the chunks accumulated in a context.
+  * @param  ctx: pointer to a CRC_ContextTypeDef structure
+  * @retval 16-bit CRC
+  */
+uint32_t CRC_ContextFinal(const CRC_ContextTypeDef *ctx)
+{
+  return ctx->Result;
+}
+
 /**
   * @}
   */
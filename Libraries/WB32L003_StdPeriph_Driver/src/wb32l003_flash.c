@@ -413,6 +413,107 @@ FLASH_Status FLASH_ProgramWord(uint32_t Addr, uint32_t Data)
   return flashstatus;
 }
 
+/**
+  * @brief  Program a buffer of words at a specified address.
+  * @note   The sectors covered by the buffer are unlocked once for the whole
+  *         buffer. Each word is then programmed as FLASH_ProgramWord() does,
+  *         with interrupts masked and the program operation deselected again
+  *         before they are unmasked. A sector locked by an interrupt handler
+  *         between two words is unlocked again. The buffer is read back at
+  *         the end.
+  * @param  Addr: specify the address to be programmed, word aligned.
+  * @param  pData: pointer to the words to be programmed.
+  * @param  WordCount: number of words to be programmed.
+  * @retval FLASH_Status: FLASH_ERROR_ERPROT if a word does not read back.
+  */
+FLASH_Status FLASH_ProgramBuffer(uint32_t Addr, const uint32_t *pData, uint32_t WordCount)
+{
+  FLASH_Status flashstatus = FLASH_COMPLETE;
+  uint32_t first = Addr & ~(FLASH_SECTOR_SIZE - 1U);
+  uint32_t end = Addr + (WordCount << 2);
+  uint32_t sector;
+  uint32_t index;
+
+  if (WordCount == 0U)
+  {
+    return flashstatus;
+  }
+
+  flashstatus = FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE);
+
+  if (flashstatus == FLASH_COMPLETE)
+  {
+    for (sector = first; sector < end; sector += FLASH_SECTOR_SIZE)
+    {
+      FLASH_OP_Unlock(sector);
+    }
+
+    for (index = 0U; index < WordCount; index++)
+    {
+      uint32_t addr = Addr + (index << 2);
+      uint32_t slock;
+      int state;
+
+      state = __get_PRIMASK();
+      __disable_irq();
+
+      /* An interrupt handler may have used the single word APIs meanwhile */
+      slock = (addr < FLASH_SIZE_32K) ? FLASH->SLOCK0 : FLASH->SLOCK1;
+      if ((slock & (0x01U << ((addr >> 10) & 0x1FU))) == 0U)
+      {
+        FLASH_OP_Unlock(addr);
+      }
+
+      FLASH_Unlock();
+      MODIFY_REG(FLASH->CR, FLASH_CR_OP, FLASH_OP_PROGRAM);
+      M32(addr) = pData[index];
+      FLASH_Lock();
+
+      FLASH_OP_Delay(0xFFF);
+
+      flashstatus = FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE);
+
+      CLEAR_BIT(FLASH->CR, FLASH_CR_OP);
+
+      if (!state)
+      {
+        __enable_irq();
+      }
+
+      if (flashstatus != FLASH_COMPLETE)
+      {
+        break;
+      }
+    }
+
+    for (sector = first; sector < end; sector += FLASH_SECTOR_SIZE)
+    {
+      FLASH_OP_Lock(sector);
+    }
+
+    for (index = 0U; (flashstatus == FLASH_COMPLETE) && (index < WordCount); index++)
+    {
+      if (M32(Addr + (index << 2)) != pData[index])
+      {
+        flashstatus = FLASH_ERROR_ERPROT;
+      }
+    }
+  }
+
+  return flashstatus;
+}
+
+/**
+  * @brief  Program a whole page.
+  * @param  PageAddr: specify the page address, FLASH_PAGE_SIZE aligned.
+  * @param  pData: pointer to FLASH_PAGE_SIZE bytes of words.
+  * @retval FLASH_Status
+  */
+FLASH_Status FLASH_ProgramPage(uint32_t PageAddr, const uint32_t *pData)
+{
+  return FLASH_ProgramBuffer(PageAddr, pData, FLASH_PAGE_SIZE >> 2);
+}
+
 /**
   * @brief  Full erase of FLASH memory Bank 
   * @param  None
@@ -5,30 +5,222 @@
 
 #include "multi_button.h"
 
-#define EVENT_CB(ev)   if(handle->cb[ev])handle->cb[ev]((void*)handle)
+#if BUTTON_DEFERRED_CB
+#define EVENT_CB(ev)   do { event_push(handle, ev); if(handle->cb[ev].plain)defer_push(handle); } while(0)
+#else
+#define EVENT_CB(ev)   do { event_push(handle, ev); if(handle->cb[ev].plain)event_dispatch(handle, &current_event); } while(0)
+#endif
 #define PRESS_REPEAT_MAX_NUM  15 /*!< The maximum value of the repeat counter */
 
 //button handle list head.
 static struct Button* head_handle = NULL;
+//started handles hashed by button id, chained through id_next.
+static struct Button* id_hash[BUTTON_ID_HASH_SIZE];
+#define ID_BUCKET(id)  (&id_hash[(id) & (BUTTON_ID_HASH_SIZE - 1)])
+
+//event queue, written by button_ticks(), drained by button_poll_events().
+static ButtonEvent event_queue[EVENT_QUEUE_SIZE];
+static volatile uint16_t event_head = 0;
+static volatile uint16_t event_tail = 0;
+//bumped on every in place refresh of a queued LONG_PRESS_HOLD.
+static volatile uint8_t event_rewrite = 0;
+static uint32_t changed_mask = 0;
+//consumer congested: hold events are not queued.
+static volatile uint8_t event_backpressure = 0;
+static uint32_t event_dropped = 0;
+
+//engine clock, counts button_ticks() calls.
+static volatile uint32_t button_clock = 0;
+//record of the last event happened.
+static ButtonEvent current_event;
+//record of the event being dispatched.
+static const ButtonEvent* dispatch_event = &current_event;
+
+#if BUTTON_DEFERRED_CB
+//callbacks queued by button_ticks(), run by button_dispatch().
+typedef struct {
+	struct Button* handle;
+	ButtonEvent ev;
+} DeferredEvent;
+
+static DeferredEvent defer_queue[DEFER_QUEUE_SIZE];
+static volatile uint16_t defer_head = 0;
+static volatile uint16_t defer_tail = 0;
+static uint32_t defer_dropped = 0;
+#endif
+
+#if BUTTON_LATENCY
+//the events an edge triggers, the others wait for a timeout after it.
+#define LATENCY_EVENTS ((1u << PRESS_DOWN) | (1u << PRESS_UP) | (1u << PRESS_REPEAT))
+//edge to callback latency per event type.
+static ButtonLatency latency[number_of_event];
+static uint32_t (*latency_clock)(void) = NULL;
+#endif
 
 static void button_handler(struct Button* handle);
 
+#if BUTTON_TELEMETRY || BUTTON_LATENCY
+/**
+  * @brief  Log2 histogram bucket of a duration.
+  * @param  value: duration in ticks.
+  * @param  buckets: number of buckets, the last one collects the overflow.
+  * @retval bucket index.
+  */
+static uint8_t log2_bucket(uint32_t value, uint8_t buckets)
+{
+	uint8_t n = 0;
+	while(value > 1 && n < buckets - 1) {
+		value >>= 1;
+		n++;
+	}
+	return n;
+}
+#endif
+
+/**
+  * @brief  Call the callback attached to the event.
+  * @param  handle: the button handle struct.
+  * @param  ev: the event record.
+  * @retval None
+  */
+static void event_dispatch(struct Button* handle, const ButtonEvent* ev)
+{
+	const BtnHandler* cb = &handle->cb[ev->event];
+
+#if BUTTON_LATENCY
+	if(latency_clock && (LATENCY_EVENTS & (1u << ev->event))) {
+		ButtonLatency* lat = &latency[ev->event];
+		uint32_t spent = latency_clock() - ev->edge_time;
+		if(lat->count == 0 || spent < lat->min) lat->min = spent;
+		if(spent > lat->max) lat->max = spent;
+		lat->sum += spent;
+		lat->count++;
+		lat->hist[log2_bucket(spent, LATENCY_BUCKETS)]++;
+	}
+#endif
+	dispatch_event = ev;
+	if(handle->cb_ctx_mask & (1u << ev->event)) {
+		cb->ctx(handle->user_data, ev);
+	} else {
+		cb->plain((void*)handle);
+	}
+}
+
+#if BUTTON_DEFERRED_CB
+/**
+  * @brief  Queue the callback of the current event, dropped when the queue is full.
+  * @param  handle: the button handle struct.
+  * @retval None
+  */
+static void defer_push(struct Button* handle)
+{
+	uint16_t head = defer_head;
+
+	if((uint16_t)(head - defer_tail) >= DEFER_QUEUE_SIZE) { //full
+		defer_dropped++;
+		return;
+	}
+	defer_queue[head & (DEFER_QUEUE_SIZE - 1)].handle = handle;
+	defer_queue[head & (DEFER_QUEUE_SIZE - 1)].ev = current_event;
+	defer_head = head + 1;
+}
+#endif
+
+/**
+  * @brief  Wake the waiters of the current event, each waiter fires once.
+  * @param  handle: the button handle struct.
+  * @retval None
+  */
+static void event_wake(struct Button* handle)
+{
+	ButtonWaiter** curr;
+	for(curr = &handle->waiters; *curr; ) {
+		ButtonWaiter* waiter = *curr;
+		if(waiter->event_mask & (1u << current_event.event)) {
+			*curr = waiter->next;
+			waiter->next = NULL;
+			waiter->wake(waiter, &current_event);
+		} else {
+			curr = &waiter->next;
+		}
+	}
+}
+
+/**
+  * @brief  Record an event in the queue, dropped when the queue is full.
+  *         LONG_PRESS_HOLD refreshes the hold record of the button when it is
+  *         still queued and nothing followed it, so a held button takes one slot.
+  * @param  handle: the button handle struct.
+  * @param  event: the event happened.
+  * @retval None
+  */
+static void event_push(struct Button* handle, PressEvent event)
+{
+	uint16_t head = event_head;
+	uint32_t held = button_clock - handle->press_time;
+
+	current_event.timestamp = button_clock;
+	current_event.duration = held > 0xFFFF ? 0xFFFF : (uint16_t)held;
+	current_event.button_id = handle->button_id;
+	current_event.event = (uint8_t)event;
+	current_event.repeat = handle->repeat;
+	current_event.stage = handle->long_stage;
+#if BUTTON_LATENCY
+	current_event.edge_time = handle->edge_time;
+#endif
+
+	if(handle->waiters) event_wake(handle);
+#if BUTTON_TELEMETRY
+	switch(event) {
+	case PRESS_DOWN:       handle->stats.presses++; break;
+	case SINGLE_CLICK:     handle->stats.clicks++; break;
+	case DOUBLE_CLICK:     handle->stats.double_clicks++; break;
+	case LONG_PRESS_START: handle->stats.long_presses++; break;
+	case PRESS_UP:
+		handle->stats.press_hist[log2_bucket(held, STATS_PRESS_BUCKETS)]++;
+		break;
+	default: break;
+	}
+#endif
+	changed_mask |= (uint32_t)1 << (handle->button_id < 31 ? handle->button_id : 31);
+	if(event == LONG_PRESS_HOLD) { //repeats every tick
+		ButtonEvent* last = &event_queue[handle->queue_pos & (EVENT_QUEUE_SIZE - 1)];
+		if(event_backpressure) return; //keep room for the rest
+		if((uint16_t)(handle->queue_pos - event_tail) < (uint16_t)(head - event_tail) &&
+		   last->button_id == handle->button_id && last->event == LONG_PRESS_HOLD) {
+			*last = current_event;
+			event_rewrite++;
+			return;
+		}
+	}
+	if((uint16_t)(head - event_tail) >= EVENT_QUEUE_SIZE) { //full
+		event_dropped++;
+		return;
+	}
+	event_queue[head & (EVENT_QUEUE_SIZE - 1)] = current_event;
+	handle->queue_pos = head;
+	event_head = head + 1;
+}
+
 /**
   * @brief  Initializes the button struct handle.
   * @param  handle: the button handle struct.
   * @param  pin_level: read the HAL GPIO of the connected button level.
   * @param  active_level: pressed GPIO level.
   * @param  button_id: the button id.
-  * @retval None
+  * @retval 0: succeed. -1: the handle is started, button_stop() it first.
   */
-void button_init(struct Button* handle, uint8_t(*pin_level)(uint8_t), uint8_t active_level, uint8_t button_id)
+int button_init(struct Button* handle, uint8_t(*pin_level)(uint16_t), uint8_t active_level, uint16_t button_id)
 {
+	//pprev of a fresh handle may be garbage, only the id table tells a started one
+	if(handle->pprev && button_find(handle->button_id) == handle) return -1;
 	memset(handle, 0, sizeof(struct Button));
 	handle->event = (uint8_t)NONE_PRESS;
 	handle->hal_button_Level = pin_level;
 	handle->button_level = !active_level;
 	handle->active_level = active_level;
 	handle->button_id = button_id;
+	return 0;
 }
 
 /**
@@ -40,7 +232,159 @@ void button_init(struct Button* handle, uint8_t(*pin_level)(uint8_t), uint8_t ac
   */
 void button_attach(struct Button* handle, PressEvent event, BtnCallback cb)
 {
-	handle->cb[event] = cb;
+	handle->cb[event].plain = cb;
+	handle->cb_ctx_mask &= ~(1u << event);
+}
+
+/**
+  * @brief  Attach a context event callback, called with user_data and the event record.
+  * @param  handle: the button handle struct.
+  * @param  event: trigger event type.
+  * @param  cb: callback function.
+  * @param  user_data: context passed back to cb. One per button: the last attach
+  *         sets it for every ctx callback of the button.
+  * @retval None
+  */
+void button_attach_ctx(struct Button* handle, PressEvent event, BtnCtxCallback cb, void* user_data)
+{
+	handle->cb[event].ctx = cb;
+	handle->cb_ctx_mask |= (1u << event);
+	handle->user_data = user_data;
+}
+
+/**
+  * @brief  Set the long press stage thresholds, each stage fires LONG_PRESS_STAGE once per hold.
+  *         Thresholds count from the press down and may be below LONG_TICKS.
+  * @param  handle: the button handle struct.
+  * @param  stage_ticks: ascending hold time thresholds in ticks, must stay valid while in use.
+  * @param  stage_num: number of stages, 0 disables staging.
+  * @retval 0: succeed. -1: too many stages or thresholds not ascending.
+  */
+int button_set_long_stages(struct Button* handle, const uint16_t* stage_ticks, uint8_t stage_num)
+{
+	uint8_t i;
+
+	if(stage_num > LONG_STAGE_MAX) return -1;
+	for(i = 1; i < stage_num; i++) {
+		if(stage_ticks[i] <= stage_ticks[i - 1]) return -1;
+	}
+	handle->long_stage_ticks = stage_ticks;
+	handle->long_stage_num = stage_num;
+	handle->long_stage = 0;
+	return 0;
+}
+
+/**
+  * @brief  Inquire the last long press stage reached.
+  * @param  handle: the button handle struct.
+  * @retval 0: no stage reached yet, n: stage n (1 based) reached.
+  */
+uint8_t get_button_long_stage(struct Button* handle)
+{
+	return handle->long_stage;
+}
+
+#if BUTTON_TELEMETRY
+/**
+  * @brief  Snapshot the usage counters and histograms.
+  * @param  handle: the button handle struct.
+  * @param  stats: destination of the snapshot.
+  * @retval None
+  */
+void button_get_stats(struct Button* handle, ButtonStats* stats)
+{
+	memcpy(stats, &handle->stats, sizeof(ButtonStats));
+}
+
+/**
+  * @brief  Reset the usage counters and histograms.
+  * @param  handle: the button handle struct.
+  * @retval None
+  */
+void button_clear_stats(struct Button* handle)
+{
+	memset(&handle->stats, 0, sizeof(ButtonStats));
+}
+#endif
+
+#if BUTTON_LATENCY
+/**
+  * @brief  Set the high resolution clock of the latency instrumentation.
+  * @param  clock: free running counter, e.g. Timebase_GetUs.
+  * @retval None
+  */
+void button_set_latency_clock(uint32_t (*clock)(void))
+{
+	latency_clock = clock;
+}
+
+/**
+  * @brief  Timestamp the raw edge from an EXTI handler, ahead of the first sample.
+  * @param  handle: the button handle struct.
+  * @retval None
+  */
+void button_mark_edge(struct Button* handle)
+{
+	if(!handle->edge_marked && latency_clock) {
+		handle->edge_time = latency_clock();
+		handle->edge_marked = 1;
+	}
+}
+
+/**
+  * @brief  Snapshot the edge to callback latency of an event type.
+  * @param  event: the event type.
+  * @param  stats: destination, avg is sum / count.
+  * @retval None
+  */
+void button_get_latency(PressEvent event, ButtonLatency* stats)
+{
+	memcpy(stats, &latency[event], sizeof(ButtonLatency));
+}
+
+/**
+  * @brief  Reset the latency statistics.
+  * @param  None.
+  * @retval None
+  */
+void button_clear_latency(void)
+{
+	memset(latency, 0, sizeof(latency));
+}
+#endif
+
+/**
+  * @brief  Wait once for an event, waiter->wake is called from button_ticks()
+  *         then the waiter is dropped. No cost per tick while nothing happens.
+  * @note   Call with the button_ticks() interrupt masked.
+  * @param  handle: the button handle struct.
+  * @param  waiter: event_mask and wake filled by the caller.
+  * @retval None
+  */
+void button_wait(struct Button* handle, ButtonWaiter* waiter)
+{
+	waiter->next = handle->waiters;
+	handle->waiters = waiter;
+}
+
+/**
+  * @brief  Drop a waiter before it fires.
+  * @note   Call with the button_ticks() interrupt masked.
+  * @param  handle: the button handle struct.
+  * @param  waiter: the waiter given to button_wait().
+  * @retval 0: dropped. -1: not waiting.
+  */
+int button_wait_cancel(struct Button* handle, ButtonWaiter* waiter)
+{
+	ButtonWaiter** curr;
+	for(curr = &handle->waiters; *curr; curr = &(*curr)->next) {
+		if(*curr == waiter) {
+			*curr = waiter->next;
+			waiter->next = NULL;
+			return 0;
+		}
+	}
+	return -1;
 }
 
 /**
@@ -53,6 +397,22 @@ PressEvent get_button_event(struct Button* handle)
 	return (PressEvent)(handle->event);
 }
 
+/**
+  * @brief  Fire LONG_PRESS_STAGE when the hold reaches the next stage threshold.
+  * @param  handle: the button handle struct, held since ticks was reset at press down.
+  * @retval None
+  */
+static void long_stage_check(struct Button* handle)
+{
+	//thresholds are ascending so only one compare
+	if(handle->long_stage < handle->long_stage_num &&
+	   handle->ticks >= handle->long_stage_ticks[handle->long_stage]) {
+		handle->long_stage++;
+		handle->event = (uint8_t)LONG_PRESS_STAGE;
+		EVENT_CB(LONG_PRESS_STAGE);
+	}
+}
+
 /**
   * @brief  Button driver core function, driver state machine.
   * @param  handle: the button handle struct.
@@ -67,12 +427,31 @@ static void button_handler(struct Button* handle)
 
 	/*------------button debounce handle---------------*/
 	if(read_gpio_level != handle->button_level) { //not equal to prev one
+#if BUTTON_LATENCY
+		if(latency_clock) {
+			if(!handle->edge_marked) handle->edge_time = latency_clock(); //first differing sample
+			handle->edge_marked = 1;
+		}
+#endif
 		//continue read 3 times same new level change
 		if(++(handle->debounce_cnt) >= DEBOUNCE_TICKS) {
 			handle->button_level = read_gpio_level;
 			handle->debounce_cnt = 0;
+#if BUTTON_LATENCY
+			handle->edge_marked = 0;
+#endif
 		}
 	} else { //level not change ,counter reset.
+#if BUTTON_LATENCY
+		//a bounce keeps the first edge, a level back for the debounce window drops it
+		if(handle->edge_marked && ++handle->edge_marked > DEBOUNCE_TICKS) handle->edge_marked = 0;
+#endif
+#if BUTTON_TELEMETRY
+		if(handle->debounce_cnt) { //bounce rejected
+			handle->stats.bounces++;
+			handle->stats.bounce_hist[log2_bucket(handle->debounce_cnt, STATS_BOUNCE_BUCKETS)]++;
+		}
+#endif
 		handle->debounce_cnt = 0;
 	}
 
@@ -80,10 +459,12 @@ static void button_handler(struct Button* handle)
 	switch (handle->state) {
 	case 0:
 		if(handle->button_level == handle->active_level) {	//start press down
+			handle->press_time = button_clock;
+			handle->repeat = 1;
 			handle->event = (uint8_t)PRESS_DOWN;
 			EVENT_CB(PRESS_DOWN);
 			handle->ticks = 0;
-			handle->repeat = 1;
+			handle->long_stage = 0;
 			handle->state = 1;
 		} else {
 			handle->event = (uint8_t)NONE_PRESS;
@@ -96,20 +477,25 @@ static void button_handler(struct Button* handle)
 			EVENT_CB(PRESS_UP);
 			handle->ticks = 0;
 			handle->state = 2;
-		} else if(handle->ticks > LONG_TICKS) {
-			handle->event = (uint8_t)LONG_PRESS_START;
-			EVENT_CB(LONG_PRESS_START);
-			handle->state = 5;
+		} else {
+			if(handle->ticks > LONG_TICKS) {
+				handle->event = (uint8_t)LONG_PRESS_START;
+				EVENT_CB(LONG_PRESS_START);
+				handle->state = 5;
+			}
+			long_stage_check(handle);
 		}
 		break;
 
 	case 2:
 		if(handle->button_level == handle->active_level) { //press down again
-			handle->event = (uint8_t)PRESS_DOWN;
-			EVENT_CB(PRESS_DOWN);
+			handle->press_time = button_clock;
 			if(handle->repeat != PRESS_REPEAT_MAX_NUM) {
 				handle->repeat++;
 			}
+			handle->long_stage = 0;
+			handle->event = (uint8_t)PRESS_DOWN;
+			EVENT_CB(PRESS_DOWN);
 			EVENT_CB(PRESS_REPEAT); // repeat hit
 			handle->ticks = 0;
 			handle->state = 3;
@@ -135,8 +521,11 @@ static void button_handler(struct Button* handle)
 			} else {
 				handle->state = 0;
 			}
-		} else if(handle->ticks > SHORT_TICKS) { // SHORT_TICKS < press down hold time < LONG_TICKS
-			handle->state = 1;
+		} else {
+			if(handle->ticks > SHORT_TICKS) { // SHORT_TICKS < press down hold time < LONG_TICKS
+				handle->state = 1;
+			}
+			long_stage_check(handle);
 		}
 		break;
 
@@ -145,6 +534,7 @@ static void button_handler(struct Button* handle)
 			//continue hold trigger
 			handle->event = (uint8_t)LONG_PRESS_HOLD;
 			EVENT_CB(LONG_PRESS_HOLD);
+			long_stage_check(handle);
 		} else { //released
 			handle->event = (uint8_t)PRESS_UP;
 			EVENT_CB(PRESS_UP);
@@ -160,16 +550,19 @@ static void button_handler(struct Button* handle)
 /**
   * @brief  Start the button work, add the handle into work list.
   * @param  handle: target handle struct.
-  * @retval 0: succeed. -1: already exist.
+  * @retval 0: succeed. -1: already exist. -2: button id used by another handle.
   */
 int button_start(struct Button* handle)
 {
-	struct Button* target = head_handle;
-	while(target) {
-		if(target == handle) return -1;	//already exist.
-		target = target->next;
-	}
+	struct Button** bucket = ID_BUCKET(handle->button_id);
+
+	if(handle->pprev) return -1;	//already exist.
+	if(button_find(handle->button_id)) return -2;
+	handle->id_next = *bucket;
+	*bucket = handle;
 	handle->next = head_handle;
+	if(head_handle) head_handle->pprev = &handle->next;
+	handle->pprev = &head_handle;
 	head_handle = handle;
 	return 0;
 }
@@ -182,16 +575,29 @@ int button_start(struct Button* handle)
 void button_stop(struct Button* handle)
 {
 	struct Button** curr;
-	for(curr = &head_handle; *curr; ) {
-		struct Button* entry = *curr;
-		if(entry == handle) {
-			*curr = entry->next;
-//			free(entry);
-			return;//glacier add 2021-8-18
-		} else {
-			curr = &entry->next;
-		}
+
+	if(!handle->pprev) return;	//not started.
+	*handle->pprev = handle->next;
+	if(handle->next) handle->next->pprev = handle->pprev;
+	handle->next = NULL;
+	handle->pprev = NULL;
+	for(curr = ID_BUCKET(handle->button_id); *curr != handle; curr = &(*curr)->id_next);
+	*curr = handle->id_next;
+	handle->id_next = NULL;
+}
+
+/**
+  * @brief  Find a started button by id.
+  * @param  button_id: the button id.
+  * @retval the button handle, NULL if not started.
+  */
+struct Button* button_find(uint16_t button_id)
+{
+	struct Button* target;
+	for(target = *ID_BUCKET(button_id); target; target = target->id_next) {
+		if(target->button_id == button_id) return target;
 	}
+	return NULL;
 }
 
 /**
@@ -202,7 +608,162 @@ void button_stop(struct Button* handle)
 void button_ticks(void)
 {
 	struct Button* target;
+	button_clock++;
+	changed_mask = 0;
 	for(target=head_handle; target; target=target->next) {
 		button_handler(target);
 	}
 }
+
+/**
+  * @brief  Inquire whether all buttons are released with no pending deadline,
+  *         so button_ticks() can be stopped until the next press edge.
+  * @param  None.
+  * @retval 1: idle. 0: busy.
+  */
+int button_is_idle(void)
+{
+	struct Button* target;
+#if BUTTON_DEFERRED_CB
+	if(defer_head != defer_tail) return 0;
+#endif
+	for(target=head_handle; target; target=target->next) {
+		if(target->state != 0 || target->debounce_cnt != 0 ||
+		   target->button_level == target->active_level) return 0;
+	}
+	return 1;
+}
+
+/**
+  * @brief  Resume after button_ticks() was stopped, credit the wake edge so
+  *         one confirming sample completes the debounce of the first press.
+  * @param  None.
+  * @retval None
+  */
+void button_resume(void)
+{
+	struct Button* target;
+	for(target=head_handle; target; target=target->next) {
+		if(target->hal_button_Level(target->button_id) != target->button_level &&
+		   DEBOUNCE_TICKS > 1) {
+			target->debounce_cnt = DEBOUNCE_TICKS - 1;
+		}
+	}
+}
+
+/**
+  * @brief  Inquire the engine clock.
+  * @param  None.
+  * @retval button_ticks() calls since start, multiply by TICKS_INTERVAL for ms.
+  */
+uint32_t button_get_clock(void)
+{
+	return button_clock;
+}
+
+/**
+  * @brief  Advance the engine clock, for ticks skipped while scanning slower.
+  * @param  ticks: number of button ticks not invoked.
+  * @retval None
+  */
+void button_clock_advance(uint32_t ticks)
+{
+	button_clock += ticks;
+}
+
+/**
+  * @brief  Inquire the record of the event being dispatched, valid inside callbacks.
+  * @param  None.
+  * @retval event record with timestamp, press duration and repeat count.
+  */
+const ButtonEvent* button_current_event(void)
+{
+	return dispatch_event;
+}
+
+#if BUTTON_DEFERRED_CB
+/**
+  * @brief  Inquire whether callbacks are queued, check after button_ticks()
+  *         to trigger the low priority context running button_dispatch().
+  * @param  None.
+  * @retval 1: pending. 0: none.
+  */
+int button_dispatch_pending(void)
+{
+	return defer_head != defer_tail;
+}
+
+/**
+  * @brief  Run the queued callbacks, from a context below the tick interrupt.
+  * @param  None.
+  * @retval None
+  */
+void button_dispatch(void)
+{
+	uint16_t tail = defer_tail;
+
+	while(tail != defer_head) {
+		DeferredEvent* item = &defer_queue[tail & (DEFER_QUEUE_SIZE - 1)];
+		event_dispatch(item->handle, &item->ev);
+		defer_tail = ++tail;
+	}
+}
+
+/**
+  * @brief  Callbacks dropped on a full deferred queue since power on.
+  * @param  None.
+  * @retval count.
+  */
+uint32_t button_dispatch_dropped(void)
+{
+	return defer_dropped;
+}
+#endif
+
+/**
+  * @brief  Backpressure from the event consumer, while set LONG_PRESS_HOLD
+  *         events are not queued so the discrete events are not dropped.
+  * @param  on: 1 congested, 0 clear.
+  * @retval None
+  */
+void button_set_backpressure(uint8_t on)
+{
+	event_backpressure = on;
+}
+
+/**
+  * @brief  Events dropped on a full queue since power on.
+  * @param  None.
+  * @retval count.
+  */
+uint32_t button_events_dropped(void)
+{
+	return event_dropped;
+}
+
+/**
+  * @brief  Drain the events of all buttons produced since the last call.
+  * @param  buf: destination of the event records.
+  * @param  n: max records to copy.
+  * @param  changed_mask_: if not NULL, bit n set when button id n got an event
+  *         during the last button_ticks(), bit 31 for all ids from 31 up:
+  *         scan the records for those.
+  * @retval number of records copied.
+  */
+uint16_t button_poll_events(ButtonEvent* buf, uint16_t n, uint32_t* changed_mask_)
+{
+	uint16_t tail = event_tail;
+	uint16_t count = (uint16_t)(event_head - tail);
+
+	if(changed_mask_) *changed_mask_ = changed_mask;
+	if(count > n) count = n;
+	for(n = 0; n < count; n++, tail++) {
+		uint8_t rewrite;
+		do { //copy again when button_ticks() refreshed a hold meanwhile
+			rewrite = event_rewrite;
+			buf[n] = event_queue[tail & (EVENT_QUEUE_SIZE - 1)];
+		} while(rewrite != event_rewrite);
+	}
+	event_tail = tail;
+	return count;
+}
@@ -14,9 +14,36 @@
 #define DEBOUNCE_TICKS    3	//MAX 7 (0 ~ 7)
 #define SHORT_TICKS       (300 /TICKS_INTERVAL)
 #define LONG_TICKS        (1000 /TICKS_INTERVAL)
+#define LONG_STAGE_MAX    4	//MAX long press stages per button
+#define EVENT_QUEUE_SIZE  16	//events buffered for button_poll_events(), power of 2, one hold per button
+#ifndef BUTTON_ID_HASH_SIZE
+#define BUTTON_ID_HASH_SIZE 16	//id hash buckets of button_find(), power of 2, ids below it never collide
+#endif
+#ifndef BUTTON_DEFERRED_CB
+#define BUTTON_DEFERRED_CB 1	//1: button_ticks() queues callbacks, button_dispatch() runs them
+#endif
+#define DEFER_QUEUE_SIZE  16	//callbacks queued for button_dispatch(), power of 2
+#ifndef BUTTON_TELEMETRY
+#define BUTTON_TELEMETRY  0	//1: per button usage counters and histograms
+#endif
+#define STATS_PRESS_BUCKETS  12	//press duration buckets, bucket n: [2^n, 2^(n+1)) ticks
+#define STATS_BOUNCE_BUCKETS 4	//bounce duration buckets, same log2 layout
+#ifndef BUTTON_LATENCY
+#define BUTTON_LATENCY    0	//1: edge to callback latency instrumentation, PRESS_DOWN/PRESS_UP/PRESS_REPEAT
+#endif
+#define LATENCY_BUCKETS   16	//latency buckets, bucket n: [2^n, 2^(n+1)) clock units
+
 
+struct ButtonEvent;
 
 typedef void (*BtnCallback)(void*);
+typedef void (*BtnCtxCallback)(void* user_data, const struct ButtonEvent* ev);
+
+//callback of an event, ctx when its bit is set in cb_ctx_mask.
+typedef union {
+	BtnCallback    plain;
+	BtnCtxCallback ctx;
+}BtnHandler;
 
 typedef enum {
 	PRESS_DOWN = 0,
@@ -26,10 +53,29 @@ typedef enum {
 	DOUBLE_CLICK,
 	LONG_PRESS_START,
 	LONG_PRESS_HOLD,
+	LONG_PRESS_STAGE,
 	number_of_event,
 	NONE_PRESS
 }PressEvent;
 
+typedef struct {
+	uint32_t presses;
+	uint32_t clicks;
+	uint32_t double_clicks;
+	uint32_t long_presses;
+	uint32_t bounces;	//level changes rejected by the debounce
+	uint16_t press_hist[STATS_PRESS_BUCKETS];
+	uint16_t bounce_hist[STATS_BOUNCE_BUCKETS];
+}ButtonStats;
+
+typedef struct {
+	uint32_t count;
+	uint32_t sum;
+	uint32_t min;
+	uint32_t max;
+	uint16_t hist[LATENCY_BUCKETS];
+}ButtonLatency;
+
 typedef struct Button {
 	uint16_t ticks;
 	uint8_t  repeat : 4;
@@ -38,22 +84,88 @@ typedef struct Button {
 	uint8_t  debounce_cnt : 3;
 	uint8_t  active_level : 1;
 	uint8_t  button_level : 1;
-	uint8_t  button_id;
-	uint8_t  (*hal_button_Level)(uint8_t button_id_);
-	BtnCallback  cb[number_of_event];
+	uint16_t button_id;
+	uint16_t queue_pos;	//event queue position of the last record queued
+	uint8_t  long_stage_num;
+	uint8_t  long_stage;
+	const uint16_t* long_stage_ticks;
+	uint32_t press_time;
+	uint16_t cb_ctx_mask;
+	void*    user_data;	//one per button, passed to all its ctx callbacks
+	//takes the 16 bit id, a uint8_t (*)(uint8_t) reader from before must change its parameter
+	uint8_t  (*hal_button_Level)(uint16_t button_id_);
+	BtnHandler cb[number_of_event];
+	struct ButtonWaiter* waiters;
+#if BUTTON_TELEMETRY
+	ButtonStats stats;
+#endif
+#if BUTTON_LATENCY
+	uint32_t edge_time;
+	uint8_t  edge_marked;
+#endif
 	struct Button* next;
+	struct Button** pprev;
+	struct Button* id_next;
 }Button;
 
+typedef struct ButtonEvent {
+	uint32_t timestamp;	//engine clock in ticks when the event happened
+	uint16_t duration;	//ticks since the last press down, press duration on PRESS_UP
+	uint16_t button_id;
+	uint8_t  event : 4;
+	uint8_t  repeat : 4;
+	uint8_t  stage;	//long press stage reached during this press, 0: none yet
+#if BUTTON_LATENCY
+	uint32_t edge_time;	//latency clock at the raw edge
+#endif
+}ButtonEvent;
+
+//one-shot wait for any event of event_mask (bit n: PressEvent n) on a button.
+typedef struct ButtonWaiter {
+	uint16_t event_mask;
+	void (*wake)(struct ButtonWaiter* waiter, const ButtonEvent* ev);
+	struct ButtonWaiter* next;
+}ButtonWaiter;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void button_init(struct Button* handle, uint8_t(*pin_level)(uint8_t), uint8_t active_level, uint8_t button_id);
+int  button_init(struct Button* handle, uint8_t(*pin_level)(uint16_t), uint8_t active_level, uint16_t button_id);
 void button_attach(struct Button* handle, PressEvent event, BtnCallback cb);
+void button_attach_ctx(struct Button* handle, PressEvent event, BtnCtxCallback cb, void* user_data);
 PressEvent get_button_event(struct Button* handle);
+int  button_set_long_stages(struct Button* handle, const uint16_t* stage_ticks, uint8_t stage_num);
+uint8_t get_button_long_stage(struct Button* handle);
+#if BUTTON_TELEMETRY
+void button_get_stats(struct Button* handle, ButtonStats* stats);
+void button_clear_stats(struct Button* handle);
+#endif
+#if BUTTON_LATENCY
+void button_set_latency_clock(uint32_t (*clock)(void));
+void button_mark_edge(struct Button* handle);
+void button_get_latency(PressEvent event, ButtonLatency* stats);
+void button_clear_latency(void);
+#endif
+void button_wait(struct Button* handle, ButtonWaiter* waiter);
+int  button_wait_cancel(struct Button* handle, ButtonWaiter* waiter);
 int  button_start(struct Button* handle);
 void button_stop(struct Button* handle);
+struct Button* button_find(uint16_t button_id);
 void button_ticks(void);
+int  button_is_idle(void);
+void button_resume(void);
+uint32_t button_get_clock(void);
+void button_clock_advance(uint32_t ticks);
+const ButtonEvent* button_current_event(void);
+#if BUTTON_DEFERRED_CB
+int  button_dispatch_pending(void);
+void button_dispatch(void);
+uint32_t button_dispatch_dropped(void);
+#endif
+uint16_t button_poll_events(ButtonEvent* buf, uint16_t n, uint32_t* changed_mask);
+void button_set_backpressure(uint8_t on);
+uint32_t button_events_dropped(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2016 Zibin Zheng <znbin@qq.com>
+ * All rights reserved
+ */
+
+/*
+ * C++17 header only front end of the MultiButton state machine.
+ *
+ * Port, pin, active level and timing are template parameters, so every
+ * button is specialized at compile time: the GPIO read is an inlined
+ * GPIOx->IDR access and events are delivered to a handler object whose
+ * call operator is inlined too. No function pointer, no runtime config.
+ *
+ *   using Btn1 = multibutton::Button<GPIOD_BASE, GPIO_Pin_3, 0>;
+ *   multibutton::ButtonSet<Btn1, Btn2> buttons;
+ *
+ *   struct Handler {
+ *       template<typename Btn> void operator()(const Btn&, PressEvent ev) { ... }
+ *   };
+ *
+ *   void SysTick_Handler(void) { buttons.ticks(Handler{}); }
+ *
+ * Events, their order and the long press stages follow button_handler()
+ * in multi_button.c; Utilities/HostTest/test_button_cpp.cpp runs both
+ * engines on the same pin traces and compares every event. The services
+ * around the C state machine are not part of this front end: no event
+ * records or queue, deferred callbacks, waiters, telemetry or latency.
+ */
+
+#ifndef _MULTI_BUTTON_HPP_
+#define _MULTI_BUTTON_HPP_
+
+#include <stdint.h>
+#include <tuple>
+#include "wb32l003.h"
+#include "multi_button.h"
+
+//Port base to pointer, host builds map it to the emulated GPIO block.
+#ifndef MULTIBUTTON_GPIO_PORT
+#define MULTIBUTTON_GPIO_PORT(base) reinterpret_cast<GPIO_TypeDef*>(base)
+#endif
+
+namespace multibutton {
+
+//Timing in ticks, same defaults as the C engine.
+template<uint8_t Debounce = DEBOUNCE_TICKS, uint16_t Short = SHORT_TICKS, uint16_t Long = LONG_TICKS>
+struct Timing {
+	static constexpr uint8_t  debounce_ticks = Debounce;
+	static constexpr uint16_t short_ticks    = Short;
+	static constexpr uint16_t long_ticks     = Long;
+
+	static_assert(Debounce <= 7, "debounce ticks MAX 7");
+	static_assert(Short < Long, "short ticks must be below long ticks");
+};
+
+//Long press stage thresholds in ticks from the press down, ascending.
+template<uint16_t... Ticks>
+struct LongStages {
+	static constexpr uint8_t  num = sizeof...(Ticks);
+	static constexpr uint16_t ticks[num + 1] = { Ticks..., 0 };
+
+	static constexpr bool ascending()
+	{
+		for(uint8_t i = 1; i < num; i++) {
+			if(ticks[i] <= ticks[i - 1]) return false;
+		}
+		return true;
+	}
+
+	static_assert(num <= LONG_STAGE_MAX, "too many long press stages");
+	static_assert(ascending(), "long press stages must be ascending");
+};
+
+template<uint32_t PortBase, uint16_t Pin, uint8_t ActiveLevel, typename Time = Timing<>, typename Stages = LongStages<> >
+class Button {
+public:
+	static constexpr uint32_t port_base    = PortBase;
+	static constexpr uint16_t pin          = Pin;
+	static constexpr uint8_t  active_level = ActiveLevel;
+
+	static_assert(Pin != 0 && (Pin & (Pin - 1)) == 0, "one pin per button");
+	static_assert(ActiveLevel <= 1, "active level is 0 or 1");
+
+	static inline uint8_t read_level()
+	{
+		return (MULTIBUTTON_GPIO_PORT(PortBase)->IDR & Pin) ? 1 : 0;
+	}
+
+	PressEvent event() const { return static_cast<PressEvent>(event_); }
+	uint8_t repeat() const { return repeat_; }
+	uint8_t long_stage() const { return long_stage_; }
+
+	/**
+	  * @brief  Button driver core function, same state machine as button_handler().
+	  * @param  h: handler object, called as h(*this, event).
+	  * @retval None
+	  */
+	template<typename Handler>
+	inline void ticks(Handler&& h)
+	{
+		uint8_t read_gpio_level = read_level();
+
+		//ticks counter working..
+		if(state_ > 0) ticks_++;
+
+		/*------------button debounce handle---------------*/
+		if(read_gpio_level != button_level_) {
+			if(++debounce_cnt_ >= Time::debounce_ticks) {
+				button_level_ = read_gpio_level;
+				debounce_cnt_ = 0;
+			}
+		} else {
+			debounce_cnt_ = 0;
+		}
+
+		/*-----------------State machine-------------------*/
+		switch(state_) {
+		case 0:
+			if(button_level_ == ActiveLevel) {
+				repeat_ = 1;
+				emit(h, PRESS_DOWN);
+				ticks_ = 0;
+				long_stage_ = 0;
+				state_ = 1;
+			} else {
+				event_ = NONE_PRESS;
+			}
+			break;
+
+		case 1:
+			if(button_level_ != ActiveLevel) {
+				emit(h, PRESS_UP);
+				ticks_ = 0;
+				state_ = 2;
+			} else {
+				if(ticks_ > Time::long_ticks) {
+					emit(h, LONG_PRESS_START);
+					state_ = 5;
+				}
+				long_stage_check(h);
+			}
+			break;
+
+		case 2:
+			if(button_level_ == ActiveLevel) {
+				if(repeat_ != repeat_max) {
+					repeat_++;
+				}
+				long_stage_ = 0;
+				emit(h, PRESS_DOWN);
+				notify(h, PRESS_REPEAT);	//event() stays PRESS_DOWN, as get_button_event()
+				ticks_ = 0;
+				state_ = 3;
+			} else if(ticks_ > Time::short_ticks) {
+				if(repeat_ == 1) {
+					emit(h, SINGLE_CLICK);
+				} else if(repeat_ == 2) {
+					emit(h, DOUBLE_CLICK);
+				}
+				state_ = 0;
+			}
+			break;
+
+		case 3:
+			if(button_level_ != ActiveLevel) {
+				emit(h, PRESS_UP);
+				if(ticks_ < Time::short_ticks) {
+					ticks_ = 0;
+					state_ = 2;
+				} else {
+					state_ = 0;
+				}
+			} else {
+				if(ticks_ > Time::short_ticks) {
+					state_ = 1;
+				}
+				long_stage_check(h);
+			}
+			break;
+
+		case 5:
+			if(button_level_ == ActiveLevel) {
+				emit(h, LONG_PRESS_HOLD);
+				long_stage_check(h);
+			} else {
+				emit(h, PRESS_UP);
+				state_ = 0;
+			}
+			break;
+
+		default:
+			state_ = 0;
+			break;
+		}
+	}
+
+private:
+	static constexpr uint8_t repeat_max = 15;
+
+	//deliver an event without recording it in event()
+	template<typename Handler>
+	inline void notify(Handler&& h, PressEvent ev)
+	{
+		h(*this, ev);
+	}
+
+	template<typename Handler>
+	inline void emit(Handler&& h, PressEvent ev)
+	{
+		event_ = static_cast<uint8_t>(ev);
+		notify(h, ev);
+	}
+
+	template<typename Handler>
+	inline void long_stage_check(Handler&& h)
+	{
+		if(long_stage_ < Stages::num && ticks_ >= Stages::ticks[long_stage_]) {
+			long_stage_++;
+			emit(h, LONG_PRESS_STAGE);
+		}
+	}
+
+	uint16_t ticks_        = 0;
+	uint8_t  repeat_       = 0;
+	uint8_t  event_        = NONE_PRESS;
+	uint8_t  state_        = 0;
+	uint8_t  debounce_cnt_ = 0;
+	uint8_t  button_level_ = !ActiveLevel;
+	uint8_t  long_stage_   = 0;
+};
+
+//A fixed set of buttons ticked back to back, fully unrolled.
+template<typename... Buttons>
+class ButtonSet {
+public:
+	static constexpr size_t size = sizeof...(Buttons);
+
+	template<size_t N>
+	auto& get() { return std::get<N>(buttons_); }
+
+	template<typename Handler>
+	inline void ticks(Handler&& h)
+	{
+		std::apply([&h](auto&... btn) { (btn.ticks(h), ...); }, buttons_);
+	}
+
+private:
+	std::tuple<Buttons...> buttons_;
+};
+
+} // namespace multibutton
+
+#endif
@@ -10,6 +10,8 @@
 
 #include <stdio.h>
 #include "wb32l003.h"
+#include "bsp_lpuart1.h"
+#include "bsp_uart_rx.h"
 
 
 #pragma import(__use_no_semihosting_swi)
@@ -21,23 +23,18 @@ FILE __stdin;
 
 int fputc(int ch, FILE *f) {
 
-  LPUART->SCON |= LPUART_SCON_TIEN;
-  LPUART->SBUF = (ch & 0xFF);
-  while (!(LPUART->INTSR & LPUART_INTSR_TI));
-  LPUART->INTCLR |= LPUART_INTCLR_TICLR_Msk;
-  LPUART->SCON &= (~LPUART_SCON_TIEN);
+  print_putc(ch & 0xFF);
 
   return ch;
 }
 
 int fgetc(FILE *f) {
-  uint8_t ch;
+  int ch;
 
-  LPUART->SCON |= LPUART_SCON_RIEN;
-  while (!(LPUART->INTSR & LPUART_INTSR_RI));
-  ch = (LPUART->SBUF & 0xFF);
-  LPUART->INTCLR |= LPUART_INTCLR_RICLR_Msk;
-  LPUART->SCON &= (~LPUART_SCON_RIEN);
+  /* interrupt fed ring, wait in low power until a byte lands */
+  UartRx_Init(UART_RX_LPUART);
+  while ((ch = UartRx_Getc(UART_RX_LPUART)) < 0)
+    __WFI();
 
   return ch;
 }
@@ -0,0 +1,115 @@
+#include "binlog.h"
+#include "bsp_lpuart1.h"
+#include "wb32l003.h"
+#include "wb32l003_flash.h"
+
+/* RO data, the format strings included, lies in the flash at 0 */
+#if FLASH_SIZE_64K > BINLOG_WINDOW
+#error "binlog: the flash is larger than the 16 bit format address window"
+#endif
+
+#define RING_MASK               (BINLOG_RING_WORDS - 1)
+#define RECORD_WORDS(header)    (1 + (((header) >> 16) & 0xF))
+
+static uint32_t ring[BINLOG_RING_WORDS];
+static volatile uint16_t ring_head = 0;
+static volatile uint16_t ring_tail = 0;
+static volatile uint32_t dropped = 0;
+static uint32_t dropped_sent = 0;
+
+/**
+  * @name   binlog_write
+  * @brief  Store one record, called through the BLOGn macros, callable from
+  *         ISRs. The mask only covers the few word stores, the M0+ has no
+  *         exclusive access instructions.
+  * @param  header: BINLOG_HEADER(n).
+  * @param  a0..a3: arguments, the first n are stored.
+  * @retval None
+  */
+void binlog_write(uint32_t header, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t words = RECORD_WORDS(header);
+    uint16_t head;
+
+    __disable_irq();
+    head = ring_head;
+    if (((ring_tail - head - 1) & RING_MASK) < words)
+    {
+        dropped++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    ring[head] = header;
+    switch (words)
+    {
+    case 5: ring[(head + 4) & RING_MASK] = a3;  /* fall through */
+    case 4: ring[(head + 3) & RING_MASK] = a2;  /* fall through */
+    case 3: ring[(head + 2) & RING_MASK] = a1;  /* fall through */
+    case 2: ring[(head + 1) & RING_MASK] = a0;  /* fall through */
+    default: break;
+    }
+    ring_head = (head + words) & RING_MASK;
+    __set_PRIMASK(primask);
+}
+
+static void send_words(const uint32_t* words, uint16_t count)
+{
+    uint8_t buf[4];
+
+    while (count--)
+    {
+        buf[0] = (uint8_t)*words;
+        buf[1] = (uint8_t)(*words >> 8);
+        buf[2] = (uint8_t)(*words >> 16);
+        buf[3] = (uint8_t)(*words >> 24);
+        print_write(buf, 4);
+        words++;
+    }
+}
+
+/**
+  * @name   binlog_drain
+  * @brief  Move whole records to the LPUART TX ring while they fit,
+  *         call it from the main loop or a low priority task.
+  * @param  None
+  * @retval None
+  */
+void binlog_drain(void)
+{
+    uint32_t record[5];
+
+    if (dropped != dropped_sent && print_free() >= 8)
+    {
+        record[0] = ((uint32_t)BINLOG_SYNC << 24) | (1UL << 16) | BINLOG_DROPPED;
+        record[1] = dropped - dropped_sent;
+        dropped_sent += record[1];
+        send_words(record, 2);
+    }
+
+    while (ring_tail != ring_head)
+    {
+        uint16_t tail = ring_tail;
+        uint16_t words = RECORD_WORDS(ring[tail]);
+        uint16_t i;
+
+        if (print_free() < words * 4)
+            break;
+        for (i = 0; i < words; i++)
+            record[i] = ring[(tail + i) & RING_MASK];
+        send_words(record, words);
+        ring_tail = (tail + words) & RING_MASK;
+    }
+}
+
+/**
+  * @name   binlog_dropped
+  * @brief  Records dropped on a full ring since power on.
+  * @param  None
+  * @retval count.
+  */
+uint32_t binlog_dropped(void)
+{
+    return dropped;
+}
@@ -0,0 +1,48 @@
+#ifndef __BINLOG_H
+#define __BINLOG_H
+#include <stdint.h>
+
+/*
+ * Binary logger with deferred formatting. A log call stores the address
+ * of its format string and up to 4 raw 32 bit arguments in a RAM ring,
+ * binlog_drain() ships the words over LPUART later and
+ * Utilities/HostTools/binlog_decode.c rebuilds the text from the ELF.
+ *
+ * Record, little endian words:
+ *   u32 BINLOG_SYNC << 24 | nargs << 16 | format string address & 0xFFFF
+ *   u32 args[nargs]
+ * Only integer conversions (%d %i %u %x %X %o %c %p) can be decoded.
+ *
+ * Format strings sit in section .binlog_fmt, the target never reads them
+ * but they stay in flash: the project has no scatter file, armlink puts
+ * the section in ER_IROM1 with the other RO data. Only the low 16 bits
+ * of an address go on the wire, which holds while the image lies in the
+ * one 64 KB flash window at 0. Offset 0 of that window is the initial
+ * stack pointer of the vector table, never a string, so BINLOG_DROPPED
+ * can use it. binlog.c checks the flash size, binlog_decode refuses an
+ * image whose section leaves the window or starts at offset 0.
+ *
+ *   BLOG2("btn %u event %u\n", btn->button_id, btn->event);
+ */
+
+#define BINLOG_RING_WORDS       64      /* power of 2 */
+#define BINLOG_SYNC             0xB1
+#define BINLOG_DROPPED          0x0000  /* format address of the dropped records marker */
+#define BINLOG_WINDOW           0x10000 /* format addresses are offsets in this window */
+
+#define BINLOG_SITE(fmt) \
+    static const char binlog_fmt[] __attribute__((section(".binlog_fmt"), used)) = fmt
+#define BINLOG_HEADER(n) \
+    (((uint32_t)BINLOG_SYNC << 24) | ((uint32_t)(n) << 16) | ((uint32_t)(uintptr_t)binlog_fmt & (BINLOG_WINDOW - 1)))
+
+#define BLOG0(fmt)              do { BINLOG_SITE(fmt); binlog_write(BINLOG_HEADER(0), 0, 0, 0, 0); } while (0)
+#define BLOG1(fmt, a)           do { BINLOG_SITE(fmt); binlog_write(BINLOG_HEADER(1), (uint32_t)(a), 0, 0, 0); } while (0)
+#define BLOG2(fmt, a, b)        do { BINLOG_SITE(fmt); binlog_write(BINLOG_HEADER(2), (uint32_t)(a), (uint32_t)(b), 0, 0); } while (0)
+#define BLOG3(fmt, a, b, c)     do { BINLOG_SITE(fmt); binlog_write(BINLOG_HEADER(3), (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), 0); } while (0)
+#define BLOG4(fmt, a, b, c, d)  do { BINLOG_SITE(fmt); binlog_write(BINLOG_HEADER(4), (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d)); } while (0)
+
+void binlog_write(uint32_t header, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+void binlog_drain(void);
+uint32_t binlog_dropped(void);
+
+#endif
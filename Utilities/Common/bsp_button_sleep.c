@@ -0,0 +1,240 @@
+#include "bsp_button_sleep.h"
+#include "bsp_button_tick.h"
+#include "bsp_timebase.h"
+#include "soft_timer.h"
+#include "multi_button.h"
+
+static const ButtonWakePin* wake_pins = 0;
+static uint8_t wake_num = 0;
+
+#if !(BUTTON_TICK_LOWPOWER)
+// LSI counts x 1000 slept but not yet handed to the engine clock
+static uint32_t sleep_rem = 0;
+// the same for the timebase and the soft timers, in whole ms
+static uint32_t sleep_ms_rem = 0;
+
+static void ButtonSleep_Disarm(void);
+static void ButtonSleep_ClockStart(uint32_t start);
+static uint64_t ButtonSleep_ClockStop(uint32_t wraps, uint32_t start);
+#endif
+
+/**
+  * @name   ButtonSleep_Init
+  * @brief  Set the button pins waking the core from DEEPSLEEP.
+  * @param  pins: wake pin table, kept by reference.
+  * @param  num: number of pins.
+  * @retval None
+  */
+void ButtonSleep_Init(const ButtonWakePin* pins, uint8_t num)
+{
+    wake_pins = pins;
+    wake_num = num;
+}
+
+/**
+  * @name   ButtonSleep_Enter
+  * @brief  Enter DEEPSLEEP when every button is idle, wake on a press edge.
+  *         LPTIM/AWK tick sources keep scanning in DEEPSLEEP and only need the
+  *         sleep, an armed soft timer keeps the core in SLEEP for its ticks.
+  *         With the other sources the tick stops, the button pins are armed
+  *         as wake source and the sleep clock also wakes at the next soft
+  *         timer deadline. The engine clock, the timebase and the soft timers
+  *         are advanced by the time slept, soft timer ticks taken as 1 ms.
+  * @param  None
+  * @retval 1: slept in DEEPSLEEP. 0: a button or soft timer is busy, slept in SLEEP.
+  */
+int ButtonSleep_Enter(void)
+{
+#if (BUTTON_TICK_LOWPOWER)
+    // the timer ticking the soft timers stops in DEEPSLEEP, the button tick does not
+    __disable_irq();
+    if(soft_timer_next() != 0xFFFFFFFF)
+    {
+        PWR_EnterSLEEPMode(PWR_SLEEPENTRY_WFI);
+        __enable_irq();
+        return 0;
+    }
+    PWR_EnterDEEPSLEEPMode();
+    __enable_irq();
+    return 1;
+#else
+    uint32_t hclken, pclken;
+    uint32_t wraps = 0, start = 0, next, ms;
+    uint64_t total, wake = 0;
+    uint8_t i;
+
+    // a busy button still lets the core SLEEP until the next tick
+    __disable_irq();
+    if(!button_is_idle())
+    {
+        PWR_EnterSLEEPMode(PWR_SLEEPENTRY_WFI);
+        __enable_irq();
+        return 0;
+    }
+
+    // Arm the press edge of every button pin as wake source
+    for(i = 0; i < wake_num; i++)
+    {
+        GPIO_EXTI_ClearIT(wake_pins[i].port, wake_pins[i].pin);
+        GPIO_EXTIConfig(wake_pins[i].port, wake_pins[i].pin, GPIO_EXTI_IT_ENABLE | GPIO_EXTI_TRIGGER_EDGE |
+                        (wake_pins[i].active_level ? GPIO_EXTI_TRIGGER_RISSING : GPIO_EXTI_TRIGGER_FALLING));
+        NVIC_ClearPendingIRQ(wake_pins[i].irqn);
+        NVIC_EnableIRQ(wake_pins[i].irqn);
+    }
+
+    // A press between the idle scan and the arming left no edge: read the pins again
+    for(i = 0; i < wake_num; i++)
+    {
+        if(GPIO_ReadInputDataBit(wake_pins[i].port, wake_pins[i].pin) == wake_pins[i].active_level)
+        {
+            ButtonSleep_Disarm();
+            PWR_EnterSLEEPMode(PWR_SLEEPENTRY_WFI);
+            __enable_irq();
+            return 0;
+        }
+    }
+
+    ButtonTick_Stop();
+
+    // the next soft timer deadline in LSI counts, the first overflow is that far off the last
+    next = soft_timer_next();
+    if(next != 0xFFFFFFFF)
+    {
+        wake = ((uint64_t)(next ? next : 1) * BUTTON_SLEEP_LSI_HZ - sleep_ms_rem + 999) / 1000;
+        start = (0x10000 - (uint32_t)(wake & 0xFFFF)) & 0xFFFF;
+    }
+
+    hclken = RCC->HCLKEN;
+    pclken = RCC->PCLKEN;
+    ButtonSleep_ClockStart(start);
+
+    // IRQs stay masked: a pending edge wakes the core without running a handler,
+    // so does the sleep clock overflow, counted here before sleeping again
+    while(1)
+    {
+        PWR_EnterDEEPSLEEPMode();
+        if(!(LPTIM->INTSR & LPTIM_INTSR_INTF))
+        {
+            break;
+        }
+        LPTIM_ClearITPendingBit();
+        NVIC_ClearPendingIRQ(LPTIM_IRQn);
+        wraps++;
+        if((SCB->ICSR & SCB_ICSR_ISRPENDING_Msk) || (wake && ((uint64_t)wraps << 16) - start >= wake))
+        {
+            break;
+        }
+    }
+    total = ButtonSleep_ClockStop(wraps, start) * 1000;
+
+    // SystemInit() also resets the clock gates, the peripherals keep their configuration
+    SystemInit();
+    SystemCoreClockUpdate();
+    RCC->HCLKEN = hclken;
+    RCC->PCLKEN = pclken;
+
+    ButtonSleep_Disarm();
+
+    // the ticks and ms slept, the remainders carry to the next sleep
+    button_clock_advance((uint32_t)((total + sleep_rem) / (BUTTON_SLEEP_LSI_HZ * TICKS_INTERVAL)));
+    sleep_rem = (uint32_t)((total + sleep_rem) % (BUTTON_SLEEP_LSI_HZ * TICKS_INTERVAL));
+    ms = (uint32_t)((total + sleep_ms_rem) / BUTTON_SLEEP_LSI_HZ);
+    sleep_ms_rem = (uint32_t)((total + sleep_ms_rem) % BUTTON_SLEEP_LSI_HZ);
+    Timebase_Advance(ms);
+
+    button_resume();
+    __enable_irq();
+
+    // soft timers due by the wake expire here, unmasked, before the tick timer is back
+    soft_timer_advance(ms);
+    ButtonTick_Init();
+    return 1;
+#endif
+}
+
+#if !(BUTTON_TICK_LOWPOWER)
+/**
+  * @name   ButtonSleep_Disarm
+  * @brief  Release the wake pins, drop the edges they latched.
+  * @param  None
+  * @retval None
+  */
+static void ButtonSleep_Disarm(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < wake_num; i++)
+    {
+        GPIO_EXTIConfig(wake_pins[i].port, wake_pins[i].pin, GPIO_EXTI_IT_DISABLE);
+        GPIO_EXTI_ClearIT(wake_pins[i].port, wake_pins[i].pin);
+        NVIC_DisableIRQ(wake_pins[i].irqn);
+        NVIC_ClearPendingIRQ(wake_pins[i].irqn);
+    }
+}
+
+/**
+  * @name   ButtonSleep_ClockStart
+  * @brief  Run LPTIM from start on LSI, then overflowing every 0x10000 counts.
+  * @param  start: first count, the first overflow comes 0x10000 - start counts on.
+  * @retval None
+  */
+static void ButtonSleep_ClockStart(uint32_t start)
+{
+    LPTIM_BaseInitTypeDef LPTIM_InitStruct;
+
+    RCC_LSIConfig(BUTTON_SLEEP_LSI_HZ, RCC_LSI_STARTUP_64CYCLE, ENABLE);
+    RCC_APBPeriphClockCmd(RCC_APBPeriph_LPTIM, ENABLE);
+
+    LPTIM_InitStruct.GateEnable = LPTIM_GATE_DISABLE;
+    LPTIM_InitStruct.GateLevel  = LPTIM_GATELEVEL_HIGH;
+    LPTIM_InitStruct.ClkSel     = LPTIM_CLOCK_SOURCE_LSI;
+    LPTIM_InitStruct.TogEnable  = LPTIM_TOG_DISABLE;
+    LPTIM_InitStruct.CntTimSel  = LPTIM_TIMER_SELECT;
+    LPTIM_InitStruct.AutoReload = LPTIM_AUTORELOAD_ENABLE;
+    LPTIM_InitStruct.Period     = 0;
+    LPTIM_BaseInit(&LPTIM_InitStruct);
+    // LPTIM_SetCounter() sets the reload too, the overflows after the first count from 0
+    LPTIM_SetCounter(start);
+    while(LPTIM->CR & LPTIM_CR_WT_FLAG);
+    LPTIM->BGLOAD = 0;
+
+    LPTIM_ClearITPendingBit();
+    LPTIM_ITCmd(ENABLE);
+    NVIC_ClearPendingIRQ(LPTIM_IRQn);
+    NVIC_EnableIRQ(LPTIM_IRQn);
+    LPTIM_TCKCmd(ENABLE);
+    LPTIM_Cmd(ENABLE);
+}
+
+/**
+  * @name   ButtonSleep_ClockStop
+  * @brief  Stop the sleep clock.
+  * @param  wraps: overflows counted while asleep.
+  * @param  start: first count given to ButtonSleep_ClockStart().
+  * @retval LSI counts since ButtonSleep_ClockStart().
+  */
+static uint64_t ButtonSleep_ClockStop(uint32_t wraps, uint32_t start)
+{
+    uint32_t before, cnt;
+
+    // an overflow after the last wake is still flagged, CNTVAL read past it
+    before = LPTIM->INTSR & LPTIM_INTSR_INTF;
+    cnt = LPTIM->CNTVAL & 0xFFFF;
+    if(LPTIM->INTSR & LPTIM_INTSR_INTF)
+    {
+        if(!before)
+        {
+            cnt = LPTIM->CNTVAL & 0xFFFF;
+        }
+        wraps++;
+    }
+
+    LPTIM_Cmd(DISABLE);
+    LPTIM_ITCmd(DISABLE);
+    LPTIM_ClearITPendingBit();
+    NVIC_DisableIRQ(LPTIM_IRQn);
+    NVIC_ClearPendingIRQ(LPTIM_IRQn);
+
+    return ((uint64_t)wraps << 16) + cnt - start;
+}
+#endif
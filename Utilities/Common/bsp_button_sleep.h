@@ -0,0 +1,23 @@
+#ifndef __BSP_BUTTON_SLEEP_H
+#define __BSP_BUTTON_SLEEP_H
+#include "wb32l003.h"
+
+/* Button pin armed as DEEPSLEEP wake source */
+typedef struct {
+    GPIO_TypeDef* port;
+    uint16_t pin;
+    uint8_t active_level;       /* pin level while pressed */
+    IRQn_Type irqn;             /* EXTI interrupt of the port */
+} ButtonWakePin;
+
+/*
+ * Sleep clock for the SysTick/TIMEBASE/SOFTTIMER tick sources, whose
+ * timers stop in DEEPSLEEP: LPTIM free running on LSI, only while asleep.
+ * It also wakes the core at the next soft timer deadline.
+ */
+#define BUTTON_SLEEP_LSI_HZ     LSI_VALUE_32K
+
+void ButtonSleep_Init(const ButtonWakePin* pins, uint8_t num);
+int  ButtonSleep_Enter(void);
+
+#endif
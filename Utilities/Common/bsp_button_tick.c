@@ -0,0 +1,234 @@
+#include "bsp_button_tick.h"
+#include "multi_button.h"
+#if (BUTTON_TICK_SOURCE == BUTTON_TICK_TIMEBASE)
+#include "bsp_timebase.h"
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_SOFTTIMER)
+#include "soft_timer.h"
+#endif
+
+static uint8_t tick_idle = 0;
+
+static void ButtonTick_SetPeriod(uint32_t ms);
+static void ButtonTick_Handler(void);
+
+#if (BUTTON_TICK_SOURCE == BUTTON_TICK_TIMEBASE)
+static int tick_periodic_id = -1;
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_SOFTTIMER)
+static SoftTimer tick_timer;
+#endif
+
+#if (BUTTON_TICK_SOURCE == BUTTON_TICK_LPTIM)
+/* LPTIM counts up from the load value and interrupts on overflow */
+#define TICK_CLK                LSI_VALUE_32K
+#define TICK_COUNTS_MAX         0x10000
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_AWK)
+/* AWK runs on LSI/16, 8 bit counter counts up from the reload value */
+#define TICK_CLK                (LSI_VALUE_32K / 16)
+#define TICK_COUNTS_MAX         0xFF
+#else
+/* whole ms periods */
+#define TICK_CLK                1000
+#define TICK_COUNTS_MAX         0xFFFF
+#endif
+
+/* Tick period in TICK_CLK counts, rounded to the counter */
+#define TICK_COUNTS(ms)         ((((ms) * TICK_CLK + 500) / 1000) > TICK_COUNTS_MAX ? \
+                                 TICK_COUNTS_MAX : (((ms) * TICK_CLK + 500) / 1000))
+
+/*
+ * A period change restarts the period from the tick, so the one that
+ * ended was the one set before it. The remainder in counts x 1000
+ * carries the rounding of the periods to the counter clock.
+ */
+static uint32_t tick_counts = TICK_COUNTS(TICKS_INTERVAL);
+static uint32_t tick_rem = 0;
+
+/**
+  * @name   ButtonTick_Init
+  * @brief  Start the tick source invoking button_ticks() every TICKS_INTERVAL ms.
+  * @param  None
+  * @retval None
+  */
+void ButtonTick_Init(void)
+{
+    tick_idle = 0;
+    tick_counts = TICK_COUNTS(TICKS_INTERVAL);
+    tick_rem = 0;
+
+#if BUTTON_DEFERRED_CB
+    // button callbacks run in PendSV, below every other interrupt
+    NVIC_SetPriority(PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+#endif
+
+#if (BUTTON_TICK_SOURCE == BUTTON_TICK_LPTIM)
+    RCC_LSIConfig(LSI_VALUE_32K, RCC_LSI_STARTUP_64CYCLE, ENABLE);
+    RCC_APBPeriphClockCmd(RCC_APBPeriph_LPTIM, ENABLE);
+
+    LPTIM_BaseInitTypeDef LPTIM_InitStruct;
+    LPTIM_InitStruct.GateEnable = LPTIM_GATE_DISABLE;
+    LPTIM_InitStruct.GateLevel  = LPTIM_GATELEVEL_HIGH;
+    LPTIM_InitStruct.ClkSel     = LPTIM_CLOCK_SOURCE_LSI;
+    LPTIM_InitStruct.TogEnable  = LPTIM_TOG_DISABLE;
+    LPTIM_InitStruct.CntTimSel  = LPTIM_TIMER_SELECT;
+    LPTIM_InitStruct.AutoReload = LPTIM_AUTORELOAD_ENABLE;
+    LPTIM_InitStruct.Period     = 0x10000 - TICK_COUNTS(TICKS_INTERVAL);
+    LPTIM_BaseInit(&LPTIM_InitStruct);
+    LPTIM_SetCounter(LPTIM_InitStruct.Period);
+
+    LPTIM_ClearITPendingBit();
+    LPTIM_ITCmd(ENABLE);
+    NVIC_EnableIRQ(LPTIM_IRQn);
+    LPTIM_TCKCmd(ENABLE);
+    LPTIM_Cmd(ENABLE);
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_AWK)
+    RCC_LSIConfig(LSI_VALUE_32K, RCC_LSI_STARTUP_64CYCLE, ENABLE);
+    RCC_APBPeriphClockCmd(RCC_APBPeriph_AWK, ENABLE);
+
+    AWK_InitTypeDef AWK_InitStruct;
+    AWK_InitStruct.AWK_CLK_SEL   = AWK_CLK_SEL_LSI;
+    AWK_InitStruct.AWK_HSE_PRSC  = 0;
+    AWK_InitStruct.AWK_DIV_SEL   = AWK_CLOCK_DIV_16;
+    AWK_InitStruct.AWK_RLOAD_VAL = 0x100 - TICK_COUNTS(TICKS_INTERVAL);
+    AWK_Init(&AWK_InitStruct);
+
+    NVIC_EnableIRQ(AWK_IRQn);
+    AWK_Cmd(ENABLE);
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_TIMEBASE)
+    // Timebase_Init() is called by the application, the timebase is shared
+    if(tick_periodic_id < 0)
+    {
+        tick_periodic_id = Timebase_AddPeriodic(ButtonTick_Handler, TICKS_INTERVAL);
+    }
+    else
+    {
+        Timebase_SetPeriod(tick_periodic_id, TICKS_INTERVAL);
+    }
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_SOFTTIMER)
+    // soft_timer_ticks() is driven every 1 ms by the application
+    if(tick_timer.cb)
+    {
+        soft_timer_stop(&tick_timer);
+    }
+    soft_timer_init(&tick_timer, ButtonTick_Handler, TICKS_INTERVAL, TICKS_INTERVAL);
+    soft_timer_start(&tick_timer);
+#else
+    // Configure SysTick to run at 200Hz
+    if(SysTick_Config(SystemCoreClock / 1000 * TICKS_INTERVAL))
+    {
+        while(1);
+    }
+#endif
+}
+
+/**
+  * @name   ButtonTick_Stop
+  * @brief  Stop the tick source.
+  * @param  None
+  * @retval None
+  */
+void ButtonTick_Stop(void)
+{
+#if (BUTTON_TICK_SOURCE == BUTTON_TICK_LPTIM)
+    LPTIM_Cmd(DISABLE);
+    NVIC_DisableIRQ(LPTIM_IRQn);
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_AWK)
+    AWK_Cmd(DISABLE);
+    NVIC_DisableIRQ(AWK_IRQn);
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_TIMEBASE)
+    Timebase_SetPeriod(tick_periodic_id, 0);
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_SOFTTIMER)
+    soft_timer_stop(&tick_timer);
+#else
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+#endif
+}
+
+/**
+  * @name   ButtonTick_SetPeriod
+  * @brief  Change the tick period on the fly.
+  * @param  ms: new tick period in ms.
+  * @retval None
+  */
+static void ButtonTick_SetPeriod(uint32_t ms)
+{
+    // the new period runs from now: a press seen on the slow tick is scanned fast at once
+    tick_counts = TICK_COUNTS(ms);
+#if (BUTTON_TICK_SOURCE == BUTTON_TICK_LPTIM)
+    LPTIM_SetCounter(0x10000 - tick_counts);
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_AWK)
+    // RLOAD loads the counter at once
+    AWK->RLOAD = 0x100 - tick_counts;
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_TIMEBASE)
+    Timebase_SetPeriod(tick_periodic_id, ms);
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_SOFTTIMER)
+    soft_timer_stop(&tick_timer);
+    tick_timer.timeout = ms;
+    tick_timer.repeat = ms;
+    soft_timer_start(&tick_timer);
+#else
+    // clearing VAL reloads LOAD on the next clock
+    SysTick->LOAD = SystemCoreClock / 1000 * ms - 1;
+    SysTick->VAL = 0;
+#endif
+}
+
+/**
+  * @name   ButtonTick_Handler
+  * @brief  Scan the buttons, slow down while all of them are idle.
+  * @param  None
+  * @retval None
+  */
+static void ButtonTick_Handler(void)
+{
+    uint32_t ticks;
+
+    // the button ticks the ended period covers, a slow one several
+    tick_rem += tick_counts * 1000;
+    ticks = tick_rem / (TICK_CLK * TICKS_INTERVAL);
+    if(ticks == 0)
+    {
+        // a period rounded below one tick, the scan waits for the next
+        return;
+    }
+    tick_rem -= ticks * (TICK_CLK * TICKS_INTERVAL);
+    button_clock_advance(ticks - 1);
+    button_ticks();
+#if BUTTON_DEFERRED_CB
+    if(button_dispatch_pending())
+    {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    }
+#endif
+
+    if(button_is_idle() != tick_idle)
+    {
+        tick_idle = !tick_idle;
+        ButtonTick_SetPeriod(tick_idle ? TICKS_INTERVAL * BUTTON_TICK_IDLE_DIV : TICKS_INTERVAL);
+    }
+}
+
+#if (BUTTON_TICK_SOURCE == BUTTON_TICK_LPTIM)
+void LPTIM_IRQHandler(void)
+{
+    LPTIM_ClearITPendingBit();
+    ButtonTick_Handler();
+}
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_AWK)
+void AWK_IRQHandler(void)
+{
+    AWK_ClearFlag();
+    ButtonTick_Handler();
+}
+#elif (BUTTON_TICK_SOURCE == BUTTON_TICK_SYSTICK)
+void SysTick_Handler(void)
+{
+    ButtonTick_Handler();
+}
+#endif
+
+#if BUTTON_DEFERRED_CB
+void PendSV_Handler(void)
+{
+    button_dispatch();
+}
+#endif
@@ -0,0 +1,27 @@
+#ifndef __BSP_BUTTON_TICK_H
+#define __BSP_BUTTON_TICK_H
+#include "wb32l003.h"
+
+/* Tick source driving button_ticks() */
+#define BUTTON_TICK_SYSTICK     0   /* SysTick, stops in DEEPSLEEP */
+#define BUTTON_TICK_LPTIM       1   /* LPTIM on LSI, runs in DEEPSLEEP */
+#define BUTTON_TICK_AWK         2   /* AWK auto-wakeup timer on LSI, runs in DEEPSLEEP */
+#define BUTTON_TICK_TIMEBASE    3   /* periodic callback of bsp_timebase, stops in DEEPSLEEP */
+#define BUTTON_TICK_SOFTTIMER   4   /* periodic soft_timer, soft_timer_ticks() driven every 1 ms */
+
+#ifndef BUTTON_TICK_SOURCE
+#define BUTTON_TICK_SOURCE      BUTTON_TICK_SOFTTIMER
+#endif
+
+#define BUTTON_TICK_LOWPOWER    ((BUTTON_TICK_SOURCE == BUTTON_TICK_LPTIM) || \
+                                 (BUTTON_TICK_SOURCE == BUTTON_TICK_AWK))
+
+/* While all buttons are idle, scan every BUTTON_TICK_IDLE_DIV ticks */
+#ifndef BUTTON_TICK_IDLE_DIV
+#define BUTTON_TICK_IDLE_DIV    10
+#endif
+
+void ButtonTick_Init(void);
+void ButtonTick_Stop(void);
+
+#endif
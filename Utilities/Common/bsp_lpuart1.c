@@ -1,6 +1,52 @@
 #include "bsp_lpuart1.h"
 #include "wb32l003.h"
 
+/* Bytes queued for the interrupt driven transmitter */
+static uint8_t tx_ring[PRINT_TX_RING_SIZE];
+static volatile uint16_t tx_head = 0;
+static volatile uint16_t tx_tail = 0;
+static volatile uint8_t tx_busy = 0;    /* a byte is in the shifter */
+static volatile uint32_t tx_dropped = 0;
+static void (*rx_hook)(uint8_t ch) = 0;
+
+/* Next byte to the shifter once TI is set, IRQs masked or in the ISR */
+static void tx_service(void)
+{
+    if (LPUART->INTSR & LPUART_INTSR_TI)
+    {
+        LPUART->INTCLR |= LPUART_INTCLR_TICLR_Msk;
+        tx_busy = 0;
+    }
+    if (!tx_busy && tx_tail != tx_head)
+    {
+        LPUART->SBUF = tx_ring[tx_tail];
+        tx_tail = (tx_tail + 1) & (PRINT_TX_RING_SIZE - 1);
+        tx_busy = 1;
+    }
+}
+
+#if PRINT_OVERFLOW == PRINT_OVERFLOW_BLOCK
+/* Wait for a free slot, the ring index to leave is full */
+static void tx_wait(uint32_t primask, uint16_t full)
+{
+    if (primask || (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk))
+    {
+        /* masked or in an ISR the LPUART IRQ may not preempt: poll the shifter */
+        while (tx_tail == full)
+            tx_service();
+    }
+    else
+    {
+        /* unmask between checks, the TX interrupt makes the room */
+        while (tx_tail == full)
+        {
+            __set_PRIMASK(primask);
+            __disable_irq();
+        }
+    }
+}
+#endif
+
 /**
   * @name   print_init
   * @brief  Initializes the LPUART peripheral.
@@ -28,4 +74,130 @@ void print_init(uint32_t baud)
     LPUART_StructInit(&Print_InitStruct);
     LPUART_Init(LPUART, &Print_InitStruct);
     LPUART_Cmd(LPUART, ENABLE);
+
+    /* TI raises the interrupt that feeds the next byte */
+    tx_head = tx_tail = 0;
+    tx_busy = 0;
+    LPUART->SCON |= LPUART_SCON_TIEN;
+    NVIC_ClearPendingIRQ(LPUART_IRQn);
+    NVIC_EnableIRQ(LPUART_IRQn);
+}
+
+/**
+  * @name   print_putc
+  * @brief  Queue one byte, returns at once unless the ring is full and
+  *         PRINT_OVERFLOW is PRINT_OVERFLOW_BLOCK. Callable from ISRs, a
+  *         blocked ISR or masked caller sends by polling the shifter.
+  * @param  ch: byte to send.
+  * @retval 0: queued. -1: dropped.
+  */
+int print_putc(uint8_t ch)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t next;
+
+    __disable_irq();
+    next = (tx_head + 1) & (PRINT_TX_RING_SIZE - 1);
+#if PRINT_OVERFLOW == PRINT_OVERFLOW_BLOCK
+    if (next == tx_tail)
+        tx_wait(primask, next);
+#else
+    if (next == tx_tail)
+    {
+        tx_dropped++;
+        __set_PRIMASK(primask);
+        return -1;
+    }
+#endif
+    tx_ring[tx_head] = ch;
+    tx_head = next;
+    if (!tx_busy)
+        tx_service();
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+/**
+  * @name   print_write
+  * @brief  Queue a binary buffer for LPUART, same overflow policy as print_putc.
+  * @param  buf: data to send.
+  * @param  len: number of bytes.
+  * @retval None
+  */
+void print_write(const uint8_t *buf, uint16_t len)
+{
+    while (len--)
+        print_putc(*buf++);
+}
+
+/**
+  * @name   print_flush
+  * @brief  Wait until every queued byte has left the shifter.
+  * @param  None
+  * @retval None
+  */
+void print_flush(void)
+{
+    uint32_t primask;
+
+    do
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        tx_service();
+        __set_PRIMASK(primask);
+    } while (tx_busy || tx_tail != tx_head);
+}
+
+/**
+  * @name   print_free
+  * @brief  Room left in the TX ring, a write of this size never drops or blocks.
+  * @param  None
+  * @retval bytes.
+  */
+uint16_t print_free(void)
+{
+    return (tx_tail - tx_head - 1) & (PRINT_TX_RING_SIZE - 1);
+}
+
+/**
+  * @name   print_dropped
+  * @brief  Bytes dropped on a full ring since power on.
+  * @param  None
+  * @retval count.
+  */
+uint32_t print_dropped(void)
+{
+    return tx_dropped;
+}
+
+/**
+  * @name   print_set_rx
+  * @brief  Enable the RX interrupt, every received byte goes to rx in the ISR.
+  * @param  rx: byte handler, NULL disables the RX interrupt.
+  * @retval None
+  */
+void print_set_rx(void (*rx)(uint8_t ch))
+{
+    rx_hook = rx;
+    if (rx)
+    {
+        LPUART->INTCLR |= LPUART_INTCLR_RICLR_Msk;
+        LPUART->SCON |= LPUART_SCON_RIEN;
+    }
+    else
+    {
+        LPUART->SCON &= (~LPUART_SCON_RIEN);
+    }
+}
+
+void LPUART_IRQHandler(void)
+{
+    if ((LPUART->INTSR & LPUART_INTSR_RI) && rx_hook)
+    {
+        uint8_t ch = LPUART->SBUF & 0xFF;
+        LPUART->INTCLR |= LPUART_INTCLR_RICLR_Msk;
+        rx_hook(ch);
+    }
+    tx_service();
 }
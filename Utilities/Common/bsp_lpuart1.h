@@ -2,6 +2,22 @@
 #define __BSP_LPUART1_H
 #include "wb32l003.h"
 
+/* TX ring, size must be a power of 2 */
+#define PRINT_TX_RING_SIZE      128
+
+/* What print_putc() does when the ring is full */
+#define PRINT_OVERFLOW_DROP     0   /* drop the byte and count it */
+#define PRINT_OVERFLOW_BLOCK    1   /* wait for room, polling the shifter in ISRs */
+#ifndef PRINT_OVERFLOW
+#define PRINT_OVERFLOW          PRINT_OVERFLOW_BLOCK
+#endif
+
 void print_init(uint32_t baud);
+int  print_putc(uint8_t ch);
+void print_write(const uint8_t *buf, uint16_t len);
+void print_flush(void);
+uint16_t print_free(void);
+uint32_t print_dropped(void);
+void print_set_rx(void (*rx)(uint8_t ch));
 
 #endif
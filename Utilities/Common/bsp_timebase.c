@@ -0,0 +1,209 @@
+#include "bsp_timebase.h"
+
+typedef struct {
+    TimebaseCallback cb;
+    uint16_t period;
+    uint16_t count;
+} TimebasePeriodic;
+
+static volatile uint32_t timebase_ms = 0;
+static uint32_t timebase_counts_per_ms = 0;
+static uint32_t timebase_counts_per_us = 0;
+static TimebasePeriodic timebase_periodic[TIMEBASE_PERIODIC_MAX];
+
+/**
+  * @name   Timebase_Init
+  * @brief  Start the free running 1 ms timebase on TIMEBASE_TIM.
+  * @param  None
+  * @retval None
+  */
+void Timebase_Init(void)
+{
+    RCC_ClocksTypeDef RCC_Clocks;
+    BaseTim_InitTypeDef BaseTim_InitStruct;
+
+    RCC_GetClocksFreq(&RCC_Clocks);
+    timebase_counts_per_ms = RCC_Clocks.APBCLK_Frequency / 1000;
+    timebase_counts_per_us = RCC_Clocks.APBCLK_Frequency / 1000000;
+
+    RCC_APBPeriphClockCmd(RCC_APBPeriph_BASETIM, ENABLE);
+
+    /* 16 bit up counter, reloads on overflow so the period is 0x10000 - BGLOAD */
+    BaseTim_InitStruct.BaseTim_Gate         = BaseTim_Gate_Disable;
+    BaseTim_InitStruct.BaseTim_GatePolarity = BaseTim_GatePolarity_High;
+    BaseTim_InitStruct.BaseTim_Tog          = BaseTim_Tog_Disable;
+    BaseTim_InitStruct.BaseTim_Function     = BaseTim_Function_Timer;
+    BaseTim_InitStruct.BaseTim_AutoReload   = BaseTim_AutoReload_Enable;
+    BaseTim_InitStruct.BaseTim_CountLevel   = BaseTim_CountLevel_16BIT;
+    BaseTim_InitStruct.BaseTim_CountMode    = BaseTim_CountMode_Repeat;
+    BaseTim_InitStruct.BaseTim_Prescaler    = BaseTim_Prescaler_DIV1;
+    BaseTim_InitStruct.BaseTim_BGLoad       = 0x10000 - timebase_counts_per_ms;
+    BaseTim_Init(TIMEBASE_TIM, &BaseTim_InitStruct);
+    BaseTim_SetLoad(TIMEBASE_TIM, 0x10000 - timebase_counts_per_ms);
+
+    BaseTim_ClearFlag(TIMEBASE_TIM);
+    BaseTim_ITConfig(TIMEBASE_TIM, ENABLE);
+    NVIC_EnableIRQ(TIMEBASE_IRQn);
+    BaseTim_Cmd(TIMEBASE_TIM, ENABLE);
+}
+
+/**
+  * @name   Timebase_GetMs
+  * @brief  Milliseconds since Timebase_Init().
+  * @param  None
+  * @retval ms timestamp, wraps after 2^32 ms.
+  */
+uint32_t Timebase_GetMs(void)
+{
+    return timebase_ms;
+}
+
+/**
+  * @name   Timebase_GetUs
+  * @brief  Microseconds since Timebase_Init(), callable with IRQs masked.
+  * @param  None
+  * @retval us timestamp, wraps after 2^32 us.
+  */
+uint32_t Timebase_GetUs(void)
+{
+    uint32_t ms, cnt;
+
+    do {
+        ms  = timebase_ms;
+        cnt = TIMEBASE_TIM->CNT & 0xFFFF;
+    } while (ms != timebase_ms);
+
+    /* overflow not served yet: IRQs masked or counter just wrapped */
+    if (TIMEBASE_TIM->RAWINTSR & 0x01)
+    {
+        cnt = TIMEBASE_TIM->CNT & 0xFFFF;
+        ms++;
+    }
+
+    cnt -= 0x10000 - timebase_counts_per_ms;
+    return ms * 1000 + cnt / timebase_counts_per_us;
+}
+
+/**
+  * @name   Timebase_Advance
+  * @brief  Milliseconds missed while the timer was stopped, e.g. in DEEPSLEEP.
+  *         The periodic callbacks do not run for them, their counts resume.
+  * @param  ms: milliseconds missed.
+  * @retval None
+  */
+void Timebase_Advance(uint32_t ms)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    timebase_ms += ms;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @name   Timebase_DelayUs
+  * @brief  Busy wait without touching the timer configuration.
+  *         Counts the counter steps itself, so it also runs with IRQs masked
+  *         and inside the timebase interrupt, where timebase_ms stands still.
+  * @param  Us: Number of Us to delay.
+  * @retval None
+  */
+void Timebase_DelayUs(uint32_t Us)
+{
+    uint32_t reload = 0x10000 - timebase_counts_per_ms;
+    uint32_t last, cnt;
+    uint64_t elapsed = 0;
+    uint64_t counts = (uint64_t)Us * timebase_counts_per_us;
+
+    // the counter runs from reload to 0xFFFF, a poll sees every 1 ms period
+    last = (TIMEBASE_TIM->CNT & 0xFFFF) - reload;
+    while (elapsed < counts)
+    {
+        cnt = (TIMEBASE_TIM->CNT & 0xFFFF) - reload;
+        elapsed += (cnt >= last) ? cnt - last : cnt + timebase_counts_per_ms - last;
+        last = cnt;
+    }
+}
+
+/**
+  * @name   Timebase_DelayMs
+  * @brief  Busy wait without touching the timer configuration.
+  * @param  Ms: Number of Ms to delay.
+  * @retval None
+  */
+void Timebase_DelayMs(uint32_t Ms)
+{
+    while (Ms--)
+        Timebase_DelayUs(1000);
+}
+
+/**
+  * @name   Timebase_AddPeriodic
+  * @brief  Call cb from the timebase interrupt every period_ms.
+  * @param  cb: callback function.
+  * @param  period_ms: callback period in ms.
+  * @retval periodic id, -1: table full.
+  */
+int Timebase_AddPeriodic(TimebaseCallback cb, uint16_t period_ms)
+{
+    int i;
+
+    for (i = 0; i < TIMEBASE_PERIODIC_MAX; i++)
+    {
+        if (timebase_periodic[i].cb == 0)
+        {
+            timebase_periodic[i].period = period_ms;
+            timebase_periodic[i].count = 0;
+            timebase_periodic[i].cb = cb;
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+  * @name   Timebase_SetPeriod
+  * @brief  Change the period of a periodic callback, 0 pauses it.
+  * @param  id: periodic id from Timebase_AddPeriodic().
+  * @param  period_ms: callback period in ms.
+  * @retval None
+  */
+void Timebase_SetPeriod(int id, uint16_t period_ms)
+{
+    timebase_periodic[id].period = period_ms;
+    timebase_periodic[id].count = 0;
+}
+
+/* Since the timebase owns the delays, SysTick is left to the application */
+void SysTick_DelayNticks(uint32_t Ticks)
+{
+    Timebase_DelayUs(Ticks / (SystemCoreClock / 1000000));
+}
+
+void SysTick_DelayUs(uint32_t Us)
+{
+    Timebase_DelayUs(Us);
+}
+
+void SysTick_DelayMs(uint32_t Ms)
+{
+    Timebase_DelayMs(Ms);
+}
+
+void TIMEBASE_IRQHandler(void)
+{
+    int i;
+
+    BaseTim_ClearFlag(TIMEBASE_TIM);
+    timebase_ms++;
+
+    for (i = 0; i < TIMEBASE_PERIODIC_MAX; i++)
+    {
+        if (timebase_periodic[i].cb && timebase_periodic[i].period &&
+            ++timebase_periodic[i].count >= timebase_periodic[i].period)
+        {
+            timebase_periodic[i].count = 0;
+            timebase_periodic[i].cb();
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef __BSP_TIMEBASE_H
+#define __BSP_TIMEBASE_H
+#include "wb32l003.h"
+
+/* Free running timer owned by the timebase, interrupts every 1 ms */
+#define TIMEBASE_TIM            TIM10
+#define TIMEBASE_IRQn           TIM10_IRQn
+#define TIMEBASE_IRQHandler     TIM10_IRQHandler
+
+/* Maximum number of periodic callbacks */
+#define TIMEBASE_PERIODIC_MAX   4
+
+typedef void (*TimebaseCallback)(void);
+
+void Timebase_Init(void);
+uint32_t Timebase_GetMs(void);
+uint32_t Timebase_GetUs(void);
+void Timebase_Advance(uint32_t ms);
+void Timebase_DelayUs(uint32_t Us);
+void Timebase_DelayMs(uint32_t Ms);
+int  Timebase_AddPeriodic(TimebaseCallback cb, uint16_t period_ms);
+void Timebase_SetPeriod(int id, uint16_t period_ms);
+
+#endif
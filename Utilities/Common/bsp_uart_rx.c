@@ -0,0 +1,220 @@
+#include "bsp_uart_rx.h"
+#include "bsp_lpuart1.h"
+
+typedef struct {
+    uint8_t buf[UART_RX_RING_SIZE];
+    volatile uint16_t head;     /* written by the ISR only */
+    volatile uint16_t tail;     /* written by the reader only */
+    volatile uint32_t overruns;
+    uint8_t enabled;
+    void (*notify)(void* arg);  /* called from the ISR after each byte */
+    void* notify_arg;
+    void (*tx_done)(void* arg); /* called from the ISR on TI, UART1 and UART2 */
+    void* tx_arg;
+} UartRxRing;
+
+static UartRxRing rx_ring[UART_RX_PORTS];
+
+static void ring_push(UartRxRing* ring, uint8_t ch)
+{
+    uint16_t next = (ring->head + 1) & (UART_RX_RING_SIZE - 1);
+
+    if (next == ring->tail)
+    {
+        ring->overruns++;
+        return;
+    }
+    ring->buf[ring->head] = ch;
+    ring->head = next;
+    if (ring->notify)
+        ring->notify(ring->notify_arg);
+}
+
+static void lpuart_rx(uint8_t ch)
+{
+    ring_push(&rx_ring[UART_RX_LPUART], ch);
+}
+
+static void uart_rx_isr(UART_TypeDef* uart, UartRxRing* ring)
+{
+    if (UART_GetFlagStatus(uart, UART_FLAG_RI) != RESET)
+    {
+        uint8_t ch = UART_ReadData(uart);
+        UART_ClearFlag(uart, UART_FLAG_RI);
+        ring_push(ring, ch);
+    }
+    /* TI only interrupts with TIEN set, a sender polling TI keeps it */
+    if ((uart->SCON & UART_SCON_TIEN) && UART_GetFlagStatus(uart, UART_FLAG_TI) != RESET)
+    {
+        UART_ClearFlag(uart, UART_FLAG_TI);
+        if (ring->tx_done)
+            ring->tx_done(ring->tx_arg);
+    }
+}
+
+/**
+  * @name   UartRx_Init
+  * @brief  Feed the port's RX ring from its RI interrupt.
+  * @param  port: UART_RX_LPUART, UART_RX_UART1 or UART_RX_UART2.
+  * @retval None
+  */
+void UartRx_Init(UartRxPort port)
+{
+    UartRxRing* ring = &rx_ring[port];
+
+    if (ring->enabled)
+        return;
+    ring->head = ring->tail = 0;
+    ring->overruns = 0;
+    ring->enabled = 1;
+
+    switch (port)
+    {
+    case UART_RX_LPUART:
+        /* the LPUART IRQ is already enabled by print_init() */
+        print_set_rx(lpuart_rx);
+        break;
+    case UART_RX_UART1:
+        UART_ClearFlag(UART1, UART_FLAG_RI);
+        UART_ITConfig(UART1, UART_IT_RI, ENABLE);
+        NVIC_EnableIRQ(UART1_IRQn);
+        break;
+    case UART_RX_UART2:
+        UART_ClearFlag(UART2, UART_FLAG_RI);
+        UART_ITConfig(UART2, UART_IT_RI, ENABLE);
+        NVIC_EnableIRQ(UART2_IRQn);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+  * @name   UartRx_SetNotify
+  * @brief  Call notify from the RX interrupt after each byte, e.g. to post
+  *         the task draining the ring.
+  * @param  port: the port.
+  * @param  notify: ISR callback, NULL: none.
+  * @param  arg: passed to notify.
+  * @retval None
+  */
+void UartRx_SetNotify(UartRxPort port, void (*notify)(void* arg), void* arg)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    rx_ring[port].notify = notify;
+    rx_ring[port].notify_arg = arg;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @name   UartRx_SetTxDone
+  * @brief  Call tx_done from the port's interrupt when TI sets with TIEN
+  *         on, TI is cleared first. Lets a reply go out byte by byte from
+  *         the interrupt. UART1 and UART2 only, the LPUART TX is print's.
+  * @param  port: UART_RX_UART1 or UART_RX_UART2.
+  * @param  tx_done: ISR callback, NULL: TI is only cleared.
+  * @param  arg: passed to tx_done.
+  * @retval None
+  */
+void UartRx_SetTxDone(UartRxPort port, void (*tx_done)(void* arg), void* arg)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    rx_ring[port].tx_done = tx_done;
+    rx_ring[port].tx_arg = arg;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @name   UartRx_Getc
+  * @brief  Take one byte from the ring, never blocks.
+  * @param  port: the port.
+  * @retval byte, -1 when the ring is empty.
+  */
+int UartRx_Getc(UartRxPort port)
+{
+    UartRxRing* ring = &rx_ring[port];
+    uint8_t ch;
+
+    if (ring->tail == ring->head)
+        return -1;
+    ch = ring->buf[ring->tail];
+    ring->tail = (ring->tail + 1) & (UART_RX_RING_SIZE - 1);
+    return ch;
+}
+
+/**
+  * @name   UartRx_Read
+  * @brief  Take up to len bytes from the ring, never blocks.
+  * @param  port: the port.
+  * @param  buf: destination.
+  * @param  len: size of the destination.
+  * @retval bytes read.
+  */
+uint16_t UartRx_Read(UartRxPort port, uint8_t* buf, uint16_t len)
+{
+    uint16_t count = 0;
+    int ch;
+
+    while (count < len && (ch = UartRx_Getc(port)) >= 0)
+        buf[count++] = (uint8_t)ch;
+    return count;
+}
+
+uint16_t UartRx_Available(UartRxPort port)
+{
+    return (rx_ring[port].head - rx_ring[port].tail) & (UART_RX_RING_SIZE - 1);
+}
+
+/**
+  * @name   UartRx_Poll
+  * @brief  Drain the ring into a COBS decoder, complete frames reach its
+  *         handler from this call. Call it from the main loop or a task.
+  * @param  port: the port.
+  * @param  dec: the decoder struct.
+  * @retval None
+  */
+void UartRx_Poll(UartRxPort port, CobsDecoder* dec)
+{
+    int ch;
+
+    while ((ch = UartRx_Getc(port)) >= 0)
+        cobs_decode_byte(dec, (uint8_t)ch);
+}
+
+uint32_t UartRx_Overruns(UartRxPort port)
+{
+    return rx_ring[port].overruns;
+}
+
+/**
+  * @name   UartRx_IRQHandler
+  * @brief  RI and TI service of UART1 or UART2, for an application that
+  *         defines the port's IRQ handler itself.
+  * @param  port: UART_RX_UART1 or UART_RX_UART2.
+  * @retval None
+  */
+void UartRx_IRQHandler(UartRxPort port)
+{
+    if (port == UART_RX_UART1)
+        uart_rx_isr(UART1, &rx_ring[UART_RX_UART1]);
+    else if (port == UART_RX_UART2)
+        uart_rx_isr(UART2, &rx_ring[UART_RX_UART2]);
+}
+
+#if UART_RX_UART1_IRQ
+void UART1_IRQHandler(void)
+{
+    uart_rx_isr(UART1, &rx_ring[UART_RX_UART1]);
+}
+#endif
+
+#if UART_RX_UART2_IRQ
+void UART2_IRQHandler(void)
+{
+    uart_rx_isr(UART2, &rx_ring[UART_RX_UART2]);
+}
+#endif
@@ -0,0 +1,41 @@
+#ifndef __BSP_UART_RX_H
+#define __BSP_UART_RX_H
+#include "wb32l003.h"
+#include "cobs.h"
+
+/* RX ring per port, size must be a power of 2 */
+#define UART_RX_RING_SIZE       64
+
+/*
+ * UART1_IRQHandler and UART2_IRQHandler are defined here unless set to 0,
+ * then the application's handler calls UartRx_IRQHandler() for the port.
+ */
+#ifndef UART_RX_UART1_IRQ
+#define UART_RX_UART1_IRQ       1
+#endif
+#ifndef UART_RX_UART2_IRQ
+#define UART_RX_UART2_IRQ       1
+#endif
+
+typedef enum {
+    UART_RX_LPUART = 0,         /* shares the LPUART with print, see print_set_rx() */
+    UART_RX_UART1,
+    UART_RX_UART2,
+    UART_RX_PORTS
+} UartRxPort;
+
+/*
+ * The port must be initialized and its RX pin configured by the caller,
+ * UartRx_Init() only hooks the RI interrupt to the ring.
+ */
+void UartRx_Init(UartRxPort port);
+void UartRx_SetNotify(UartRxPort port, void (*notify)(void* arg), void* arg);
+void UartRx_SetTxDone(UartRxPort port, void (*tx_done)(void* arg), void* arg);
+void UartRx_IRQHandler(UartRxPort port);
+int  UartRx_Getc(UartRxPort port);
+uint16_t UartRx_Read(UartRxPort port, uint8_t* buf, uint16_t len);
+uint16_t UartRx_Available(UartRxPort port);
+void UartRx_Poll(UartRxPort port, CobsDecoder* dec);
+uint32_t UartRx_Overruns(UartRxPort port);
+
+#endif
@@ -0,0 +1,83 @@
+#include <stddef.h>
+#include "button_await.h"
+#include "wb32l003.h"
+
+static void button_await_wake(ButtonWaiter* waiter, const ButtonEvent* ev)
+{
+    BtnCoroutine* co = (BtnCoroutine*)waiter;
+
+    soft_timer_stop(&co->timer);
+    co->ev = *ev;
+    sched_post(&co->task);
+}
+
+/* Soft timer expiry, an event delivered from a higher priority tick must not interleave */
+static void button_await_timeout(void)
+{
+    BtnCoroutine* co = (BtnCoroutine*)((char*)soft_timer_current() - offsetof(BtnCoroutine, timer));
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (button_wait_cancel(co->button, &co->waiter) == 0)
+    {
+        co->ev.event = NONE_PRESS;
+        sched_post(&co->task);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @name   button_co_init
+  * @brief  Initializes the coroutine, handler receives the coroutine as arg.
+  * @param  co: the coroutine struct.
+  * @param  handler: coroutine body using BTN_CO_BEGIN/BTN_AWAIT/BTN_CO_END.
+  * @param  prio: scheduler priority.
+  * @retval None
+  */
+void button_co_init(BtnCoroutine* co, SchedHandler handler, uint8_t prio)
+{
+    co->lc = 0;
+    co->button = 0;
+    co->waiter.wake = button_await_wake;
+    co->waiter.next = 0;
+    sched_task_init(&co->task, handler, co, prio);
+    soft_timer_init(&co->timer, button_await_timeout, 0, 0);
+}
+
+/**
+  * @name   button_co_start
+  * @brief  Run the coroutine up to its first await.
+  * @param  co: the coroutine struct.
+  * @retval None
+  */
+void button_co_start(BtnCoroutine* co)
+{
+    sched_post(&co->task);
+}
+
+/**
+  * @name   button_await
+  * @brief  Arm the wait behind BTN_AWAIT, the task is posted on the event or timeout.
+  * @param  co: the coroutine struct.
+  * @param  btn: the button handle struct.
+  * @param  event_mask: BTN_EVENT_MASK() of the awaited events.
+  * @param  timeout: soft timer ticks, 0: wait forever.
+  * @retval None
+  */
+void button_await(BtnCoroutine* co, struct Button* btn, uint16_t event_mask, uint32_t timeout)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    co->button = btn;
+    co->waiter.event_mask = event_mask;
+    button_wait(btn, &co->waiter);
+    if (timeout)
+    {
+        co->timer.timeout = timeout;
+        soft_timer_start(&co->timer);
+    }
+
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,51 @@
+#ifndef __BUTTON_AWAIT_H
+#define __BUTTON_AWAIT_H
+#include "multi_button.h"
+#include "scheduler.h"
+#include "soft_timer.h"
+
+/*
+ * Stackless coroutines for button handlers, run as scheduler tasks.
+ * Locals do not survive an await, keep state in the coroutine struct.
+ *
+ *   void Combo_Task(void* arg)
+ *   {
+ *       BtnCoroutine* co = arg;
+ *       BTN_CO_BEGIN(co);
+ *       while(1) {
+ *           BTN_AWAIT(co, &btn1, BTN_EVENT_MASK(SINGLE_CLICK), 0);
+ *           BTN_AWAIT(co, &btn2, BTN_EVENT_MASK(SINGLE_CLICK), 2000);
+ *           if(co->ev.event == NONE_PRESS) { ...timeout... }
+ *       }
+ *       BTN_CO_END(co);
+ *   }
+ */
+
+#define BTN_EVENT_MASK(ev)      ((uint16_t)(1u << (ev)))
+
+typedef struct BtnCoroutine {
+    ButtonWaiter waiter;        /* first member, the wake callback casts back */
+    SchedTask task;
+    SoftTimer timer;
+    struct Button* button;
+    ButtonEvent ev;             /* event resumed with, event NONE_PRESS on timeout */
+    uint16_t lc;                /* local continuation */
+} BtnCoroutine;
+
+#define BTN_CO_BEGIN(co)        switch((co)->lc) { case 0:
+#define BTN_CO_END(co)          } (co)->lc = 0; return
+
+/* Suspend until an event of mask on btn, or timeout soft timer ticks (0: none) */
+#define BTN_AWAIT(co, btn, mask, timeout)                       \
+    do {                                                        \
+        (co)->lc = __LINE__;                                    \
+        button_await(co, btn, mask, timeout);                   \
+        return;                                                 \
+        case __LINE__:;                                         \
+    } while(0)
+
+void button_co_init(BtnCoroutine* co, SchedHandler handler, uint8_t prio);
+void button_co_start(BtnCoroutine* co);
+void button_await(BtnCoroutine* co, struct Button* btn, uint16_t event_mask, uint32_t timeout);
+
+#endif
@@ -0,0 +1,69 @@
+#include "button_telemetry.h"
+#include "wb32l003.h"
+#include "bsp_lpuart1.h"
+
+#if BUTTON_TELEMETRY
+
+static uint8_t* put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)v);
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+/**
+  * @name   Telemetry_Encode
+  * @brief  Snapshot the button statistics into a binary record.
+  * @param  btn: the button handle struct.
+  * @param  buf: destination, TELEMETRY_RECORD_SIZE bytes.
+  * @retval record size.
+  */
+uint16_t Telemetry_Encode(struct Button* btn, uint8_t* buf)
+{
+    ButtonStats stats;
+    uint32_t primask;
+    uint8_t* p = buf;
+    uint8_t i;
+
+    /* consistent snapshot against button_ticks() */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    button_get_stats(btn, &stats);
+    __set_PRIMASK(primask);
+
+    *p++ = TELEMETRY_MAGIC;
+    *p++ = TELEMETRY_VERSION;
+    p = put_u16(p, btn->button_id);
+    p = put_u32(p, button_get_clock());
+    p = put_u32(p, stats.presses);
+    p = put_u32(p, stats.clicks);
+    p = put_u32(p, stats.double_clicks);
+    p = put_u32(p, stats.long_presses);
+    p = put_u32(p, stats.bounces);
+    for (i = 0; i < STATS_PRESS_BUCKETS; i++)
+        p = put_u16(p, stats.press_hist[i]);
+    for (i = 0; i < STATS_BOUNCE_BUCKETS; i++)
+        p = put_u16(p, stats.bounce_hist[i]);
+
+    return (uint16_t)(p - buf);
+}
+
+/**
+  * @name   Telemetry_Send
+  * @brief  Send the binary statistics record of a button over LPUART.
+  * @param  btn: the button handle struct.
+  * @retval None
+  */
+void Telemetry_Send(struct Button* btn)
+{
+    uint8_t record[TELEMETRY_RECORD_SIZE];
+
+    print_write(record, Telemetry_Encode(btn, record));
+}
+#endif
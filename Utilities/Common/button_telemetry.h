@@ -0,0 +1,22 @@
+#ifndef __BUTTON_TELEMETRY_H
+#define __BUTTON_TELEMETRY_H
+#include "multi_button.h"
+
+/*
+ * Binary snapshot record, little endian:
+ *   u8  magic (TELEMETRY_MAGIC)
+ *   u8  version (TELEMETRY_VERSION)
+ *   u16 button_id
+ *   u32 engine clock in ticks
+ *   u32 presses, clicks, double_clicks, long_presses, bounces
+ *   u16 press_hist[STATS_PRESS_BUCKETS]
+ *   u16 bounce_hist[STATS_BOUNCE_BUCKETS]
+ */
+#define TELEMETRY_MAGIC         0xB7
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_RECORD_SIZE   (8 + 5 * 4 + (STATS_PRESS_BUCKETS + STATS_BOUNCE_BUCKETS) * 2)
+
+uint16_t Telemetry_Encode(struct Button* btn, uint8_t* buf);
+void Telemetry_Send(struct Button* btn);
+
+#endif
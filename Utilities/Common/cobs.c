@@ -0,0 +1,114 @@
+#include "cobs.h"
+
+/**
+  * @name   cobs_encode
+  * @brief  Encode a frame and append the 0x00 delimiter.
+  * @param  src: frame.
+  * @param  len: frame length.
+  * @param  dst: at least COBS_MAX_ENCODED(len) bytes, must not overlap src.
+  * @retval encoded length.
+  */
+uint16_t cobs_encode(const uint8_t* src, uint16_t len, uint8_t* dst)
+{
+    uint16_t code_pos = 0;
+    uint16_t out = 1;
+    uint8_t code = 1;
+
+    while (len--)
+    {
+        if (*src)
+        {
+            dst[out++] = *src;
+            code++;
+        }
+        if (!*src || code == 0xFF)
+        {
+            dst[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+        }
+        src++;
+    }
+    dst[code_pos] = code;
+    dst[out++] = 0;
+    return out;
+}
+
+/**
+  * @name   cobs_decoder_init
+  * @brief  Initializes a streaming decoder.
+  * @param  dec: the decoder struct.
+  * @param  buf: frame buffer.
+  * @param  size: largest decoded frame.
+  * @param  handler: called with each complete frame.
+  * @param  arg: passed to handler.
+  * @retval None
+  */
+void cobs_decoder_init(CobsDecoder* dec, uint8_t* buf, uint16_t size, CobsFrameHandler handler, void* arg)
+{
+    dec->buf = buf;
+    dec->size = size;
+    dec->len = 0;
+    dec->code = 0;
+    dec->left = 0;
+    dec->discard = 0;
+    dec->handler = handler;
+    dec->arg = arg;
+    dec->errors = 0;
+}
+
+static void decoder_put(CobsDecoder* dec, uint8_t byte)
+{
+    if (dec->len < dec->size)
+    {
+        dec->buf[dec->len++] = byte;
+    }
+    else
+    {
+        dec->discard = 1;
+        dec->errors++;
+    }
+}
+
+/**
+  * @name   cobs_decode_byte
+  * @brief  Feed one received byte, the handler runs on the delimiter.
+  * @param  dec: the decoder struct.
+  * @param  byte: received byte.
+  * @retval None
+  */
+void cobs_decode_byte(CobsDecoder* dec, uint8_t byte)
+{
+    if (byte == 0)
+    {
+        if (!dec->discard && dec->code)
+        {
+            if (dec->left == 0)
+                dec->handler(dec->buf, dec->len, dec->arg);
+            else
+                dec->errors++;
+        }
+        dec->len = 0;
+        dec->code = 0;
+        dec->left = 0;
+        dec->discard = 0;
+        return;
+    }
+
+    if (dec->discard)
+        return;
+
+    if (dec->left == 0)
+    {
+        /* a block shorter than 254 bytes stood for a 0x00 */
+        if (dec->code && dec->code != 0xFF)
+            decoder_put(dec, 0);
+        dec->code = byte;
+        dec->left = byte - 1;
+    }
+    else
+    {
+        decoder_put(dec, byte);
+        dec->left--;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef __COBS_H
+#define __COBS_H
+#include <stdint.h>
+
+/*
+ * Consistent Overhead Byte Stuffing. Frames carry no 0x00 byte, a 0x00
+ * ends each frame, so a receiver resynchronizes at the next delimiter.
+ */
+
+/* Worst case encoded size of len bytes, delimiter included */
+#define COBS_MAX_ENCODED(len)   ((len) + (len) / 254 + 2)
+
+typedef void (*CobsFrameHandler)(const uint8_t* frame, uint16_t len, void* arg);
+
+typedef struct {
+    uint8_t* buf;               /* decoded frame, handed to the handler in place */
+    uint16_t size;
+    uint16_t len;
+    uint8_t code;               /* code byte of the current block, 0 between frames */
+    uint8_t left;               /* data bytes left in the current block */
+    uint8_t discard;            /* bad frame, skip up to the next delimiter */
+    CobsFrameHandler handler;
+    void* arg;
+    uint32_t errors;            /* truncated or oversized frames */
+} CobsDecoder;
+
+uint16_t cobs_encode(const uint8_t* src, uint16_t len, uint8_t* dst);
+void cobs_decoder_init(CobsDecoder* dec, uint8_t* buf, uint16_t size, CobsFrameHandler handler, void* arg);
+void cobs_decode_byte(CobsDecoder* dec, uint8_t byte);
+
+#endif
@@ -0,0 +1,134 @@
+#include "crc16_soft.h"
+#include "crc16_soft_table.h"
+
+#if CRC16_SOFT_CLMUL
+#include <immintrin.h>
+#endif
+
+/* Register level reference, one bit per step as the shift register does */
+uint16_t crc16_soft_bitwise(uint16_t crc, const uint8_t* data, size_t len)
+{
+    uint8_t bit;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC16_SOFT_POLY : crc >> 1;
+    }
+    return crc;
+}
+
+/* Table driven, slicing-by-8 with CRC16_SOFT_SLICES 8 */
+uint16_t crc16_soft_table(uint16_t crc, const uint8_t* data, size_t len)
+{
+#if CRC16_SOFT_SLICES == 8
+    while (len >= 8)
+    {
+        crc ^= data[0] | (data[1] << 8);
+        crc = crc_table[7][crc & 0xFF] ^ crc_table[6][crc >> 8]
+            ^ crc_table[5][data[2]] ^ crc_table[4][data[3]]
+            ^ crc_table[3][data[4]] ^ crc_table[2][data[5]]
+            ^ crc_table[1][data[6]] ^ crc_table[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+#endif
+
+    while (len--)
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *data++) & 0xFF];
+
+    return crc;
+}
+
+#if CRC16_SOFT_CLMUL
+
+int crc16_soft_clmul_supported(void)
+{
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse2");
+}
+
+/*
+ * Bit reflected lanes: byte 0 of a 16 byte block is the highest power.
+ * fold(a, k) is a * x^d mod P kept in 128 bits, the low lane multiplied
+ * by x^(d + 63) mod P and the high lane by x^(d - 1) mod P, the missing
+ * power being the one bit the reflected product comes out shifted by.
+ */
+__attribute__((target("pclmul,sse2")))
+static inline __m128i fold(__m128i a, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x00), _mm_clmulepi64_si128(a, k, 0x11));
+}
+
+/* Four lanes of 16 bytes folded 512 bits at a time, the last 16 bytes left to the table */
+__attribute__((target("pclmul,sse2")))
+uint16_t crc16_soft_clmul(uint16_t crc, const uint8_t* data, size_t len)
+{
+    const __m128i k128 = _mm_set_epi64x((long long)CRC16_SOFT_K128_LO, (long long)CRC16_SOFT_K128_HI);
+    const __m128i k512 = _mm_set_epi64x((long long)CRC16_SOFT_K512_LO, (long long)CRC16_SOFT_K512_HI);
+    __m128i x0, x1, x2, x3;
+    uint8_t rest[16];
+
+    if (len < 64)
+        return crc16_soft_table(crc, data, len);
+
+    /* the seed is the register xored into the first two bytes */
+    x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)data), _mm_cvtsi32_si128(crc));
+    x1 = _mm_loadu_si128((const __m128i*)(data + 16));
+    x2 = _mm_loadu_si128((const __m128i*)(data + 32));
+    x3 = _mm_loadu_si128((const __m128i*)(data + 48));
+    data += 64;
+    len -= 64;
+
+    while (len >= 64)
+    {
+        x0 = _mm_xor_si128(fold(x0, k512), _mm_loadu_si128((const __m128i*)data));
+        x1 = _mm_xor_si128(fold(x1, k512), _mm_loadu_si128((const __m128i*)(data + 16)));
+        x2 = _mm_xor_si128(fold(x2, k512), _mm_loadu_si128((const __m128i*)(data + 32)));
+        x3 = _mm_xor_si128(fold(x3, k512), _mm_loadu_si128((const __m128i*)(data + 48)));
+        data += 64;
+        len -= 64;
+    }
+
+    x0 = _mm_xor_si128(fold(x0, k128), x1);
+    x0 = _mm_xor_si128(fold(x0, k128), x2);
+    x0 = _mm_xor_si128(fold(x0, k128), x3);
+    while (len >= 16)
+    {
+        x0 = _mm_xor_si128(fold(x0, k128), _mm_loadu_si128((const __m128i*)data));
+        data += 16;
+        len -= 16;
+    }
+
+    _mm_storeu_si128((__m128i*)rest, x0);
+    crc = crc16_soft_table(0, rest, sizeof(rest));
+    return crc16_soft_table(crc, data, len);
+}
+
+static uint16_t update_pick(uint16_t crc, const uint8_t* data, size_t len);
+static uint16_t (*update_impl)(uint16_t crc, const uint8_t* data, size_t len) = update_pick;
+
+/* First call: the carry-less multiply path if the CPU has it */
+static uint16_t update_pick(uint16_t crc, const uint8_t* data, size_t len)
+{
+    update_impl = crc16_soft_clmul_supported() ? crc16_soft_clmul : crc16_soft_table;
+    return update_impl(crc, data, len);
+}
+
+#endif
+
+/* Continue a CRC over a chunk, same as a CRC context update */
+uint16_t crc16_soft_update(uint16_t crc, const uint8_t* data, size_t len)
+{
+#if CRC16_SOFT_CLMUL
+    return update_impl(crc, data, len);
+#else
+    return crc16_soft_table(crc, data, len);
+#endif
+}
+
+/* One shot, same as CRC_Calculate() */
+uint16_t crc16_soft(const uint8_t* data, size_t len)
+{
+    return crc16_soft_update(CRC16_SOFT_SEED, data, len) ^ CRC16_SOFT_XOROUT;
+}
@@ -0,0 +1,57 @@
+#ifndef __CRC16_SOFT_H
+#define __CRC16_SOFT_H
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Software model of the WB32L003 CRC unit, plain C99 so host tools can
+ * check the CRCs the firmware produces with CRC_Calculate() and the
+ * CRC context API.
+ *
+ * CRC-16/X-25: polynomial 0x1021 processed LSB first (0x8408), seed
+ * 0xFFFF, output xor 0xFFFF, check value 0x906E for "123456789".
+ * crc16_soft() returns the value CRC_Calculate() reads from RESULT. The
+ * update functions carry the raw register, the CRC_ContextTypeDef State,
+ * and leave the output xor to the caller.
+ *
+ * The tables are static const, generated by
+ * Utilities/HostTools/crc16_table_gen.c into crc16_soft_table.h.
+ */
+
+#define CRC16_SOFT_POLY         0x8408  /* 0x1021 bit reversed */
+#define CRC16_SOFT_SEED         0xFFFF  /* CRC_InitResult() */
+#define CRC16_SOFT_XOROUT       0xFFFF  /* applied to RESULT reads */
+#define CRC16_SOFT_CHECK        0x906E  /* crc16_soft("123456789", 9) */
+
+/* Table slices: 1 is byte at a time (512 bytes), 8 is slicing-by-8 (4 KB) */
+#ifndef CRC16_SOFT_SLICES
+#if defined(__arm__) || defined(__ARMCC_VERSION)
+#define CRC16_SOFT_SLICES       1
+#else
+#define CRC16_SOFT_SLICES       8
+#endif
+#endif
+
+/* Carry-less multiply (PCLMULQDQ) path, x86 hosts, picked at run time */
+#ifndef CRC16_SOFT_CLMUL
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC16_SOFT_CLMUL        1
+#else
+#define CRC16_SOFT_CLMUL        0
+#endif
+#endif
+
+#if CRC16_SOFT_SLICES != 1 && CRC16_SOFT_SLICES != 8
+#error "CRC16_SOFT_SLICES must be 1 or 8"
+#endif
+
+uint16_t crc16_soft_bitwise(uint16_t crc, const uint8_t* data, size_t len);
+uint16_t crc16_soft_table(uint16_t crc, const uint8_t* data, size_t len);
+#if CRC16_SOFT_CLMUL
+int      crc16_soft_clmul_supported(void);
+uint16_t crc16_soft_clmul(uint16_t crc, const uint8_t* data, size_t len);
+#endif
+uint16_t crc16_soft_update(uint16_t crc, const uint8_t* data, size_t len);
+uint16_t crc16_soft(const uint8_t* data, size_t len);
+
+#endif
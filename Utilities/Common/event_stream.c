@@ -0,0 +1,213 @@
+#include <string.h>
+#include "event_stream.h"
+#include "crc16_soft.h"
+
+static uint16_t put_varint(uint8_t* p, uint32_t value)
+{
+    uint16_t n = 0;
+
+    while (value >= 0x80)
+    {
+        p[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (uint8_t)value;
+    return n;
+}
+
+static int get_varint(const uint8_t* p, uint16_t len, uint16_t* pos, uint32_t* value)
+{
+    uint32_t result = 0;
+    uint8_t shift = 0;
+
+    while (*pos < len && shift < 35)
+    {
+        uint8_t byte = p[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+/**
+  * @name   evstream_init
+  * @brief  Initializes a stream.
+  * @param  s: the stream struct.
+  * @param  tx_free: room in the transport, e.g. print_free.
+  * @param  tx_write: non-blocking transport write, e.g. print_write.
+  * @retval None
+  */
+void evstream_init(EvStream* s, uint16_t (*tx_free)(void), void (*tx_write)(const uint8_t* buf, uint16_t len))
+{
+    memset(s, 0, sizeof(EvStream));
+    s->tx_free = tx_free;
+    s->tx_write = tx_write;
+}
+
+/**
+  * @name   evstream_add
+  * @brief  Append an event to the frame being built.
+  * @param  s: the stream struct.
+  * @param  ev: the event.
+  * @retval 0: added. -1: frame full, finish it first.
+  */
+int evstream_add(EvStream* s, const ButtonEvent* ev)
+{
+    uint8_t* p;
+
+    if (s->count == 0)
+    {
+        s->frame[0] = EVSTREAM_MAGIC;
+        s->frame[1] = s->seq;
+        s->len = 3;
+        s->len += put_varint(&s->frame[s->len], ev->timestamp);
+        s->first_time = ev->timestamp;
+        s->last_time = ev->timestamp;
+    }
+    else if (s->count == 0xFF || s->len + EVSTREAM_EVENT_MAX + 2 > EVSTREAM_FRAME_MAX)
+    {
+        return -1;
+    }
+
+    p = &s->frame[s->len];
+    p += put_varint(p, ev->timestamp - s->last_time);
+    p += put_varint(p, ev->button_id);
+    *p++ = (uint8_t)(ev->event | (ev->repeat << 4));
+    *p++ = ev->stage;
+    p += put_varint(p, ev->duration);
+    s->len = (uint16_t)(p - s->frame);
+    s->last_time = ev->timestamp;
+    s->count++;
+    return 0;
+}
+
+/**
+  * @name   evstream_finish
+  * @brief  Close the frame, COBS encode it into s->out.
+  * @param  s: the stream struct.
+  * @retval encoded length, 0 when the frame was empty, -1 when s->out
+  *         still waits for the transport, the frame stays open.
+  */
+int evstream_finish(EvStream* s)
+{
+    uint16_t crc;
+
+    if (s->count == 0)
+        return 0;
+    if (s->out_len)
+        return -1;
+
+    s->frame[2] = s->count;
+    crc = crc16_soft(s->frame, s->len);
+    s->frame[s->len++] = (uint8_t)crc;
+    s->frame[s->len++] = (uint8_t)(crc >> 8);
+    s->out_len = cobs_encode(s->frame, s->len, s->out);
+
+    s->frames++;
+    s->events += s->count;
+    s->seq++;
+    s->count = 0;
+    s->len = 0;
+    return s->out_len;
+}
+
+/**
+  * @name   evstream_pump
+  * @brief  Move engine events to the transport, never blocks. Events are
+  *         batched up to a full frame or EVSTREAM_BATCH_TICKS, and
+  *         backpressure is raised on the engine while a frame waits for
+  *         room.
+  * @param  s: the stream struct.
+  * @retval None
+  */
+void evstream_pump(EvStream* s)
+{
+    ButtonEvent ev;
+
+    while (1)
+    {
+        if (s->out_len)
+        {
+            if (s->tx_free() < s->out_len)
+            {
+                button_set_backpressure(1);
+                return;
+            }
+            s->tx_write(s->out, s->out_len);
+            s->out_len = 0;
+        }
+        button_set_backpressure(0);
+
+        if (!button_poll_events(&ev, 1, 0))
+        {
+            /* nothing queued, a partial batch waits for more up to its age limit */
+            if (s->count == 0 || button_get_clock() - s->first_time < EVSTREAM_BATCH_TICKS)
+                return;
+            evstream_finish(s);
+            continue;
+        }
+        if (evstream_add(s, &ev) != 0)
+        {
+            evstream_finish(s);
+            evstream_add(s, &ev);
+        }
+    }
+}
+
+/**
+  * @name   evstream_decode
+  * @brief  Decode one frame, as handed over by a CobsDecoder.
+  * @param  frame: decoded frame.
+  * @param  len: frame length.
+  * @param  events: destination.
+  * @param  max: size of the destination.
+  * @param  seq: if not NULL, receives the frame sequence.
+  * @retval number of events, -1 on a bad frame.
+  */
+int evstream_decode(const uint8_t* frame, uint16_t len, ButtonEvent* events, uint16_t max, uint8_t* seq)
+{
+    uint16_t pos = 3;
+    uint32_t time, value;
+    uint8_t count, i;
+
+    if (len < 6 || frame[0] != EVSTREAM_MAGIC)
+        return -1;
+    len -= 2;
+    if (crc16_soft(frame, len) != (frame[len] | (frame[len + 1] << 8)))
+        return -1;
+
+    count = frame[2];
+    if (count > max || get_varint(frame, len, &pos, &time) != 0)
+        return -1;
+
+    for (i = 0; i < count; i++)
+    {
+        ButtonEvent* ev = &events[i];
+
+        memset(ev, 0, sizeof(ButtonEvent));
+        if (get_varint(frame, len, &pos, &value) != 0)
+            return -1;
+        time += value;
+        ev->timestamp = time;
+        if (get_varint(frame, len, &pos, &value) != 0 || pos >= len)
+            return -1;
+        ev->button_id = (uint16_t)value;
+        ev->event = frame[pos] & 0x0F;
+        ev->repeat = frame[pos++] >> 4;
+        if (pos >= len)
+            return -1;
+        ev->stage = frame[pos++];
+        if (get_varint(frame, len, &pos, &value) != 0)
+            return -1;
+        ev->duration = (uint16_t)value;
+    }
+
+    if (seq)
+        *seq = frame[1];
+    return pos == len ? count : -1;
+}
@@ -0,0 +1,57 @@
+#ifndef __EVENT_STREAM_H
+#define __EVENT_STREAM_H
+#include <stdint.h>
+#include "multi_button.h"
+#include "cobs.h"
+
+/*
+ * Button event stream, COBS framed, several events per frame.
+ *
+ * Frame before COBS, varints are unsigned LEB128:
+ *   u8  EVSTREAM_MAGIC
+ *   u8  sequence, +1 per frame, a gap means lost frames
+ *   u8  event count
+ *   var timestamp of the first event
+ *   per event:
+ *     var timestamp delta to the previous event
+ *     var button_id
+ *     u8  event | repeat << 4
+ *     u8  long press stage
+ *     var duration
+ *   u16 CRC-16/X-25 (crc16_soft) of the bytes above, little endian
+ *
+ * Plain C, the same encoder and decoder build for the device and Linux.
+ * evstream_pump() closes a partial frame once its first event is
+ * EVSTREAM_BATCH_TICKS old, or at once when the frame is full.
+ */
+
+#define EVSTREAM_MAGIC          0xE5
+#define EVSTREAM_FRAME_MAX      96      /* raw frame, fits the print TX ring once encoded */
+#define EVSTREAM_EVENT_MAX      13      /* largest encoded event */
+#ifndef EVSTREAM_BATCH_TICKS
+#define EVSTREAM_BATCH_TICKS    10      /* engine ticks a partial frame may wait for more events */
+#endif
+
+typedef struct {
+    uint8_t frame[EVSTREAM_FRAME_MAX];
+    uint16_t len;
+    uint8_t count;
+    uint8_t seq;
+    uint32_t first_time;
+    uint32_t last_time;
+    /* encoded frame waiting for room in the transport */
+    uint8_t out[COBS_MAX_ENCODED(EVSTREAM_FRAME_MAX)];
+    uint16_t out_len;
+    uint16_t (*tx_free)(void);
+    void (*tx_write)(const uint8_t* buf, uint16_t len);
+    uint32_t frames;
+    uint32_t events;
+} EvStream;
+
+void evstream_init(EvStream* s, uint16_t (*tx_free)(void), void (*tx_write)(const uint8_t* buf, uint16_t len));
+int  evstream_add(EvStream* s, const ButtonEvent* ev);
+int  evstream_finish(EvStream* s);
+void evstream_pump(EvStream* s);
+int  evstream_decode(const uint8_t* frame, uint16_t len, ButtonEvent* events, uint16_t max, uint8_t* seq);
+
+#endif
@@ -0,0 +1,298 @@
+#include <string.h>
+#include "kv_cache.h"
+#include "kv_store.h"
+#include "soft_timer.h"
+#include "wb32l003.h"
+
+#define KV_CACHE_FREE           0xFFFF
+
+typedef struct {
+    uint16_t key;
+    uint8_t len;
+    uint8_t dirty;
+    uint8_t data[KV_CACHE_VALUE_MAX];
+} KvCacheSlot;
+
+static KvCacheSlot cache[KV_CACHE_SLOTS];
+static volatile uint8_t dirty_count = 0;
+static volatile uint8_t commit_due = 0;
+static uint8_t victim = 0;
+static SoftTimer delay_timer;
+static KvCacheStats stats;
+static uint32_t (*cache_clock)(void) = 0;
+
+static void delay_expired(void)
+{
+    commit_due = 1;
+}
+
+/* Running an exception handler, not the thread that owns the store */
+static int in_handler(void)
+{
+    return (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
+}
+
+static KvCacheSlot* slot_find(uint16_t key)
+{
+    uint8_t i;
+
+    for (i = 0; i < KV_CACHE_SLOTS; i++)
+    {
+        if (cache[i].key == key)
+            return &cache[i];
+    }
+    return 0;
+}
+
+/**
+  * @name   kv_cache_init
+  * @brief  Empty the cache, kv_init() must have mounted the store.
+  * @param  None
+  * @retval None
+  */
+void kv_cache_init(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < KV_CACHE_SLOTS; i++)
+    {
+        cache[i].key = KV_CACHE_FREE;
+        cache[i].dirty = 0;
+    }
+    dirty_count = 0;
+    commit_due = 0;
+    victim = 0;
+    memset(&stats, 0, sizeof(stats));
+    soft_timer_init(&delay_timer, delay_expired, KV_CACHE_DELAY, 0);
+}
+
+/**
+  * @name   kv_cache_set_clock
+  * @brief  Set the clock that times the commits, e.g. Timebase_GetUs.
+  * @param  clock: free running counter.
+  * @retval None
+  */
+void kv_cache_set_clock(uint32_t (*clock)(void))
+{
+    cache_clock = clock;
+}
+
+/**
+  * @name   kv_cache_set
+  * @brief  Update a value in RAM. In the thread large values and a cache
+  *         full of dirty slots are written through to flash, an interrupt
+  *         handler never writes the flash: it gets KV_ERR_PARAM and
+  *         KV_ERR_FULL for those.
+  * @param  key: the key.
+  * @param  data: value.
+  * @param  len: value length, above KV_CACHE_VALUE_MAX it goes to flash at once.
+  * @retval 0 or a KV_ERR_ code.
+  */
+int kv_cache_set(uint16_t key, const void* data, uint16_t len)
+{
+    KvCacheSlot* slot;
+    uint32_t primask;
+    uint8_t handler = in_handler();
+    uint8_t i;
+
+    if (key == KV_CACHE_FREE || len == 0 || (handler && len > KV_CACHE_VALUE_MAX))
+        return KV_ERR_PARAM;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    slot = slot_find(key);
+    if (len > KV_CACHE_VALUE_MAX)
+    {
+        /* write through, drop the stale copy */
+        if (slot)
+        {
+            if (slot->dirty)
+                dirty_count--;
+            slot->key = KV_CACHE_FREE;
+            slot->dirty = 0;
+        }
+        __set_PRIMASK(primask);
+        return kv_set(key, data, len);
+    }
+
+    if (!slot)
+    {
+        /* a clean slot, round robin so hot keys are not always evicted */
+        for (i = 0; i < KV_CACHE_SLOTS; i++)
+        {
+            slot = &cache[(victim + i) % KV_CACHE_SLOTS];
+            if (!slot->dirty)
+                break;
+        }
+        if (slot->dirty)
+        {
+            /* all dirty: the thread writes through, a handler gives up */
+            commit_due = 1;
+            __set_PRIMASK(primask);
+            return handler ? KV_ERR_FULL : kv_set(key, data, len);
+        }
+        victim = (victim + i + 1) % KV_CACHE_SLOTS;
+        slot->key = key;
+    }
+
+    stats.sets++;
+    if (slot->dirty)
+    {
+        stats.coalesced++;
+    }
+    else
+    {
+        slot->dirty = 1;
+        if (dirty_count++ == 0)
+            soft_timer_start(&delay_timer);
+        if (dirty_count >= KV_CACHE_MAX_DIRTY)
+            commit_due = 1;
+    }
+    slot->len = (uint8_t)len;
+    memcpy(slot->data, data, len);
+
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+/**
+  * @name   kv_cache_get
+  * @brief  Read a value, from the cache or the store. An interrupt handler
+  *         sees the cached values only, a miss is KV_ERR_NOKEY.
+  * @param  key: the key.
+  * @param  data: destination.
+  * @param  size: size of the destination.
+  * @retval length of the value or a KV_ERR_ code.
+  */
+int kv_cache_get(uint16_t key, void* data, uint16_t size)
+{
+    KvCacheSlot* slot;
+    uint32_t primask;
+    int len;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    slot = key == KV_CACHE_FREE ? 0 : slot_find(key);
+    if (slot)
+    {
+        len = slot->len <= size ? slot->len : KV_ERR_PARAM;
+        if (len > 0)
+            memcpy(data, slot->data, len);
+        __set_PRIMASK(primask);
+        return len;
+    }
+    __set_PRIMASK(primask);
+
+    return in_handler() ? KV_ERR_NOKEY : kv_get(key, data, size);
+}
+
+/**
+  * @name   kv_cache_commit
+  * @brief  Write every dirty slot to the store now, from the thread that
+  *         owns it. In an interrupt handler it is kv_cache_request().
+  * @param  None
+  * @retval 0 or KV_ERR_FLASH, the failed slots stay dirty.
+  */
+int kv_cache_commit(void)
+{
+    uint8_t value[KV_CACHE_VALUE_MAX];
+    uint32_t start;
+    uint32_t primask;
+    uint16_t key;
+    uint8_t i, len;
+    int ret = 0;
+
+    if (in_handler())
+    {
+        kv_cache_request();
+        return 0;
+    }
+    start = cache_clock ? cache_clock() : 0;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    commit_due = 0;
+    soft_timer_stop(&delay_timer);
+    __set_PRIMASK(primask);
+
+    for (i = 0; i < KV_CACHE_SLOTS; i++)
+    {
+        /* snapshot under the mask, an update racing the write re-dirties it */
+        primask = __get_PRIMASK();
+        __disable_irq();
+        if (!cache[i].dirty)
+        {
+            __set_PRIMASK(primask);
+            continue;
+        }
+        key = cache[i].key;
+        len = cache[i].len;
+        memcpy(value, cache[i].data, len);
+        cache[i].dirty = 0;
+        dirty_count--;
+        __set_PRIMASK(primask);
+
+        stats.writes++;
+        if (kv_set(key, value, len) != 0)
+        {
+            ret = KV_ERR_FLASH;
+            primask = __get_PRIMASK();
+            __disable_irq();
+            if (!cache[i].dirty && cache[i].key == key)
+            {
+                cache[i].dirty = 1;
+                dirty_count++;
+            }
+            __set_PRIMASK(primask);
+        }
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (dirty_count)
+        soft_timer_start(&delay_timer);
+    __set_PRIMASK(primask);
+
+    stats.commits++;
+    if (cache_clock)
+    {
+        uint32_t spent = cache_clock() - start;
+        if (spent > stats.commit_max)
+            stats.commit_max = spent;
+    }
+    return ret;
+}
+
+/**
+  * @name   kv_cache_request
+  * @brief  Have the next kv_cache_idle() commit, callable from ISRs.
+  * @param  None
+  * @retval None
+  */
+void kv_cache_request(void)
+{
+    commit_due = 1;
+}
+
+/**
+  * @name   kv_cache_idle
+  * @brief  Commit when due, call it from the idle loop or a low priority task.
+  * @param  None
+  * @retval None
+  */
+void kv_cache_idle(void)
+{
+    if (commit_due)
+        kv_cache_commit();
+}
+
+uint8_t kv_cache_dirty(void)
+{
+    return dirty_count;
+}
+
+const KvCacheStats* kv_cache_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,41 @@
+#ifndef __KV_CACHE_H
+#define __KV_CACHE_H
+#include <stdint.h>
+
+/*
+ * Write-behind cache in front of kv_store. Updates land in RAM slots and
+ * repeated updates of a key coalesce, the flash sees one record per key
+ * per commit. A commit runs from kv_cache_idle() once it is due:
+ *   - KV_CACHE_DELAY after the first update of a clean cache (timer)
+ *   - as soon as KV_CACHE_MAX_DIRTY slots are dirty
+ *   - when kv_cache_request() asks for it, e.g. on a low-voltage warning
+ *
+ * The thread running kv_cache_idle() owns the store: commits, write
+ * throughs and store reads happen there only. In an interrupt handler
+ * kv_cache_set() only fills a slot and kv_cache_get() only reads one.
+ */
+
+#define KV_CACHE_SLOTS          8
+#define KV_CACHE_VALUE_MAX      16      /* larger values are written through */
+#define KV_CACHE_MAX_DIRTY      4       /* dirty slots that force a commit */
+#define KV_CACHE_DELAY          5000    /* soft timer ticks, longest dirty window */
+
+typedef struct {
+    uint32_t sets;
+    uint32_t coalesced;         /* sets that hit a dirty slot */
+    uint32_t commits;
+    uint32_t writes;            /* kv_set() calls made by commits */
+    uint32_t commit_max;        /* longest commit, in kv_cache_set_clock() units */
+} KvCacheStats;
+
+void kv_cache_init(void);
+void kv_cache_set_clock(uint32_t (*clock)(void));
+int  kv_cache_set(uint16_t key, const void* data, uint16_t len);
+int  kv_cache_get(uint16_t key, void* data, uint16_t size);
+int  kv_cache_commit(void);
+void kv_cache_request(void);
+void kv_cache_idle(void);
+uint8_t kv_cache_dirty(void);
+const KvCacheStats* kv_cache_stats(void);
+
+#endif
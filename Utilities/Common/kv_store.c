@@ -0,0 +1,429 @@
+#include <string.h>
+#include "kv_store.h"
+#include "crc16_soft.h"
+#include "wb32l003_flash.h"
+
+#define KV_PAGE_MAGIC           0x4B560001  /* "KV", layout version 1 */
+#define KV_ERASED               0xFFFFFFFF
+#define KV_KEY_EMPTY            0xFFFF
+#define KV_HEADER_SIZE          8
+#define KV_INDEX_SIZE           (1 << KV_INDEX_BITS)
+#define KV_RECORD_SIZE(len)     (8 + (((uint32_t)(len) + 3) & ~3u))
+#define KV_PAGE_ADDR(page)      (KV_FLASH_BASE + (uint32_t)(page) * FLASH_PAGE_SIZE)
+#define KV_CAPACITY             ((KV_PAGES - 2) * (FLASH_PAGE_SIZE - KV_HEADER_SIZE))
+
+#if KV_FLASH_BASE % FLASH_PAGE_SIZE != 0
+#error "KV_FLASH_BASE must be FLASH_PAGE_SIZE aligned"
+#endif
+#if KV_FLASH_BASE < KV_IMAGE_LIMIT
+#error "the key-value pages overlap the application image, shrink IROM1"
+#endif
+#if KV_FLASH_BASE + KV_PAGES * FLASH_PAGE_SIZE > FLASH_SIZE_64K
+#error "the key-value pages run past the end of flash"
+#endif
+
+/* Flash contents are read in place, through the emulator on host builds */
+#if KV_FLASH_EMU
+#include "flash_emu.h"
+#define KV_FLASH_PTR(addr)      ((const uint8_t*)flash_emu_mem(addr))
+#else
+#define KV_FLASH_PTR(addr)      ((const uint8_t*)(addr))
+#endif
+
+#if defined(__ARMCC_VERSION)
+/* End of the load region armlink builds from IROM1 */
+extern const uint8_t Load$$LR$$LR_IROM1$$Limit[];
+#define KV_IMAGE_END()          ((uint32_t)Load$$LR$$LR_IROM1$$Limit)
+#else
+#define KV_IMAGE_END()          0U
+#endif
+
+typedef struct {
+    uint16_t key;
+    uint16_t offset;        /* record offset from KV_FLASH_BASE */
+} KvSlot;
+
+static KvSlot kv_index[KV_INDEX_SIZE];
+static uint16_t kv_keys = 0;
+static uint16_t kv_live = 0;    /* bytes of the newest records of all keys */
+static uint8_t kv_head = 0;     /* active page */
+static uint16_t kv_write = 0;   /* next record offset in the active page */
+static uint32_t kv_seq = 0;     /* sequence of the active page */
+
+static uint32_t kv_read32(uint32_t addr)
+{
+    const uint8_t* p = KV_FLASH_PTR(addr);
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t record_crc(uint16_t key, uint16_t len, const uint8_t* value)
+{
+    uint8_t head[4];
+
+    head[0] = (uint8_t)key;
+    head[1] = (uint8_t)(key >> 8);
+    head[2] = (uint8_t)len;
+    head[3] = (uint8_t)(len >> 8);
+    return crc16_soft_bitwise(crc16_soft_bitwise(CRC16_SOFT_SEED, head, 4), value, len);
+}
+
+/* A record is committed once its crc word, programmed last, matches */
+static int record_valid(uint32_t addr)
+{
+    uint32_t head = kv_read32(addr);
+    uint32_t check = kv_read32(addr + 4);
+    uint16_t crc = record_crc((uint16_t)head, (uint16_t)(head >> 16), KV_FLASH_PTR(addr + 8));
+
+    return check == (crc | ((uint32_t)(uint16_t)~crc << 16));
+}
+
+static uint16_t record_len(uint16_t offset)
+{
+    return (uint16_t)(kv_read32(KV_FLASH_BASE + offset) >> 16);
+}
+
+/* Slot of the key, or of the empty slot ending its probe sequence */
+static uint16_t index_slot(uint16_t key)
+{
+    uint16_t slot = (uint16_t)(key * 40503u) >> (16 - KV_INDEX_BITS);
+
+    while (kv_index[slot].key != KV_KEY_EMPTY && kv_index[slot].key != key)
+        slot = (slot + 1) & (KV_INDEX_SIZE - 1);
+    return slot;
+}
+
+static void index_put(uint16_t key, uint16_t offset)
+{
+    KvSlot* slot = &kv_index[index_slot(key)];
+
+    if (slot->key == key)
+    {
+        kv_live -= KV_RECORD_SIZE(record_len(slot->offset));
+    }
+    else
+    {
+        slot->key = key;
+        kv_keys++;
+    }
+    slot->offset = offset;
+    kv_live += KV_RECORD_SIZE(record_len(offset));
+}
+
+/* Backward shift deletion keeps the probe sequences unbroken */
+static void index_remove(uint16_t key)
+{
+    uint16_t hole = index_slot(key);
+    uint16_t slot = hole;
+
+    if (kv_index[hole].key != key)
+        return;
+    kv_live -= KV_RECORD_SIZE(record_len(kv_index[hole].offset));
+    kv_keys--;
+
+    while (1)
+    {
+        uint16_t home;
+
+        slot = (slot + 1) & (KV_INDEX_SIZE - 1);
+        if (kv_index[slot].key == KV_KEY_EMPTY)
+            break;
+        home = (uint16_t)(kv_index[slot].key * 40503u) >> (16 - KV_INDEX_BITS);
+        /* move the entry back unless its home lies cyclically in (hole, slot] */
+        if (((slot - home) & (KV_INDEX_SIZE - 1)) >= ((slot - hole) & (KV_INDEX_SIZE - 1)))
+        {
+            kv_index[hole] = kv_index[slot];
+            hole = slot;
+        }
+    }
+    kv_index[hole].key = KV_KEY_EMPTY;
+}
+
+static int page_erased(uint8_t page)
+{
+    uint32_t addr;
+
+    for (addr = KV_PAGE_ADDR(page); addr < KV_PAGE_ADDR(page + 1); addr += 4)
+    {
+        if (kv_read32(addr) != KV_ERASED)
+            return 0;
+    }
+    return 1;
+}
+
+/* Erase a page and check it, an erase that did not happen is a failure */
+static int page_erase(uint8_t page)
+{
+    return FLASH_ErasePage(KV_PAGE_ADDR(page)) == FLASH_COMPLETE && page_erased(page);
+}
+
+/* Program a word and read it back, a lost write must not go unnoticed */
+static int program_word(uint32_t addr, uint32_t value)
+{
+    return FLASH_ProgramWord(addr, value) == FLASH_COMPLETE && kv_read32(addr) == value;
+}
+
+/* Append at the write position, the caller has checked the room */
+static int record_write(uint16_t key, const uint32_t* value, uint16_t len)
+{
+    uint32_t addr = KV_PAGE_ADDR(kv_head) + kv_write;
+    uint16_t crc = record_crc(key, len, (const uint8_t*)value);
+
+    if (!program_word(addr, key | ((uint32_t)len << 16)) ||
+        (len && FLASH_ProgramBuffer(addr + 8, value, (len + 3) / 4) != FLASH_COMPLETE) ||
+        !program_word(addr + 4, crc | ((uint32_t)(uint16_t)~crc << 16)))
+    {
+        /* close the page, the torn record is skipped by the crc */
+        kv_write = FLASH_PAGE_SIZE;
+        return KV_ERR_FLASH;
+    }
+
+    kv_write += KV_RECORD_SIZE(len);
+    if (len)
+        index_put(key, (uint16_t)(addr - KV_FLASH_BASE));
+    else
+        index_remove(key);
+    return 0;
+}
+
+/*
+ * A copy failed: the page being collected is kept as it is. The active
+ * page holds nothing but copies of its records, so it is erased and the
+ * store mounted again, the next page_advance() retries the collect.
+ */
+static int collect_abort(void)
+{
+    if (page_erase(kv_head))
+        kv_init();
+    return KV_ERR_FLASH;
+}
+
+/* Copy the live records of a page to the active page, then erase it */
+static int page_collect(uint8_t page)
+{
+    uint32_t base = KV_PAGE_ADDR(page);
+    uint16_t pos = KV_HEADER_SIZE;
+    uint32_t value[KV_VALUE_MAX / 4];
+
+    while (pos + 8u <= FLASH_PAGE_SIZE)
+    {
+        uint32_t head = kv_read32(base + pos);
+        uint16_t key = (uint16_t)head;
+        uint16_t len = (uint16_t)(head >> 16);
+        KvSlot* slot;
+
+        if (head == KV_ERASED || len > KV_VALUE_MAX)
+            break;
+
+        slot = &kv_index[index_slot(key)];
+        if (slot->key == key && slot->offset == base + pos - KV_FLASH_BASE)
+        {
+            if (kv_write + KV_RECORD_SIZE(len) > FLASH_PAGE_SIZE)
+                return collect_abort();
+            memcpy(value, KV_FLASH_PTR(base + pos + 8), len);
+            if (record_write(key, value, len) != 0)
+                return collect_abort();
+        }
+        pos += KV_RECORD_SIZE(len);
+    }
+
+    return page_erase(page) ? 0 : KV_ERR_FLASH;
+}
+
+/* Open the next page of the ring and keep one erased spare after it */
+static int page_advance(void)
+{
+    uint8_t next = (kv_head + 1) % KV_PAGES;
+    uint32_t addr = KV_PAGE_ADDR(next);
+
+    /* no spare: the last collect failed, its page is still there */
+    if (!page_erased(next) && page_collect(next) != 0)
+        return KV_ERR_FLASH;
+
+    /* the magic goes last, a page without it is erased at the next boot */
+    if (!program_word(addr + 4, kv_seq + 1) || !program_word(addr, KV_PAGE_MAGIC))
+        return KV_ERR_FLASH;
+
+    kv_head = next;
+    kv_seq++;
+    kv_write = KV_HEADER_SIZE;
+
+    next = (kv_head + 1) % KV_PAGES;
+    if (kv_read32(KV_PAGE_ADDR(next)) == KV_PAGE_MAGIC)
+        return page_collect(next);
+    return 0;
+}
+
+static int record_append(uint16_t key, const uint32_t* value, uint16_t len)
+{
+    uint8_t tries = KV_PAGES;
+
+    while (kv_write + KV_RECORD_SIZE(len) > FLASH_PAGE_SIZE)
+    {
+        if (!tries-- || page_advance() != 0)
+            return KV_ERR_FLASH;
+    }
+    return record_write(key, value, len);
+}
+
+/* Replay a page into the index, return the end of its log */
+static uint16_t page_replay(uint8_t page)
+{
+    uint32_t base = KV_PAGE_ADDR(page);
+    uint16_t pos = KV_HEADER_SIZE;
+
+    while (pos + 8u <= FLASH_PAGE_SIZE)
+    {
+        uint32_t head = kv_read32(base + pos);
+        uint16_t key = (uint16_t)head;
+        uint16_t len = (uint16_t)(head >> 16);
+
+        if (head == KV_ERASED)
+            return pos;
+        if (len > KV_VALUE_MAX || pos + KV_RECORD_SIZE(len) > FLASH_PAGE_SIZE)
+            return FLASH_PAGE_SIZE;
+
+        if (record_valid(base + pos))
+        {
+            if (len)
+                index_put(key, (uint16_t)(base + pos - KV_FLASH_BASE));
+            else
+                index_remove(key);
+        }
+        pos += KV_RECORD_SIZE(len);
+    }
+    return FLASH_PAGE_SIZE;
+}
+
+/**
+ * @brief  Mount the store and rebuild the index, the scan is bounded by
+ *         KV_PAGES * FLASH_PAGE_SIZE. A blank range is formatted.
+ * @retval 0 or KV_ERR_FLASH, also when the image reaches into the pages.
+ */
+int kv_init(void)
+{
+    uint8_t order[KV_PAGES];
+    uint32_t seq[KV_PAGES];
+    uint8_t used = 0;
+    uint8_t page, i;
+    uint16_t end = KV_HEADER_SIZE;
+
+    if (KV_IMAGE_END() > KV_FLASH_BASE)
+        return KV_ERR_FLASH;
+
+    memset(kv_index, 0xFF, sizeof(kv_index));
+    kv_keys = 0;
+    kv_live = 0;
+
+    /* pages by sequence, oldest first */
+    for (page = 0; page < KV_PAGES; page++)
+    {
+        uint32_t head = kv_read32(KV_PAGE_ADDR(page));
+
+        if (head == KV_PAGE_MAGIC)
+        {
+            seq[page] = kv_read32(KV_PAGE_ADDR(page) + 4);
+            for (i = used; i > 0 && (int32_t)(seq[order[i - 1]] - seq[page]) > 0; i--)
+                order[i] = order[i - 1];
+            order[i] = page;
+            used++;
+        }
+        else if (!page_erased(page) && !page_erase(page))
+        {
+            return KV_ERR_FLASH;
+        }
+    }
+
+    if (used == 0)
+    {
+        kv_head = KV_PAGES - 1;
+        kv_seq = 0;
+        return page_advance();
+    }
+
+    for (i = 0; i < used; i++)
+        end = page_replay(order[i]);
+
+    kv_head = order[used - 1];
+    kv_seq = seq[kv_head];
+    kv_write = end;
+
+    /* power lost between opening a page and collecting the oldest one */
+    if (used == KV_PAGES)
+        return page_collect(order[0]);
+    return 0;
+}
+
+/**
+ * @brief  Store a value, an unchanged value is not written again.
+ * @param  key: any key but 0xFFFF.
+ * @param  data: value.
+ * @param  len: 1 to KV_VALUE_MAX bytes.
+ * @retval 0 or KV_ERR_PARAM, KV_ERR_FULL, KV_ERR_FLASH.
+ */
+int kv_set(uint16_t key, const void* data, uint16_t len)
+{
+    uint32_t value[KV_VALUE_MAX / 4];
+    KvSlot* slot;
+    uint16_t old = 0;
+
+    if (key == KV_KEY_EMPTY || len == 0 || len > KV_VALUE_MAX)
+        return KV_ERR_PARAM;
+
+    slot = &kv_index[index_slot(key)];
+    if (slot->key == key)
+    {
+        old = record_len(slot->offset);
+        if (old == len && memcmp(KV_FLASH_PTR(KV_FLASH_BASE + slot->offset + 8), data, len) == 0)
+            return 0;
+        old = KV_RECORD_SIZE(old);
+    }
+    else if (kv_keys >= KV_MAX_KEYS)
+    {
+        return KV_ERR_FULL;
+    }
+
+    if (kv_live - old + KV_RECORD_SIZE(len) > KV_CAPACITY)
+        return KV_ERR_FULL;
+
+    value[(len - 1) / 4] = 0;
+    memcpy(value, data, len);
+    return record_append(key, value, len);
+}
+
+/**
+ * @brief  Read a value.
+ * @param  key: the key.
+ * @param  data: destination.
+ * @param  size: size of the destination.
+ * @retval length of the value, KV_ERR_NOKEY or KV_ERR_PARAM when it does not fit.
+ */
+int kv_get(uint16_t key, void* data, uint16_t size)
+{
+    KvSlot* slot = &kv_index[index_slot(key)];
+    uint16_t len;
+
+    if (key == KV_KEY_EMPTY || slot->key != key)
+        return KV_ERR_NOKEY;
+
+    len = record_len(slot->offset);
+    if (len > size)
+        return KV_ERR_PARAM;
+    memcpy(data, KV_FLASH_PTR(KV_FLASH_BASE + slot->offset + 8), len);
+    return len;
+}
+
+/**
+ * @brief  Delete a key, a tombstone record hides the older ones.
+ * @retval 0 or KV_ERR_NOKEY, KV_ERR_FLASH.
+ */
+int kv_delete(uint16_t key)
+{
+    if (key == KV_KEY_EMPTY || kv_index[index_slot(key)].key != key)
+        return KV_ERR_NOKEY;
+    return record_append(key, 0, 0);
+}
+
+uint16_t kv_count(void)
+{
+    return kv_keys;
+}
@@ -0,0 +1,46 @@
+#ifndef __KV_STORE_H
+#define __KV_STORE_H
+#include <stdint.h>
+
+/*
+ * Log structured key-value store over a reserved range of flash pages.
+ *
+ * Page layout:
+ *   u32 KV_PAGE_MAGIC, u32 sequence, then records back to back
+ * Record layout, little endian, word aligned:
+ *   u16 key, u16 len (0: deleted), u16 crc16, u16 ~crc16, value padded to 4
+ *
+ * Pages are used as a ring with one erased spare. When the active page
+ * fills, the next page is opened and the oldest page's live records are
+ * copied forward before it is erased, so every page wears evenly.
+ * A RAM hash index maps each key to its newest record.
+ *
+ * The pages sit above the application image: IROM1 in the project ends
+ * at KV_IMAGE_LIMIT, checked at compile time here and against the linked
+ * image size in kv_init(). KV_FLASH_EMU 1 reads the pages through the
+ * host flash emulator.
+ */
+
+#define KV_FLASH_BASE           0xF800  /* first reserved page, the top 2 KB of flash */
+#define KV_PAGES                4       /* reserved pages, at least 3 */
+#define KV_IMAGE_LIMIT          0xF800  /* end of IROM1 in MultiButton.uvprojx */
+#define KV_VALUE_MAX            64      /* largest value in bytes */
+#define KV_INDEX_BITS           5       /* hash index of 2^bits slots */
+#define KV_MAX_KEYS             24      /* keep the index load factor below 3/4 */
+
+#ifndef KV_FLASH_EMU
+#define KV_FLASH_EMU            0
+#endif
+
+#define KV_ERR_PARAM            -1
+#define KV_ERR_NOKEY            -2
+#define KV_ERR_FULL             -3
+#define KV_ERR_FLASH            -4
+
+int kv_init(void);
+int kv_set(uint16_t key, const void* data, uint16_t len);
+int kv_get(uint16_t key, void* data, uint16_t size);
+int kv_delete(uint16_t key);
+uint16_t kv_count(void);
+
+#endif
@@ -0,0 +1,147 @@
+#include "scheduler.h"
+#include "wb32l003.h"
+
+/* Ready FIFO per priority, bit n of ready_mask set when queue n is not empty */
+static SchedTask* ready_head[SCHED_PRIO_NUM];
+static SchedTask* ready_tail[SCHED_PRIO_NUM];
+static volatile uint8_t ready_mask = 0;
+
+static uint32_t (*sched_clock)(void) = 0;
+static uint32_t idle_time = 0;
+
+/**
+  * @name   sched_task_init
+  * @brief  Initializes the task struct handle.
+  * @param  task: the task handle struct.
+  * @param  handler: run-to-completion function.
+  * @param  arg: passed to handler.
+  * @param  prio: 0 (highest) ~ SCHED_PRIO_NUM - 1.
+  * @retval None
+  */
+void sched_task_init(SchedTask* task, SchedHandler handler, void* arg, uint8_t prio)
+{
+    task->handler = handler;
+    task->arg = arg;
+    task->prio = prio < SCHED_PRIO_NUM ? prio : SCHED_PRIO_NUM - 1;
+    task->ready = 0;
+    task->next = 0;
+    task->run_count = 0;
+    task->run_time = 0;
+    task->run_max = 0;
+}
+
+/**
+  * @name   sched_post
+  * @brief  Make the task ready, callable from ISRs.
+  * @param  task: the task handle struct.
+  * @retval 0: queued. -1: already queued.
+  */
+int sched_post(SchedTask* task)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (task->ready)
+    {
+        __set_PRIMASK(primask);
+        return -1;
+    }
+    task->ready = 1;
+    task->next = 0;
+    if (ready_head[task->prio])
+        ready_tail[task->prio]->next = task;
+    else
+        ready_head[task->prio] = task;
+    ready_tail[task->prio] = task;
+    ready_mask |= (uint8_t)(1U << task->prio);
+
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+/**
+  * @name   sched_run_once
+  * @brief  Run the highest priority ready task.
+  * @param  None
+  * @retval 1: a task ran. 0: nothing ready.
+  */
+int sched_run_once(void)
+{
+    SchedTask* task;
+    uint32_t start, spent;
+    uint8_t prio;
+
+    __disable_irq();
+    if (ready_mask == 0)
+    {
+        __enable_irq();
+        return 0;
+    }
+    for (prio = 0; !(ready_mask & (1U << prio)); prio++)
+        ;
+    task = ready_head[prio];
+    ready_head[prio] = task->next;
+    if (ready_head[prio] == 0)
+        ready_mask &= (uint8_t)~(1U << prio);
+    task->ready = 0;
+    __enable_irq();
+
+    start = sched_clock ? sched_clock() : 0;
+    task->handler(task->arg);
+    spent = sched_clock ? sched_clock() - start : 0;
+
+    task->run_count++;
+    task->run_time += spent;
+    if (spent > task->run_max)
+        task->run_max = spent;
+    return 1;
+}
+
+/**
+  * @name   sched_run
+  * @brief  Scheduler loop, sleeps with WFI while nothing is ready.
+  * @param  None
+  * @retval None
+  */
+void sched_run(void)
+{
+    uint32_t start;
+
+    while (1)
+    {
+        while (sched_run_once())
+            ;
+
+        /* IRQs masked: a post between the check and WFI still wakes the core */
+        __disable_irq();
+        if (ready_mask == 0)
+        {
+            start = sched_clock ? sched_clock() : 0;
+            PWR_EnterSLEEPMode(PWR_SLEEPENTRY_WFI);
+            idle_time += sched_clock ? sched_clock() - start : 0;
+        }
+        __enable_irq();
+    }
+}
+
+/**
+  * @name   sched_set_clock
+  * @brief  Set the clock used by the run-time counters, e.g. Timebase_GetUs.
+  * @param  clock: free running counter.
+  * @retval None
+  */
+void sched_set_clock(uint32_t (*clock)(void))
+{
+    sched_clock = clock;
+}
+
+/**
+  * @name   sched_idle_time
+  * @brief  Time spent sleeping in sched_run().
+  * @param  None
+  * @retval idle time in clock units.
+  */
+uint32_t sched_idle_time(void)
+{
+    return idle_time;
+}
@@ -0,0 +1,29 @@
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+#include <stdint.h>
+
+/* Number of priorities, 0 is the highest */
+#define SCHED_PRIO_NUM          4
+
+typedef void (*SchedHandler)(void* arg);
+
+typedef struct SchedTask {
+    SchedHandler handler;
+    void* arg;
+    uint8_t prio;
+    volatile uint8_t ready;     /* queued, cleared when the handler starts */
+    struct SchedTask* next;
+    /* run-time counters, in units of the clock set by sched_set_clock() */
+    uint32_t run_count;
+    uint32_t run_time;
+    uint32_t run_max;
+} SchedTask;
+
+void sched_task_init(SchedTask* task, SchedHandler handler, void* arg, uint8_t prio);
+int  sched_post(SchedTask* task);
+int  sched_run_once(void);
+void sched_run(void);
+void sched_set_clock(uint32_t (*clock)(void));
+uint32_t sched_idle_time(void);
+
+#endif
@@ -0,0 +1,229 @@
+#include "wb32l003.h"
+#include "soft_timer.h"
+
+/* Binary min-heap of armed timers ordered by deadline */
+static SoftTimer* timer_heap[SOFT_TIMER_MAX];
+static uint16_t timer_count = 0;
+static volatile uint32_t timer_now = 0;
+static SoftTimer* timer_expiring = 0;
+
+/* wrap safe deadline compare */
+#define TIMER_BEFORE(a, b)      ((int32_t)((a)->deadline - (b)->deadline) < 0)
+
+static void heap_place(uint16_t index, SoftTimer* timer)
+{
+    timer_heap[index] = timer;
+    timer->heap_index = index;
+}
+
+static void heap_up(uint16_t index)
+{
+    SoftTimer* timer = timer_heap[index];
+
+    while (index > 0)
+    {
+        uint16_t parent = (index - 1) / 2;
+        if (!TIMER_BEFORE(timer, timer_heap[parent]))
+            break;
+        heap_place(index, timer_heap[parent]);
+        index = parent;
+    }
+    heap_place(index, timer);
+}
+
+static void heap_down(uint16_t index)
+{
+    SoftTimer* timer = timer_heap[index];
+
+    while (1)
+    {
+        uint16_t child = index * 2 + 1;
+        if (child >= timer_count)
+            break;
+        if (child + 1 < timer_count && TIMER_BEFORE(timer_heap[child + 1], timer_heap[child]))
+            child++;
+        if (!TIMER_BEFORE(timer_heap[child], timer))
+            break;
+        heap_place(index, timer_heap[child]);
+        index = child;
+    }
+    heap_place(index, timer);
+}
+
+static void heap_remove(uint16_t index)
+{
+    SoftTimer* last = timer_heap[--timer_count];
+
+    timer_heap[index]->heap_index = SOFT_TIMER_IDLE;
+    if (index == timer_count)
+        return;
+    heap_place(index, last);
+    if (index > 0 && TIMER_BEFORE(last, timer_heap[(index - 1) / 2]))
+        heap_up(index);
+    else
+        heap_down(index);
+}
+
+#if SOFT_TIMER_MAX >= SOFT_TIMER_IDLE
+#error "SOFT_TIMER_MAX must leave SOFT_TIMER_IDLE out of the heap indexes"
+#endif
+
+/**
+  * @name   soft_timer_init
+  * @brief  Initializes the timer struct handle.
+  * @param  timer: the timer handle struct.
+  * @param  cb: callback invoked from soft_timer_ticks() on expiry.
+  * @param  timeout: ticks to the first expiry.
+  * @param  repeat: period in ticks after the first expiry, 0: one shot.
+  * @retval None
+  */
+void soft_timer_init(SoftTimer* timer, SoftTimerCallback cb, uint32_t timeout, uint32_t repeat)
+{
+    timer->cb = cb;
+    timer->timeout = timeout;
+    timer->repeat = repeat;
+    timer->heap_index = SOFT_TIMER_IDLE;
+}
+
+/**
+  * @name   soft_timer_start
+  * @brief  Arm the timer, timeout counts from now. O(log n).
+  *         Callable from any interrupt, the heap update runs with IRQs masked.
+  * @param  timer: the timer handle struct.
+  * @retval 0: succeed. -1: already armed or no free slot.
+  */
+int soft_timer_start(SoftTimer* timer)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (timer->heap_index != SOFT_TIMER_IDLE || timer_count >= SOFT_TIMER_MAX)
+    {
+        __set_PRIMASK(primask);
+        return -1;
+    }
+    timer->deadline = timer_now + timer->timeout;
+    timer_heap[timer_count] = timer;
+    heap_up(timer_count++);
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+/**
+  * @name   soft_timer_stop
+  * @brief  Disarm the timer. O(log n).
+  *         Callable from any interrupt, the heap update runs with IRQs masked.
+  * @param  timer: the timer handle struct.
+  * @retval None
+  */
+void soft_timer_stop(SoftTimer* timer)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (timer->heap_index != SOFT_TIMER_IDLE)
+        heap_remove(timer->heap_index);
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @name   soft_timer_ticks
+  * @brief  Background ticks, invoke from one hardware timer interrupt.
+  *         Only the earliest deadline is compared when nothing expires.
+  *         The heap is updated with IRQs masked, callbacks run unmasked.
+  * @param  None
+  * @retval None
+  */
+void soft_timer_ticks(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now;
+
+    __disable_irq();
+    now = ++timer_now;
+    while (timer_count && (int32_t)(now - timer_heap[0]->deadline) >= 0)
+    {
+        SoftTimer* timer = timer_heap[0];
+        if (timer->repeat)
+        {
+            timer->deadline += timer->repeat;
+            heap_down(0);
+        }
+        else
+        {
+            heap_remove(0);
+        }
+        timer_expiring = timer;
+        __set_PRIMASK(primask);
+        timer->cb();
+        __disable_irq();
+    }
+    timer_expiring = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @name   soft_timer_advance
+  * @brief  Ticks missed while the tick source was stopped, e.g. in DEEPSLEEP.
+  *         The count jumps to the tick before the last, which then runs as
+  *         soft_timer_ticks(): every timer due by now expires, a repeating
+  *         one once per period missed.
+  * @param  ticks: ticks missed.
+  * @retval None
+  */
+void soft_timer_advance(uint32_t ticks)
+{
+    uint32_t primask;
+
+    if (ticks == 0)
+        return;
+    primask = __get_PRIMASK();
+    __disable_irq();
+    timer_now += ticks - 1;
+    __set_PRIMASK(primask);
+    soft_timer_ticks();
+}
+
+/**
+  * @name   soft_timer_now
+  * @brief  Ticks counted by soft_timer_ticks().
+  * @param  None
+  * @retval tick count.
+  */
+uint32_t soft_timer_now(void)
+{
+    return timer_now;
+}
+
+/**
+  * @name   soft_timer_current
+  * @brief  The timer whose callback is running, lets callbacks find their context.
+  * @param  None
+  * @retval the expiring timer, NULL outside of callbacks.
+  */
+SoftTimer* soft_timer_current(void)
+{
+    return timer_expiring;
+}
+
+/**
+  * @name   soft_timer_next
+  * @brief  Ticks until the earliest expiry, for tickless idle.
+  * @param  None
+  * @retval ticks to the next expiry, 0xFFFFFFFF: no timer armed.
+  */
+uint32_t soft_timer_next(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t next = 0xFFFFFFFF;
+    int32_t left;
+
+    __disable_irq();
+    if (timer_count)
+    {
+        left = (int32_t)(timer_heap[0]->deadline - timer_now);
+        next = left > 0 ? (uint32_t)left : 0;
+    }
+    __set_PRIMASK(primask);
+    return next;
+}
@@ -0,0 +1,30 @@
+#ifndef __SOFT_TIMER_H
+#define __SOFT_TIMER_H
+#include <stdint.h>
+
+/* Maximum number of armed timers, 4 bytes of heap each; 1024 and more for host builds */
+#ifndef SOFT_TIMER_MAX
+#define SOFT_TIMER_MAX          16
+#endif
+#define SOFT_TIMER_IDLE         0xFFFF
+
+typedef void (*SoftTimerCallback)(void);
+
+typedef struct SoftTimer {
+    uint32_t deadline;          /* soft_timer_ticks() count of the next expiry */
+    uint32_t timeout;           /* ticks from start to the first expiry */
+    uint32_t repeat;            /* period in ticks, 0: one shot */
+    SoftTimerCallback cb;
+    uint16_t heap_index;        /* position in the deadline heap, SOFT_TIMER_IDLE when stopped */
+} SoftTimer;
+
+void soft_timer_init(SoftTimer* timer, SoftTimerCallback cb, uint32_t timeout, uint32_t repeat);
+int  soft_timer_start(SoftTimer* timer);
+void soft_timer_stop(SoftTimer* timer);
+void soft_timer_ticks(void);
+void soft_timer_advance(uint32_t ticks);
+uint32_t soft_timer_now(void);
+SoftTimer* soft_timer_current(void);
+uint32_t soft_timer_next(void);
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * Host stand-in for the CMSIS Cortex-M0+ core header.
+ *
+ * The device header includes "core_cm0plus.h" by name, so with
+ * Utilities/HostEmu first on the include path this file replaces the ARM
+ * one: the core register types and bit definitions are kept, SCB/SysTick
+ * go through the core emulator and the intrinsics and NVIC functions are
+ * emulator calls instead of ARM instructions.
+ */
+
+#ifndef __CORE_CM0PLUS_H_GENERIC
+#define __CORE_CM0PLUS_H_GENERIC
+
+#include <stdint.h>
+#include "core_emu.h"
+
+#ifdef __cplusplus
+  #define   __I     volatile
+#else
+  #define   __I     volatile const
+#endif
+#define     __O     volatile
+#define     __IO    volatile
+#define     __IM    volatile const
+#define     __OM    volatile
+#define     __IOM   volatile
+
+#define __ASM                   __asm
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    __attribute__((always_inline)) static inline
+#define __NO_RETURN             __attribute__((__noreturn__))
+#define __USED                  __attribute__((used))
+#define __WEAK                  __attribute__((weak))
+#define __PACKED                __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __RESTRICT              __restrict
+
+#define __CM0PLUS_CMSIS_VERSION_MAIN  5U
+#define __CM0PLUS_CMSIS_VERSION_SUB   6U
+#define __CORTEX_M                    0U
+
+/* NVIC, only reached through the NVIC_ functions below */
+typedef struct
+{
+  __IOM uint32_t ISER[1U];
+        uint32_t RESERVED0[31U];
+  __IOM uint32_t ICER[1U];
+        uint32_t RSERVED1[31U];
+  __IOM uint32_t ISPR[1U];
+        uint32_t RESERVED2[31U];
+  __IOM uint32_t ICPR[1U];
+        uint32_t RESERVED3[31U];
+        uint32_t RESERVED4[64U];
+  __IOM uint32_t IP[8U];
+}  NVIC_Type;
+
+typedef struct
+{
+  __IM  uint32_t CPUID;
+  __IOM uint32_t ICSR;
+  __IOM uint32_t VTOR;
+  __IOM uint32_t AIRCR;
+  __IOM uint32_t SCR;
+  __IOM uint32_t CCR;
+        uint32_t RESERVED1;
+  __IOM uint32_t SHP[2U];
+  __IOM uint32_t SHCSR;
+} SCB_Type;
+
+#define SCB_ICSR_NMIPENDSET_Pos            31U
+#define SCB_ICSR_NMIPENDSET_Msk            (1UL << SCB_ICSR_NMIPENDSET_Pos)
+#define SCB_ICSR_PENDSVSET_Pos             28U
+#define SCB_ICSR_PENDSVSET_Msk             (1UL << SCB_ICSR_PENDSVSET_Pos)
+#define SCB_ICSR_PENDSVCLR_Pos             27U
+#define SCB_ICSR_PENDSVCLR_Msk             (1UL << SCB_ICSR_PENDSVCLR_Pos)
+#define SCB_ICSR_PENDSTSET_Pos             26U
+#define SCB_ICSR_PENDSTSET_Msk             (1UL << SCB_ICSR_PENDSTSET_Pos)
+#define SCB_ICSR_PENDSTCLR_Pos             25U
+#define SCB_ICSR_PENDSTCLR_Msk             (1UL << SCB_ICSR_PENDSTCLR_Pos)
+#define SCB_ICSR_ISRPENDING_Pos            22U
+#define SCB_ICSR_ISRPENDING_Msk            (1UL << SCB_ICSR_ISRPENDING_Pos)
+#define SCB_ICSR_VECTPENDING_Pos           12U
+#define SCB_ICSR_VECTPENDING_Msk           (0x1FFUL << SCB_ICSR_VECTPENDING_Pos)
+#define SCB_ICSR_VECTACTIVE_Pos             0U
+#define SCB_ICSR_VECTACTIVE_Msk            (0x1FFUL)
+
+#define SCB_AIRCR_VECTKEY_Pos              16U
+#define SCB_AIRCR_VECTKEY_Msk              (0xFFFFUL << SCB_AIRCR_VECTKEY_Pos)
+#define SCB_AIRCR_SYSRESETREQ_Pos           2U
+#define SCB_AIRCR_SYSRESETREQ_Msk          (1UL << SCB_AIRCR_SYSRESETREQ_Pos)
+
+#define SCB_SCR_SEVONPEND_Pos               4U
+#define SCB_SCR_SEVONPEND_Msk              (1UL << SCB_SCR_SEVONPEND_Pos)
+#define SCB_SCR_SLEEPDEEP_Pos               2U
+#define SCB_SCR_SLEEPDEEP_Msk              (1UL << SCB_SCR_SLEEPDEEP_Pos)
+#define SCB_SCR_SLEEPONEXIT_Pos             1U
+#define SCB_SCR_SLEEPONEXIT_Msk            (1UL << SCB_SCR_SLEEPONEXIT_Pos)
+
+typedef struct
+{
+  __IOM uint32_t CTRL;
+  __IOM uint32_t LOAD;
+  __IOM uint32_t VAL;
+  __IM  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_COUNTFLAG_Pos         16U
+#define SysTick_CTRL_COUNTFLAG_Msk         (1UL << SysTick_CTRL_COUNTFLAG_Pos)
+#define SysTick_CTRL_CLKSOURCE_Pos          2U
+#define SysTick_CTRL_CLKSOURCE_Msk         (1UL << SysTick_CTRL_CLKSOURCE_Pos)
+#define SysTick_CTRL_TICKINT_Pos            1U
+#define SysTick_CTRL_TICKINT_Msk           (1UL << SysTick_CTRL_TICKINT_Pos)
+#define SysTick_CTRL_ENABLE_Pos             0U
+#define SysTick_CTRL_ENABLE_Msk            (1UL)
+#define SysTick_LOAD_RELOAD_Pos             0U
+#define SysTick_LOAD_RELOAD_Msk            (0xFFFFFFUL)
+#define SysTick_VAL_CURRENT_Pos             0U
+#define SysTick_VAL_CURRENT_Msk            (0xFFFFFFUL)
+#define SysTick_CALIB_NOREF_Pos            31U
+#define SysTick_CALIB_NOREF_Msk            (1UL << SysTick_CALIB_NOREF_Pos)
+#define SysTick_CALIB_SKEW_Pos             30U
+#define SysTick_CALIB_SKEW_Msk             (1UL << SysTick_CALIB_SKEW_Pos)
+#define SysTick_CALIB_TENMS_Pos             0U
+#define SysTick_CALIB_TENMS_Msk            (0xFFFFFFUL)
+
+#define SCS_BASE            (0xE000E000UL)
+#define SysTick_BASE        (SCS_BASE +  0x0010UL)
+#define NVIC_BASE           (SCS_BASE +  0x0100UL)
+#define SCB_BASE            (SCS_BASE +  0x0D00UL)
+
+#define SCB                 ((SCB_Type       *) core_emu_periph(SCB_BASE))
+#define SysTick             ((SysTick_Type   *) core_emu_periph(SysTick_BASE))
+
+/* Intrinsics */
+#define __enable_irq()          core_emu_set_primask(0U)
+#define __disable_irq()         core_emu_set_primask(1U)
+#define __get_PRIMASK()         core_emu_get_primask()
+#define __set_PRIMASK(mask)     core_emu_set_primask(mask)
+#define __WFI()                 core_emu_wfi()
+#define __WFE()                 core_emu_wfe()
+#define __SEV()                 core_emu_sev()
+#define __NOP()                 core_emu_cost(1U)
+#define __DSB()                 core_emu_cost(3U)
+#define __DMB()                 core_emu_cost(3U)
+#define __ISB()                 core_emu_cost(3U)
+#define __REV(value)            __builtin_bswap32(value)
+#define __CLZ(value)            ((uint8_t)((value) ? __builtin_clz(value) : 32U))
+
+/* NVIC */
+#define NVIC_EnableIRQ(IRQn)              core_emu_nvic_enable((int)(IRQn), 1)
+#define NVIC_DisableIRQ(IRQn)             core_emu_nvic_enable((int)(IRQn), 0)
+#define NVIC_GetEnableIRQ(IRQn)           core_emu_nvic_enabled((int)(IRQn))
+#define NVIC_SetPendingIRQ(IRQn)          core_emu_nvic_pend((int)(IRQn), 1)
+#define NVIC_ClearPendingIRQ(IRQn)        core_emu_nvic_pend((int)(IRQn), 0)
+#define NVIC_GetPendingIRQ(IRQn)          core_emu_nvic_pending((int)(IRQn))
+#define NVIC_SetPriority(IRQn, priority)  core_emu_nvic_set_priority((int)(IRQn), (priority))
+#define NVIC_GetPriority(IRQn)            core_emu_nvic_get_priority((int)(IRQn))
+#define NVIC_SystemReset()                core_emu_fatal("NVIC_SystemReset")
+
+__STATIC_INLINE uint32_t SysTick_Config(uint32_t ticks)
+{
+  if ((ticks - 1UL) > SysTick_LOAD_RELOAD_Msk)
+  {
+    return (1UL);
+  }
+
+  SysTick->LOAD  = (uint32_t)(ticks - 1UL);
+  NVIC_SetPriority (SysTick_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+  SysTick->VAL   = 0UL;
+  SysTick->CTRL  = SysTick_CTRL_CLKSOURCE_Msk |
+                   SysTick_CTRL_TICKINT_Msk   |
+                   SysTick_CTRL_ENABLE_Msk;
+  return (0UL);
+}
+
+#endif
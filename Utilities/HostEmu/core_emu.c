@@ -0,0 +1,794 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wb32l003.h>
+
+#define BLOCK_WORDS             256
+#define BLOCK_MAX               48
+#define EVENT_MAX               64
+#define NEST_MAX                8
+
+#define EXC_BIT(exc)            (1ULL << (exc))
+#define SYSTEM_EXC              (EXC_BIT(CORE_EMU_EXC_PENDSV) | EXC_BIT(CORE_EMU_EXC_SYSTICK))
+#define THREAD_PRIORITY         4
+
+/* SCB and SysTick register word offsets */
+#define SCB_ICSR                1
+#define SCB_AIRCR               3
+#define SCB_SCR                 4
+#define SCB_SHP1                8
+#define ST_CTRL                 0
+#define ST_LOAD                 1
+#define ST_VAL                  2
+#define ST_CALIB                3
+
+typedef struct {
+    uint32_t base;
+    uint8_t accessed;
+    uint32_t regs[BLOCK_WORDS];
+} Block;
+
+typedef struct {
+    uint64_t cycle;
+    void (*fn)(void* arg);
+    void* arg;
+} Event;
+
+typedef struct {
+    int exc;
+    int priority;
+    uint64_t entry;
+    uint64_t preempted;
+    uint64_t host_entry;
+    uint64_t host_preempted;
+} Frame;
+
+static Block blocks[BLOCK_MAX];
+static uint32_t block_num;
+static CoreEmuModel* models;
+static uint8_t powered;
+
+static uint64_t cycles;
+static Event events[EVENT_MAX];
+static uint32_t event_num;
+static int sleep_mode;
+
+static uint64_t pending;
+static uint64_t lines;
+static uint64_t enabled;
+static uint32_t primask;
+static uint8_t event_reg;
+static Frame stack[NEST_MAX];
+static int depth;
+static uint32_t storm[CORE_EMU_EXC_NUM];
+static uint64_t irq_off_at;
+
+static CoreEmuStats stats;
+static CoreEmuIrqStats irq_stats[CORE_EMU_EXC_NUM];
+
+/*-------------------------------------------------------------------------*/
+/* Vector table, weak so the module under test provides the handlers       */
+/*-------------------------------------------------------------------------*/
+
+static void unhandled(int exc)
+{
+    core_emu_fatal("exception %d taken without a handler", exc);
+}
+
+#define HANDLER(name, exc) \
+    void name(void) __attribute__((weak)); \
+    void name(void) { unhandled(exc); }
+
+HANDLER(PendSV_Handler,     14)
+HANDLER(SysTick_Handler,    15)
+HANDLER(GPIOA_IRQHandler,   16)
+HANDLER(GPIOB_IRQHandler,   17)
+HANDLER(GPIOC_IRQHandler,   18)
+HANDLER(GPIOD_IRQHandler,   19)
+HANDLER(FLASH_IRQHandler,   20)
+HANDLER(UART1_IRQHandler,   22)
+HANDLER(UART2_IRQHandler,   23)
+HANDLER(LPUART_IRQHandler,  24)
+HANDLER(SPI_IRQHandler,     26)
+HANDLER(I2C_IRQHandler,     28)
+HANDLER(TIM10_IRQHandler,   30)
+HANDLER(TIM11_IRQHandler,   31)
+HANDLER(LPTIM_IRQHandler,   32)
+HANDLER(TIM1_IRQHandler,    34)
+HANDLER(TIM2_IRQHandler,    35)
+HANDLER(PCA_IRQHandler,     37)
+HANDLER(WWDG_IRQHandler,    38)
+HANDLER(IWDG_IRQHandler,    39)
+HANDLER(ADC_IRQHandler,     40)
+HANDLER(LVD_IRQHandler,     41)
+HANDLER(VCMP_IRQHandler,    42)
+HANDLER(AWK_IRQHandler,     44)
+HANDLER(OWIRE_IRQHandler,   45)
+HANDLER(RTC_IRQHandler,     46)
+HANDLER(CLKTRIM_IRQHandler, 47)
+
+static void (* const vectors[CORE_EMU_EXC_NUM])(void) = {
+    [14] = PendSV_Handler,      [15] = SysTick_Handler,
+    [16] = GPIOA_IRQHandler,    [17] = GPIOB_IRQHandler,
+    [18] = GPIOC_IRQHandler,    [19] = GPIOD_IRQHandler,
+    [20] = FLASH_IRQHandler,    [22] = UART1_IRQHandler,
+    [23] = UART2_IRQHandler,    [24] = LPUART_IRQHandler,
+    [26] = SPI_IRQHandler,      [28] = I2C_IRQHandler,
+    [30] = TIM10_IRQHandler,    [31] = TIM11_IRQHandler,
+    [32] = LPTIM_IRQHandler,    [34] = TIM1_IRQHandler,
+    [35] = TIM2_IRQHandler,     [37] = PCA_IRQHandler,
+    [38] = WWDG_IRQHandler,     [39] = IWDG_IRQHandler,
+    [40] = ADC_IRQHandler,      [41] = LVD_IRQHandler,
+    [42] = VCMP_IRQHandler,     [44] = AWK_IRQHandler,
+    [45] = OWIRE_IRQHandler,    [46] = RTC_IRQHandler,
+    [47] = CLKTRIM_IRQHandler,
+};
+
+/*-------------------------------------------------------------------------*/
+/* Register blocks                                                         */
+/*-------------------------------------------------------------------------*/
+
+static Block* block_find(uint32_t base)
+{
+    uint32_t i;
+
+    for (i = 0; i < block_num; i++)
+    {
+        if (blocks[i].base == base)
+            return &blocks[i];
+    }
+    if (block_num == BLOCK_MAX)
+        core_emu_fatal("no room for the register block at 0x%08X", (unsigned)base);
+
+    blocks[block_num].base = base;
+    return &blocks[block_num++];
+}
+
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*-------------------------------------------------------------------------*/
+/* Exceptions                                                              */
+/*-------------------------------------------------------------------------*/
+
+static int exc_priority(int exc)
+{
+    if (exc == CORE_EMU_EXC_PENDSV)
+        return (int)((block_find(SCB_BASE)->regs[SCB_SHP1] >> 22) & 0x3);
+    if (exc == CORE_EMU_EXC_SYSTICK)
+        return (int)((block_find(SCB_BASE)->regs[SCB_SHP1] >> 30) & 0x3);
+    return ((const uint8_t*)&block_find(NVIC_BASE)->regs[0xC0])[exc - CORE_EMU_EXC_IRQ0] >> 6;
+}
+
+static int current_priority(void)
+{
+    return depth ? stack[depth - 1].priority : THREAD_PRIORITY;
+}
+
+/* Highest priority request that would preempt, lowest number on a tie */
+static int next_exception(void)
+{
+    uint64_t requests = (pending | lines) & (enabled | SYSTEM_EXC);
+    int best = -1;
+    int best_priority = current_priority();
+    int exc;
+
+    for (exc = CORE_EMU_EXC_PENDSV; requests >> exc; exc++)
+    {
+        if ((requests & EXC_BIT(exc)) && exc_priority(exc) < best_priority)
+        {
+            best = exc;
+            best_priority = exc_priority(exc);
+        }
+    }
+    return best;
+}
+
+static void sync_models(void)
+{
+    CoreEmuModel* m;
+    uint32_t i;
+
+    for (m = models; m; m = m->next)
+        m->sync();
+    for (i = 0; i < block_num; i++)
+        blocks[i].accessed = 0;
+}
+
+static void take(int exc)
+{
+    Frame* frame;
+    uint64_t total, host_total;
+    CoreEmuIrqStats* st = &irq_stats[exc];
+
+    if (depth == NEST_MAX)
+        core_emu_fatal("exception %d nested %d deep", exc, depth);
+
+    pending &= ~EXC_BIT(exc);
+    cycles += CORE_EMU_ENTRY_CYCLES;
+
+    frame = &stack[depth++];
+    frame->exc = exc;
+    frame->priority = exc_priority(exc);
+    frame->entry = cycles;
+    frame->preempted = 0;
+    frame->host_entry = host_ns();
+    frame->host_preempted = 0;
+
+    vectors[exc]();
+
+    /* the last register write of the handler lands before the return */
+    sync_models();
+
+    total = cycles - frame->entry;
+    host_total = host_ns() - frame->host_entry;
+    st->taken++;
+    st->cycles += total - frame->preempted;
+    if (total - frame->preempted > st->max_cycles)
+        st->max_cycles = total - frame->preempted;
+    st->host_ns += host_total - frame->host_preempted;
+    if (host_total - frame->host_preempted > st->max_host_ns)
+        st->max_host_ns = host_total - frame->host_preempted;
+
+    cycles += CORE_EMU_EXIT_CYCLES;
+    depth--;
+    if (depth)
+    {
+        stack[depth - 1].preempted += total + CORE_EMU_ENTRY_CYCLES + CORE_EMU_EXIT_CYCLES;
+        stack[depth - 1].host_preempted += host_total;
+    }
+
+    if (lines & EXC_BIT(exc))
+    {
+        if (++storm[exc] >= CORE_EMU_STORM)
+            core_emu_fatal("interrupt storm, exception %d returns with its request still high", exc);
+    }
+    else
+    {
+        storm[exc] = 0;
+    }
+}
+
+static void dispatch(void)
+{
+    int exc;
+
+    while (!primask && (exc = next_exception()) >= 0)
+        take(exc);
+}
+
+static void fire_events(void)
+{
+    while (event_num && events[0].cycle <= cycles)
+    {
+        Event ev = events[0];
+
+        memmove(&events[0], &events[1], (event_num - 1) * sizeof(Event));
+        event_num--;
+        ev.fn(ev.arg);
+    }
+}
+
+static uint64_t next_event(void)
+{
+    uint64_t next = event_num ? events[0].cycle : CORE_EMU_NO_EVENT;
+    CoreEmuModel* m;
+
+    for (m = models; m; m = m->next)
+    {
+        uint64_t at = m->next_event ? m->next_event() : CORE_EMU_NO_EVENT;
+        if (at < next)
+            next = at;
+    }
+    return next;
+}
+
+/* Jump to the cycle, events and models see it, interrupts are left to the caller */
+static void advance_to(uint64_t cycle)
+{
+    if (cycle > cycles)
+        cycles = cycle;
+    fire_events();
+    sync_models();
+}
+
+static void tick(uint32_t n)
+{
+    advance_to(cycles + n);
+    dispatch();
+}
+
+/*-------------------------------------------------------------------------*/
+/* SCB and SysTick                                                         */
+/*-------------------------------------------------------------------------*/
+
+static uint32_t scb_icsr;
+
+static uint32_t scb_icsr_value(void)
+{
+    uint32_t value = depth ? (uint32_t)stack[depth - 1].exc : 0;
+
+    if (pending & EXC_BIT(CORE_EMU_EXC_PENDSV))
+        value |= SCB_ICSR_PENDSVSET_Msk;
+    if (pending & EXC_BIT(CORE_EMU_EXC_SYSTICK))
+        value |= SCB_ICSR_PENDSTSET_Msk;
+    if ((pending | lines) & enabled)
+        value |= SCB_ICSR_ISRPENDING_Msk;
+    return value;
+}
+
+static void scb_reset(void)
+{
+    uint32_t* r = block_find(SCB_BASE)->regs;
+
+    r[0] = 0x410CC601;
+    scb_icsr = r[SCB_ICSR] = 0;
+}
+
+static void scb_sync(void)
+{
+    uint32_t* r = block_find(SCB_BASE)->regs;
+
+    if (r[SCB_ICSR] != scb_icsr)
+    {
+        uint32_t set = r[SCB_ICSR] & ~scb_icsr;
+
+        if (set & SCB_ICSR_PENDSVSET_Msk)
+            pending |= EXC_BIT(CORE_EMU_EXC_PENDSV);
+        if (r[SCB_ICSR] & SCB_ICSR_PENDSVCLR_Msk)
+            pending &= ~EXC_BIT(CORE_EMU_EXC_PENDSV);
+        if (set & SCB_ICSR_PENDSTSET_Msk)
+            pending |= EXC_BIT(CORE_EMU_EXC_SYSTICK);
+        if (r[SCB_ICSR] & SCB_ICSR_PENDSTCLR_Msk)
+            pending &= ~EXC_BIT(CORE_EMU_EXC_SYSTICK);
+    }
+    scb_icsr = r[SCB_ICSR] = scb_icsr_value();
+
+    if (r[SCB_AIRCR] & SCB_AIRCR_SYSRESETREQ_Msk)
+        core_emu_fatal("system reset requested");
+}
+
+static CoreEmuModel scb_model = { scb_reset, scb_sync, NULL, NULL };
+
+static struct {
+    uint32_t ctrl;              /* CTRL as last presented, COUNTFLAG included */
+    uint32_t val;               /* VAL as last presented */
+    uint32_t count;
+    uint8_t flag;
+    uint64_t clock;             /* SysTick clocks counted so far */
+} st;
+
+static uint32_t systick_div(void)
+{
+    /* CLKSOURCE clear: HCLK/4 on this part */
+    return (st.ctrl & SysTick_CTRL_CLKSOURCE_Msk) ? 1 : 4;
+}
+
+static int systick_running(void)
+{
+    return (st.ctrl & SysTick_CTRL_ENABLE_Msk) && sleep_mode != CORE_EMU_DEEPSLEEP;
+}
+
+/* Count n clocks, returns 1 when the counter reached zero */
+static int systick_count(uint64_t n)
+{
+    uint32_t load = block_find(SysTick_BASE)->regs[ST_LOAD] & SysTick_LOAD_RELOAD_Msk;
+    uint64_t rem;
+    int wrapped = 0;
+
+    if (n == 0)
+        return 0;
+    if (st.count)
+    {
+        if (n < st.count)
+        {
+            st.count -= (uint32_t)n;
+            return 0;
+        }
+        n -= st.count;
+        st.count = 0;
+        wrapped = 1;
+    }
+    if (n == 0 || load == 0)
+        return wrapped;
+
+    /* at zero the next clock reloads, LOAD more clocks reach zero again */
+    if (n >= (uint64_t)load + 1)
+        wrapped = 1;
+    rem = n % ((uint64_t)load + 1);
+    st.count = rem ? load - (uint32_t)(rem - 1) : 0;
+    return wrapped;
+}
+
+static void systick_reset(void)
+{
+    uint32_t* r = block_find(SysTick_BASE)->regs;
+
+    memset(&st, 0, sizeof(st));
+    r[ST_CALIB] = SysTick_CALIB_NOREF_Msk | (CORE_EMU_HCLK / 100 - 1);
+}
+
+static void systick_sync(void)
+{
+    uint32_t* r = block_find(SysTick_BASE)->regs;
+    uint64_t clock = cycles / systick_div();
+    int wrapped = 0;
+
+    /* catch up with the configuration in effect since the last sync */
+    if (systick_running())
+        wrapped = systick_count(clock - st.clock);
+    st.clock = clock;
+    if (wrapped)
+    {
+        st.flag = 1;
+        if (st.ctrl & SysTick_CTRL_TICKINT_Msk)
+            pending |= EXC_BIT(CORE_EMU_EXC_SYSTICK);
+    }
+    else if (core_emu_accessed(SysTick_BASE) && (st.ctrl & SysTick_CTRL_COUNTFLAG_Msk))
+    {
+        /* COUNTFLAG clears when read, the access after it showed up */
+        st.flag = 0;
+    }
+
+    /* any write to VAL clears the counter and COUNTFLAG */
+    if (r[ST_VAL] != st.val)
+    {
+        st.count = 0;
+        st.flag = 0;
+    }
+    if ((r[ST_CTRL] ^ st.ctrl) & ~SysTick_CTRL_COUNTFLAG_Msk)
+        st.clock = cycles / ((r[ST_CTRL] & SysTick_CTRL_CLKSOURCE_Msk) ? 1 : 4);
+
+    st.ctrl = r[ST_CTRL] = (r[ST_CTRL] & 0x7) | (st.flag ? SysTick_CTRL_COUNTFLAG_Msk : 0);
+    st.val = r[ST_VAL] = st.count;
+}
+
+static uint64_t systick_next_event(void)
+{
+    uint32_t load = block_find(SysTick_BASE)->regs[ST_LOAD] & SysTick_LOAD_RELOAD_Msk;
+    uint64_t to_zero;
+
+    if (!systick_running() || !(st.ctrl & SysTick_CTRL_TICKINT_Msk))
+        return CORE_EMU_NO_EVENT;
+    if (st.count)
+        to_zero = st.count;
+    else if (load)
+        to_zero = (uint64_t)load + 1;
+    else
+        return CORE_EMU_NO_EVENT;
+    return (st.clock + to_zero) * systick_div();
+}
+
+static CoreEmuModel systick_model = { systick_reset, systick_sync, systick_next_event, NULL };
+
+/*-------------------------------------------------------------------------*/
+/* Public                                                                  */
+/*-------------------------------------------------------------------------*/
+
+void core_emu_model(CoreEmuModel* model)
+{
+    model->next = models;
+    models = model;
+}
+
+void core_emu_reset(void)
+{
+    CoreEmuModel* m;
+    uint32_t i;
+
+    if (!powered)
+    {
+        powered = 1;
+        core_emu_model(&scb_model);
+        core_emu_model(&systick_model);
+    }
+
+    cycles = 0;
+    event_num = 0;
+    sleep_mode = CORE_EMU_RUN;
+    pending = 0;
+    lines = 0;
+    enabled = 0;
+    primask = 0;
+    event_reg = 0;
+    depth = 0;
+    memset(storm, 0, sizeof(storm));
+    core_emu_clear_stats();
+
+    for (i = 0; i < block_num; i++)
+        memset(blocks[i].regs, 0, sizeof(blocks[i].regs));
+    for (m = models; m; m = m->next)
+        m->reset();
+    sync_models();
+}
+
+uint64_t core_emu_cycles(void)
+{
+    return cycles;
+}
+
+/*
+ * Core work with no bus access. With every access applied and nothing
+ * due before its end it only moves the clock: the models catch up at
+ * the next access or event, as they would have at each cycle.
+ */
+void core_emu_cost(uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < block_num; i++)
+    {
+        if (blocks[i].accessed)
+        {
+            tick(n);
+            return;
+        }
+    }
+    if (next_event() <= cycles + n)
+    {
+        tick(n);
+        return;
+    }
+    cycles += n;
+    dispatch();
+}
+
+/* The thread idles for n cycles, events and interrupts run on time */
+void core_emu_run(uint64_t n)
+{
+    uint64_t end = cycles + n;
+
+    /* the last register write takes effect before the idle */
+    advance_to(cycles);
+    dispatch();
+    while (cycles < end)
+    {
+        uint64_t next = next_event();
+
+        if (next > end)
+            next = end;
+        if (next <= cycles)
+            next = cycles + 1;
+        advance_to(next);
+        dispatch();
+    }
+}
+
+/* Call fn at the cycle, to script pin levels or bytes on a line */
+void core_emu_at(uint64_t cycle, void (*fn)(void* arg), void* arg)
+{
+    uint32_t i;
+
+    if (event_num == EVENT_MAX)
+        core_emu_fatal("more than %d scheduled events", EVENT_MAX);
+
+    for (i = event_num; i && events[i - 1].cycle > cycle; i--)
+        events[i] = events[i - 1];
+    events[i].cycle = cycle;
+    events[i].fn = fn;
+    events[i].arg = arg;
+    event_num++;
+}
+
+int core_emu_sleep_mode(void)
+{
+    return sleep_mode;
+}
+
+void* core_emu_periph(uint32_t base)
+{
+    Block* b = block_find(base);
+
+    if (!powered)
+        core_emu_reset();
+    tick(CORE_EMU_BUS_CYCLES);
+    b->accessed = 1;
+    return b->regs;
+}
+
+uint32_t* core_emu_regs(uint32_t base)
+{
+    return block_find(base)->regs;
+}
+
+int core_emu_accessed(uint32_t base)
+{
+    return block_find(base)->accessed;
+}
+
+void core_emu_sync(void)
+{
+    sync_models();
+}
+
+uint32_t core_emu_get_primask(void)
+{
+    return primask;
+}
+
+void core_emu_set_primask(uint32_t mask)
+{
+    mask &= 1;
+    if (mask && !primask)
+    {
+        irq_off_at = cycles;
+    }
+    else if (!mask && primask)
+    {
+        stats.irq_off_total += cycles - irq_off_at;
+        if (cycles - irq_off_at > stats.irq_off_max)
+            stats.irq_off_max = cycles - irq_off_at;
+    }
+    primask = mask;
+    tick(1);
+}
+
+/* A request that would preempt with PRIMASK clear wakes the core */
+static int wake_pending(void)
+{
+    uint64_t requests = (pending | lines) & (enabled | SYSTEM_EXC);
+    int exc;
+
+    for (exc = CORE_EMU_EXC_PENDSV; requests >> exc; exc++)
+    {
+        if ((requests & EXC_BIT(exc)) && exc_priority(exc) < current_priority())
+            return 1;
+    }
+    return 0;
+}
+
+void core_emu_wfi(void)
+{
+    uint64_t start;
+
+    tick(1);
+    stats.wfi++;
+    if (wake_pending())
+        return;
+
+    sleep_mode = (block_find(SCB_BASE)->regs[SCB_SCR] & SCB_SCR_SLEEPDEEP_Msk) ?
+                 CORE_EMU_DEEPSLEEP : CORE_EMU_SLEEP;
+    start = cycles;
+    while (!wake_pending())
+    {
+        uint64_t next = next_event();
+
+        if (next == CORE_EMU_NO_EVENT)
+            core_emu_fatal("WFI at cycle %llu with no wake source", (unsigned long long)cycles);
+        if (next <= cycles)
+            next = cycles + 1;
+        advance_to(next);
+    }
+    if (sleep_mode == CORE_EMU_DEEPSLEEP)
+        stats.deepsleep_cycles += cycles - start;
+    else
+        stats.sleep_cycles += cycles - start;
+    sleep_mode = CORE_EMU_RUN;
+    dispatch();
+}
+
+void core_emu_wfe(void)
+{
+    if (event_reg)
+    {
+        event_reg = 0;
+        tick(1);
+        return;
+    }
+    core_emu_wfi();
+}
+
+void core_emu_sev(void)
+{
+    event_reg = 1;
+    tick(1);
+}
+
+void core_emu_irq_level(int irqn, int level)
+{
+    if (level)
+        lines |= EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn);
+    else
+        lines &= ~EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn);
+}
+
+void core_emu_irq_pulse(int irqn)
+{
+    pending |= EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn);
+}
+
+int core_emu_active(void)
+{
+    return depth ? stack[depth - 1].exc : 0;
+}
+
+void core_emu_nvic_enable(int irqn, int on)
+{
+    if (irqn >= 0)
+    {
+        if (on)
+            enabled |= EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn);
+        else
+            enabled &= ~EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn);
+        block_find(NVIC_BASE)->regs[0x00] = (uint32_t)(enabled >> CORE_EMU_EXC_IRQ0);
+        block_find(NVIC_BASE)->regs[0x20] = (uint32_t)(enabled >> CORE_EMU_EXC_IRQ0);
+    }
+    tick(CORE_EMU_BUS_CYCLES);
+}
+
+uint32_t core_emu_nvic_enabled(int irqn)
+{
+    return irqn >= 0 && (enabled & EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn)) ? 1 : 0;
+}
+
+void core_emu_nvic_pend(int irqn, int on)
+{
+    if (on)
+        pending |= EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn);
+    else
+        pending &= ~EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn);
+    tick(CORE_EMU_BUS_CYCLES);
+}
+
+uint32_t core_emu_nvic_pending(int irqn)
+{
+    return ((pending | lines) & EXC_BIT(CORE_EMU_EXC_IRQ0 + irqn)) ? 1 : 0;
+}
+
+void core_emu_nvic_set_priority(int irqn, uint32_t priority)
+{
+    uint8_t value = (uint8_t)((priority & 0x3) << 6);
+
+    if (irqn >= 0)
+    {
+        ((uint8_t*)&block_find(NVIC_BASE)->regs[0xC0])[irqn] = value;
+    }
+    else
+    {
+        uint32_t shift = ((uint32_t)irqn & 0x3) * 8;
+        uint32_t* shp = &block_find(SCB_BASE)->regs[SCB_SHP1];
+        *shp = (*shp & ~(0xFFUL << shift)) | ((uint32_t)value << shift);
+    }
+    tick(CORE_EMU_BUS_CYCLES);
+}
+
+uint32_t core_emu_nvic_get_priority(int irqn)
+{
+    return (uint32_t)exc_priority(CORE_EMU_EXC_IRQ0 + irqn);
+}
+
+const CoreEmuStats* core_emu_stats(void)
+{
+    return &stats;
+}
+
+const CoreEmuIrqStats* core_emu_irq_stats(int irqn)
+{
+    return &irq_stats[CORE_EMU_EXC_IRQ0 + irqn];
+}
+
+void core_emu_clear_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(irq_stats, 0, sizeof(irq_stats));
+    irq_off_at = cycles;
+}
+
+void core_emu_fatal(const char* fmt, ...)
+{
+    va_list ap;
+
+    fprintf(stderr, "core_emu @%llu: ", (unsigned long long)cycles);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    exit(3);
+}
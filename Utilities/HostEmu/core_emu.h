@@ -0,0 +1,116 @@
+#ifndef __CORE_EMU_H
+#define __CORE_EMU_H
+#include <stdint.h>
+
+/*
+ * Cortex-M0+ core and bus model for host builds of the firmware modules.
+ *
+ * Time is virtual and counted in HCLK cycles. Host code runs for free,
+ * every peripheral register access costs CORE_EMU_BUS_CYCLES, __NOP()
+ * one cycle, and exception entry and return their M0+ latencies, so
+ * busy polls of a timer register advance the clock deterministically.
+ *
+ * Peripheral registers live in host memory. The device header maps each
+ * peripheral pointer to core_emu_periph(), which charges the access,
+ * lets the models apply the previous access and catch up to the current
+ * cycle, takes pending interrupts, and then returns the register block.
+ *
+ * Interrupts: PRIMASK, NVIC enable/pending/priority for the device IRQs
+ * plus PendSV and SysTick, preemption by priority and nesting. Models
+ * drive level lines, a handler that returns with its line still high is
+ * entered again and flagged as an interrupt storm after CORE_EMU_STORM.
+ * Handlers are the startup file names, weak here so the module under
+ * test overrides them.
+ *
+ * __WFI() sleeps until an enabled interrupt is pending: the clock jumps
+ * to the next model or scheduled event, with the HCLK domain (SysTick,
+ * BASETIM, UARTs) stopped while SLEEPDEEP is set.
+ */
+
+#define CORE_EMU_HCLK           24000000UL
+#define CORE_EMU_BUS_CYCLES     2U      /* one peripheral register access */
+#define CORE_EMU_ENTRY_CYCLES   16U     /* exception entry, M0+ zero wait state */
+#define CORE_EMU_EXIT_CYCLES    12U     /* exception return */
+#define CORE_EMU_STORM          10000U  /* back to back entries with the line high */
+#define CORE_EMU_NO_EVENT       UINT64_MAX
+
+#define CORE_EMU_EXC_PENDSV     14
+#define CORE_EMU_EXC_SYSTICK    15
+#define CORE_EMU_EXC_IRQ0       16
+#define CORE_EMU_EXC_NUM        48
+
+#define CORE_EMU_RUN            0
+#define CORE_EMU_SLEEP          1
+#define CORE_EMU_DEEPSLEEP      2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CoreEmuModel {
+    void (*reset)(void);            /* power on values of the registers */
+    void (*sync)(void);             /* apply register writes, catch up to now */
+    uint64_t (*next_event)(void);   /* next cycle with a change of its own */
+    struct CoreEmuModel* next;
+} CoreEmuModel;
+
+typedef struct {
+    uint64_t taken;
+    uint64_t cycles;                /* handler cycles, preempting ones excluded */
+    uint64_t max_cycles;
+    uint64_t host_ns;               /* host time spent in the handler */
+    uint64_t max_host_ns;
+} CoreEmuIrqStats;
+
+typedef struct {
+    uint64_t irq_off_max;           /* longest PRIMASK window, cycles */
+    uint64_t irq_off_total;
+    uint64_t sleep_cycles;          /* time in WFI without SLEEPDEEP */
+    uint64_t deepsleep_cycles;      /* time in WFI with SLEEPDEEP */
+    uint32_t wfi;
+} CoreEmuStats;
+
+/* Virtual time */
+void core_emu_reset(void);
+uint64_t core_emu_cycles(void);
+void core_emu_cost(uint32_t cycles);
+void core_emu_run(uint64_t cycles);
+void core_emu_at(uint64_t cycle, void (*fn)(void* arg), void* arg);
+int  core_emu_sleep_mode(void);
+
+/* Peripheral bus */
+void* core_emu_periph(uint32_t base);
+uint32_t* core_emu_regs(uint32_t base);
+int  core_emu_accessed(uint32_t base);
+void core_emu_sync(void);
+void core_emu_model(CoreEmuModel* model);
+
+/* Interrupts */
+uint32_t core_emu_get_primask(void);
+void core_emu_set_primask(uint32_t mask);
+void core_emu_wfi(void);
+void core_emu_wfe(void);
+void core_emu_sev(void);
+void core_emu_irq_level(int irqn, int level);
+void core_emu_irq_pulse(int irqn);
+int  core_emu_active(void);
+void core_emu_nvic_enable(int irqn, int on);
+uint32_t core_emu_nvic_enabled(int irqn);
+void core_emu_nvic_pend(int irqn, int on);
+uint32_t core_emu_nvic_pending(int irqn);
+void core_emu_nvic_set_priority(int irqn, uint32_t priority);
+uint32_t core_emu_nvic_get_priority(int irqn);
+
+/* Measurements */
+const CoreEmuStats* core_emu_stats(void);
+const CoreEmuIrqStats* core_emu_irq_stats(int irqn);
+void core_emu_clear_stats(void);
+
+__attribute__((noreturn, format(printf, 1, 2)))
+void core_emu_fatal(const char* fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+#include <stddef.h>
+#include <wb32l003.h>
+#include "crc_emu.h"
+
+#define SHOWN_BIT               0x80000000UL
+
+static uint16_t reg;            /* the shift register */
+static uint32_t shown;          /* RESULT as last presented */
+static uint64_t bytes;
+
+/* Window write of the previous access, applied at the next one */
+static union {
+    uint8_t  b;
+    uint16_t h;
+    uint32_t w;
+} staged;
+static uint8_t staged_size;
+
+static void shift(uint8_t byte)
+{
+    uint8_t bit;
+
+    reg ^= byte;
+    for (bit = 0; bit < 8; bit++)
+        reg = (reg & 1) ? (reg >> 1) ^ CRC_EMU_POLY : reg >> 1;
+    bytes++;
+}
+
+static void crc_reset(void)
+{
+    CRC_TypeDef* r = (CRC_TypeDef*)core_emu_regs(CRC_BASE);
+
+    reg = 0xFFFF;
+    bytes = 0;
+    staged_size = 0;
+    shown = r->RESULT = SHOWN_BIT | (reg ^ CRC_EMU_XOROUT);
+}
+
+static void crc_sync(void)
+{
+    CRC_TypeDef* r = (CRC_TypeDef*)core_emu_regs(CRC_BASE);
+    RCC_TypeDef* rcc = (RCC_TypeDef*)core_emu_regs(RCC_BASE);
+    uint32_t value = staged_size == 1 ? staged.b : staged_size == 2 ? staged.h : staged.w;
+    uint8_t i;
+
+    if (rcc->PERIRST & RCC_PERIRST_CRCRST)
+    {
+        reg = 0xFFFF;
+        staged_size = 0;
+    }
+    else if (rcc_emu_hclk_on(RCC_HCLKEN_CRCCKEN))
+    {
+        if (r->RESULT != shown)
+            reg = (uint16_t)(r->RESULT & CRC_RESULT_RESULT_Msk);
+        for (i = 0; i < staged_size; i++)
+            shift((uint8_t)(value >> (8 * i)));
+    }
+    staged_size = 0;
+    shown = r->RESULT = SHOWN_BIT | (reg ^ CRC_EMU_XOROUT);
+}
+
+static CoreEmuModel crc_model = { crc_reset, crc_sync, NULL, NULL };
+
+__attribute__((constructor)) static void crc_emu_register(void)
+{
+    core_emu_model(&crc_model);
+}
+
+static void stage(uint32_t addr, uint8_t size)
+{
+    uint32_t offset = addr - CRC_BASE;
+
+    if (offset < CRC_EMU_WINDOW || offset + size > CRC_EMU_WINDOW + CRC_EMU_WINDOW_SIZE || (offset & (size - 1)))
+        core_emu_fatal("%u byte CRC data write at 0x%08X, outside the window or unaligned",
+                       (unsigned)size, (unsigned)addr);
+
+    /* one bus access, the previous write lands first */
+    core_emu_periph(CRC_BASE);
+    staged_size = size;
+}
+
+volatile uint8_t* crc_emu_data8(uint32_t addr)
+{
+    stage(addr, 1);
+    return &staged.b;
+}
+
+volatile uint16_t* crc_emu_data16(uint32_t addr)
+{
+    stage(addr, 2);
+    return &staged.h;
+}
+
+volatile uint32_t* crc_emu_data32(uint32_t addr)
+{
+    stage(addr, 4);
+    return &staged.w;
+}
+
+uint64_t crc_emu_bytes(void)
+{
+    core_emu_sync();
+    return bytes;
+}
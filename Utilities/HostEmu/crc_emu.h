@@ -0,0 +1,41 @@
+#ifndef __CRC_EMU_H
+#define __CRC_EMU_H
+#include <stdint.h>
+
+/*
+ * CRC unit model: a 16 bit shift register with polynomial 0x1021 taken
+ * LSB first (0x8408). RESULT reads as the register ^ CRC_EMU_XOROUT, a
+ * write to RESULT loads the register itself, so CRC_InitResult() seeds
+ * 0xFFFF and CRC_Calculate() returns the CRC-16/X-25 value.
+ *
+ * The data window CRC_BASE + 0x80 ~ 0xFF takes byte, halfword and word
+ * writes through the M8/M16/M32 accessors, one bus access each. A wider
+ * write is processed as its bytes, least significant first. The window
+ * is write only, every accessor use counts as a write. Writes with the
+ * HCLKEN CRC gate off are lost, PERIRST.CRCRST reseeds the register.
+ *
+ * RESULT reads with bit 31 set so any value written differs from it and
+ * is seen as a write, the driver masks it with CRC_RESULT_RESULT_Msk.
+ */
+
+#define CRC_EMU_POLY            0x8408
+#define CRC_EMU_XOROUT          0xFFFF
+#define CRC_EMU_WINDOW          0x80    /* data window offset */
+#define CRC_EMU_WINDOW_SIZE     0x80
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+volatile uint8_t*  crc_emu_data8(uint32_t addr);
+volatile uint16_t* crc_emu_data16(uint32_t addr);
+volatile uint32_t* crc_emu_data32(uint32_t addr);
+
+/* Bytes shifted through the register since reset */
+uint64_t crc_emu_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,310 @@
+#include <stddef.h>
+#include <string.h>
+#include <wb32l003.h>
+
+#define BYPASS_KEY1             0x5A5A
+#define BYPASS_KEY2             0xA5A5
+
+#define CR_OP                   0x3
+#define CR_BUSY                 0x4
+#define OP_PROGRAM              1
+#define OP_SECTORERASE          2
+#define OP_CHIPERASE            3
+
+#define US(us)                  ((uint64_t)(us) * (CORE_EMU_HCLK / 1000000))
+
+/*
+ * Defaults: the driver's FLASH_OP_Delay() loop costs nothing here, so an
+ * operation must fit in FLASH_TIMEOUT_VALUE BUSY polls of one bus access
+ * each, 4166 us at CORE_EMU_HCLK.
+ */
+static const FlashEmuTiming timing_default = {
+    20,         /* program_us */
+    4000,       /* erase_us */
+    4000,       /* chip_erase_us */
+};
+
+static FLASH_TypeDef last;
+static uint8_t mem[FLASH_EMU_SIZE];
+static uint32_t erase_count[FLASH_EMU_PAGES];
+static FlashEmuTiming timing;
+static FlashEmuStats stats;
+static uint64_t busy_until;
+static uint8_t unlocked;
+static uint8_t blank;
+static uint32_t fail_after;     /* operations still done before the drops */
+static uint32_t fail_count;     /* operations dropped then */
+
+/* Data access of the M8/M16/M32 accessors, applied at the next access */
+static union {
+    uint8_t  b;
+    uint16_t h;
+    uint32_t w;
+} staged;
+static uint32_t staged_read;    /* what the access read, a write changes it */
+static uint32_t staged_addr;
+static uint8_t staged_size;
+
+#define regs                    (*(FLASH_TypeDef*)core_emu_regs(FLASH_BASE))
+
+static int sector_writable(uint32_t addr)
+{
+    uint32_t sector = addr / FLASH_EMU_SECTOR_SIZE;
+
+    if (sector < 32)
+        return (regs.SLOCK0 >> sector) & 1;
+    return (regs.SLOCK1 >> (sector - 32)) & 1;
+}
+
+static void start_busy(uint32_t us)
+{
+    regs.CR |= CR_BUSY;
+    busy_until = core_emu_cycles() + US(us);
+    stats.busy_cycles += US(us);
+}
+
+static void program(uint32_t addr, uint32_t value, uint8_t size)
+{
+    uint8_t i;
+
+    if (!sector_writable(addr))
+    {
+        stats.protect_faults++;
+        return;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        uint8_t byte = (uint8_t)(value >> (8 * i));
+        if (~mem[addr + i] & byte)
+            stats.overwrites++;
+        mem[addr + i] &= byte;
+    }
+    stats.programs++;
+    start_busy(timing.program_us);
+}
+
+static void erase_page(uint32_t addr)
+{
+    uint32_t page = addr / FLASH_EMU_PAGE_SIZE;
+
+    if (!sector_writable(addr))
+    {
+        regs.IFR |= 0x2;
+        stats.protect_faults++;
+        return;
+    }
+
+    memset(&mem[page * FLASH_EMU_PAGE_SIZE], 0xFF, FLASH_EMU_PAGE_SIZE);
+    erase_count[page]++;
+    stats.erases++;
+    start_busy(timing.erase_us);
+}
+
+static void erase_chip(void)
+{
+    uint32_t page;
+
+    if (regs.SLOCK0 != 0xFFFFFFFF || regs.SLOCK1 != 0xFFFFFFFF)
+    {
+        regs.IFR |= 0x2;
+        stats.protect_faults++;
+        return;
+    }
+
+    memset(mem, 0xFF, sizeof(mem));
+    for (page = 0; page < FLASH_EMU_PAGES; page++)
+        erase_count[page]++;
+    stats.erases++;
+    start_busy(timing.chip_erase_us);
+}
+
+static void commit_data(void)
+{
+    uint32_t value = staged_size == 1 ? staged.b : staged_size == 2 ? staged.h : staged.w;
+    uint8_t size = staged_size;
+
+    staged_size = 0;
+
+    /* A read, with or without OP selected */
+    if ((regs.CR & CR_OP) == 0 || value == staged_read)
+        return;
+
+    if (regs.CR & CR_BUSY)
+    {
+        stats.busy_faults++;
+        return;
+    }
+
+    if (staged_addr + size > FLASH_EMU_SIZE)
+    {
+        stats.protect_faults++;
+        return;
+    }
+
+    if (fail_count)
+    {
+        if (fail_after == 0)
+        {
+            fail_count -= fail_count != FLASH_EMU_FAIL_ALL;
+            stats.dropped++;
+            start_busy((regs.CR & CR_OP) == OP_PROGRAM ? timing.program_us : timing.erase_us);
+            return;
+        }
+        fail_after--;
+    }
+
+    switch (regs.CR & CR_OP)
+    {
+    case OP_PROGRAM:
+        program(staged_addr, value, size);
+        break;
+    case OP_SECTORERASE:
+        erase_page(staged_addr);
+        break;
+    case OP_CHIPERASE:
+        erase_chip();
+        break;
+    }
+}
+
+static void flash_reset(void)
+{
+    if (!blank)
+        flash_emu_init(NULL);
+
+    memset(&regs, 0, sizeof(regs));
+    regs.ICLR = 0x3;
+    last = regs;
+    busy_until = 0;
+    unlocked = 0;
+    staged_size = 0;
+    fail_count = 0;
+}
+
+/* Apply the previous access, then catch up to now */
+static void flash_sync(void)
+{
+    /* BUSY is read only, a read-modify-write must not change it */
+    regs.CR = (regs.CR & ~CR_BUSY) | (last.CR & CR_BUSY);
+
+    /* BYPASS: KEY1 then KEY2 unlocks the registers, KEY1 then 0 locks them */
+    if (regs.BYPASS != last.BYPASS && last.BYPASS == BYPASS_KEY1)
+    {
+        if (regs.BYPASS == BYPASS_KEY2)
+        {
+            unlocked = 1;
+            stats.unlocks++;
+        }
+        else if (regs.BYPASS == 0)
+        {
+            unlocked = 0;
+            stats.locks++;
+        }
+    }
+
+    if (regs.SLOCK0 != last.SLOCK0 || regs.SLOCK1 != last.SLOCK1 || regs.ICLR != last.ICLR)
+    {
+        if (!unlocked)
+        {
+            stats.locked_writes++;
+            regs.SLOCK0 = last.SLOCK0;
+            regs.SLOCK1 = last.SLOCK1;
+            regs.ICLR = last.ICLR;
+        }
+        else if (regs.SLOCK0 != last.SLOCK0 || regs.SLOCK1 != last.SLOCK1)
+        {
+            stats.slock_changes++;
+        }
+    }
+
+    if (staged_size)
+        commit_data();
+
+    /* ICLR: a 0 bit clears the interrupt flag */
+    regs.IFR &= regs.ICLR | ~0x3u;
+    regs.ICLR = 0x3;
+
+    if ((regs.CR & CR_BUSY) && core_emu_cycles() >= busy_until)
+        regs.CR &= ~CR_BUSY;
+
+    last = regs;
+}
+
+static CoreEmuModel flash_model = { flash_reset, flash_sync, NULL, NULL };
+
+__attribute__((constructor)) static void flash_emu_register(void)
+{
+    core_emu_model(&flash_model);
+}
+
+/* A blank part: erased array, no wear, default or given timing */
+void flash_emu_init(const FlashEmuTiming* config)
+{
+    timing = config ? *config : timing_default;
+    memset(mem, 0xFF, sizeof(mem));
+    memset(erase_count, 0, sizeof(erase_count));
+    memset(&stats, 0, sizeof(stats));
+    fail_count = 0;
+    blank = 1;
+}
+
+/* Direct view of the array, for host code reading flash contents */
+uint8_t* flash_emu_mem(uint32_t addr)
+{
+    return &mem[addr % FLASH_EMU_SIZE];
+}
+
+const FlashEmuStats* flash_emu_stats(void)
+{
+    core_emu_sync();
+    return &stats;
+}
+
+void flash_emu_clear_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t flash_emu_erase_count(uint32_t page)
+{
+    return page < FLASH_EMU_PAGES ? erase_count[page] : 0;
+}
+
+/* Do the next after program or erase operations, then drop count of them */
+void flash_emu_fail(uint32_t after, uint32_t count)
+{
+    core_emu_sync();
+    fail_after = after;
+    fail_count = count;
+}
+
+/* One bus access, the previous one lands first */
+static void stage(uint32_t addr, uint8_t size)
+{
+    core_emu_periph(FLASH_BASE);
+    staged_addr = addr;
+    staged_size = size;
+    staged.w = 0xFFFFFFFF;
+    if (addr + size <= FLASH_EMU_SIZE)
+        memcpy(&staged, &mem[addr], size);
+    staged_read = size == 1 ? staged.b : size == 2 ? staged.h : staged.w;
+}
+
+volatile uint8_t* flash_emu_data8(uint32_t addr)
+{
+    stage(addr, 1);
+    return &staged.b;
+}
+
+volatile uint16_t* flash_emu_data16(uint32_t addr)
+{
+    stage(addr, 2);
+    return &staged.h;
+}
+
+volatile uint32_t* flash_emu_data32(uint32_t addr)
+{
+    stage(addr, 4);
+    return &staged.w;
+}
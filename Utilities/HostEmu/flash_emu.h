@@ -0,0 +1,79 @@
+#ifndef __FLASH_EMU_H
+#define __FLASH_EMU_H
+#include <stdint.h>
+#include <wb32l003.h>
+
+/*
+ * FLASH controller model: BYPASS unlock sequence, SLOCK sector
+ * protection, CR OP program/sector erase/chip erase, BUSY with program
+ * and erase latencies, and per page erase counters for wear tests.
+ *
+ * It runs on core_emu time. Register and M8/M16/M32 data accesses cost
+ * a bus access each and BUSY stays set for the operation's latency in
+ * HCLK cycles. The driver's FLASH_OP_Delay() is a plain C loop and costs
+ * nothing, FLASH_WaitForLastOperation() polls BUSY out.
+ *
+ * SLOCK0/1 and ICLR writes made without the BYPASS unlock are counted
+ * and reverted, as the controller ignores them. CR is not protected,
+ * the driver clears OP after its lock sequence. BUSY is read only.
+ *
+ * With OP set, a data access that changes the value it read is a write
+ * and starts the operation, any other is a read. A write of the value
+ * already there cannot be told from a read and does nothing, which for a
+ * program leaves the array as it was anyway; the driver's erase dummy
+ * write only goes unseen on a word that already holds DUMMY_DATA.
+ *
+ * flash_emu_fail() drops program and erase operations for fault tests:
+ * a dropped one runs its BUSY time and leaves the array as it was.
+ * FLASH_EMU_FAIL_ALL drops every one from then on, a power cut that
+ * core_emu_reset(), the power coming back, ends.
+ *
+ * flash_emu_init() is a blank part, the array survives core_emu_reset().
+ */
+
+#define FLASH_EMU_SIZE          0x10000
+#define FLASH_EMU_PAGE_SIZE     0x200
+#define FLASH_EMU_SECTOR_SIZE   0x400
+#define FLASH_EMU_PAGES         (FLASH_EMU_SIZE / FLASH_EMU_PAGE_SIZE)
+#define FLASH_EMU_FAIL_ALL      0xFFFFFFFF
+
+typedef struct {
+    uint32_t program_us;        /* BUSY time of one program */
+    uint32_t erase_us;          /* BUSY time of one sector erase */
+    uint32_t chip_erase_us;     /* BUSY time of a chip erase */
+} FlashEmuTiming;
+
+typedef struct {
+    uint32_t unlocks;           /* BYPASS unlock sequences */
+    uint32_t locks;             /* BYPASS lock sequences */
+    uint32_t slock_changes;     /* SLOCK0/1 writes, sector unlock or lock */
+    uint32_t locked_writes;     /* SLOCK/ICLR writes without BYPASS unlock, reverted */
+    uint32_t programs;
+    uint32_t erases;
+    uint32_t protect_faults;    /* program or erase of a locked sector */
+    uint32_t busy_faults;       /* data write while BUSY */
+    uint32_t overwrites;        /* program tried to turn a 0 bit into 1 */
+    uint32_t dropped;           /* operations dropped by flash_emu_fail() */
+    uint64_t busy_cycles;       /* total time spent BUSY */
+} FlashEmuStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void flash_emu_init(const FlashEmuTiming* timing);
+uint8_t* flash_emu_mem(uint32_t addr);
+const FlashEmuStats* flash_emu_stats(void);
+void flash_emu_clear_stats(void);
+uint32_t flash_emu_erase_count(uint32_t page);
+void flash_emu_fail(uint32_t after, uint32_t count);
+
+volatile uint8_t*  flash_emu_data8(uint32_t addr);
+volatile uint16_t* flash_emu_data16(uint32_t addr);
+volatile uint32_t* flash_emu_data32(uint32_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+#include <string.h>
+#include <wb32l003.h>
+#include "gpio_emu.h"
+
+#define DRIVE_AT_MAX            32
+
+typedef struct {
+    uint16_t driven;            /* pins driven from outside */
+    uint16_t level;             /* their levels */
+    uint16_t pins;              /* pin levels at the last sync */
+} Port;
+
+typedef struct {
+    uint8_t used;
+    uint32_t base;
+    uint16_t pins;
+    int level;
+} DriveAt;
+
+static const uint32_t port_base[GPIO_EMU_PORTS] = {
+    GPIOA_BASE, GPIOB_BASE, GPIOC_BASE, GPIOD_BASE
+};
+static const IRQn_Type port_irq[GPIO_EMU_PORTS] = {
+    GPIOA_IRQn, GPIOB_IRQn, GPIOC_IRQn, GPIOD_IRQn
+};
+
+static Port ports[GPIO_EMU_PORTS];
+static DriveAt drive_at[DRIVE_AT_MAX];
+
+static int port_index(uint32_t base)
+{
+    int i;
+
+    for (i = 0; i < GPIO_EMU_PORTS; i++)
+    {
+        if (port_base[i] == base)
+            return i;
+    }
+    core_emu_fatal("0x%08X is not a GPIO port", (unsigned)base);
+}
+
+static uint16_t pin_levels(const Port* p, const GPIO_TypeDef* r)
+{
+    uint16_t pull = 0;
+    uint16_t outputs = (uint16_t)r->DIRCR;
+    uint16_t outside;
+    int i;
+
+    for (i = 0; i < 16; i++)
+    {
+        if (((r->PUPDR >> (2 * i)) & 0x3) == 0x1)
+            pull |= (uint16_t)(1U << i);
+    }
+    outside = (uint16_t)((p->level & p->driven) | (pull & ~p->driven));
+    return (uint16_t)((r->ODR & outputs) | (outside & ~outputs));
+}
+
+static void gpio_reset(void)
+{
+    memset(ports, 0, sizeof(ports));
+    memset(drive_at, 0, sizeof(drive_at));
+}
+
+static void gpio_sync(void)
+{
+    int i;
+
+    for (i = 0; i < GPIO_EMU_PORTS; i++)
+    {
+        Port* p = &ports[i];
+        GPIO_TypeDef* r = (GPIO_TypeDef*)core_emu_regs(port_base[i]);
+        uint16_t pins, rise, fall, hit;
+        uint16_t level_type = (uint16_t)r->INTTYPCR;
+        uint16_t pol = (uint16_t)r->INTPOLCR;
+        uint16_t en = (uint16_t)r->INTEN;
+
+        if (r->ODSET)
+        {
+            r->ODR |= r->ODSET & 0xFFFF;
+            r->ODSET = 0;
+        }
+        if (r->ODCLR)
+        {
+            r->ODR &= ~(r->ODCLR & 0xFFFF);
+            r->ODCLR = 0;
+        }
+        if (r->INTCLR)
+        {
+            r->RAWINTST &= ~(r->INTCLR & 0xFFFF);
+            r->INTCLR = 0;
+        }
+
+        pins = pin_levels(p, r);
+        rise = pins & ~p->pins;
+        fall = ~pins & p->pins;
+
+        /* edge pins latch, level pins follow the pin */
+        hit = (uint16_t)(((rise & pol) | (fall & ~pol) | ((rise | fall) & r->INTANY)) & ~level_type);
+        hit |= (uint16_t)(((pins & pol) | (~pins & ~pol)) & level_type);
+        r->RAWINTST = ((r->RAWINTST & ~level_type) | hit) & en;
+        r->MSKINTSR = r->RAWINTST & en;
+        r->IDR = pins;
+        p->pins = pins;
+
+        core_emu_irq_level(port_irq[i], r->MSKINTSR != 0);
+    }
+}
+
+static CoreEmuModel gpio_model = { gpio_reset, gpio_sync, NULL, NULL };
+
+__attribute__((constructor)) static void gpio_emu_register(void)
+{
+    core_emu_model(&gpio_model);
+}
+
+/* Drive pins from outside, the next access sees the level */
+void gpio_emu_drive(uint32_t base, uint16_t pins, int level)
+{
+    Port* p = &ports[port_index(base)];
+
+    p->driven |= pins;
+    if (level)
+        p->level |= pins;
+    else
+        p->level &= (uint16_t)~pins;
+    core_emu_sync();
+}
+
+void gpio_emu_release(uint32_t base, uint16_t pins)
+{
+    ports[port_index(base)].driven &= (uint16_t)~pins;
+    core_emu_sync();
+}
+
+static void drive_fire(void* arg)
+{
+    DriveAt* d = (DriveAt*)arg;
+
+    d->used = 0;
+    gpio_emu_drive(d->base, d->pins, d->level);
+}
+
+/* Script a level change at a cycle, runs during WFI or core_emu_run() too */
+void gpio_emu_drive_at(uint64_t cycle, uint32_t base, uint16_t pins, int level)
+{
+    int i;
+
+    port_index(base);
+    for (i = 0; i < DRIVE_AT_MAX; i++)
+    {
+        if (!drive_at[i].used)
+        {
+            drive_at[i].used = 1;
+            drive_at[i].base = base;
+            drive_at[i].pins = pins;
+            drive_at[i].level = level;
+            core_emu_at(cycle, drive_fire, &drive_at[i]);
+            return;
+        }
+    }
+    core_emu_fatal("more than %d scheduled pin changes", DRIVE_AT_MAX);
+}
+
+/* Pin levels as the outside sees them, outputs included */
+uint16_t gpio_emu_pins(uint32_t base)
+{
+    int i = port_index(base);
+
+    return pin_levels(&ports[i], (GPIO_TypeDef*)core_emu_regs(port_base[i]));
+}
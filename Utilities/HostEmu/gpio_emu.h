@@ -0,0 +1,30 @@
+#ifndef __GPIO_EMU_H
+#define __GPIO_EMU_H
+#include <stdint.h>
+
+/*
+ * GPIOA..GPIOD model: IDR from the external pin levels or the output
+ * latch, ODSET/ODCLR, and the EXTI block (INTEN, INTTYPCR level/edge,
+ * INTPOLCR, INTANY both edges, RAWINTST/MSKINTSR, INTCLR) raising the
+ * port interrupt line. Edges latch only on pins with INTEN set, and the
+ * detector keeps running in DEEPSLEEP so a pin can wake the core.
+ *
+ * Pins nobody drives read their pull resistor, 0 without one.
+ */
+
+#define GPIO_EMU_PORTS          4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gpio_emu_drive(uint32_t port_base, uint16_t pins, int level);
+void gpio_emu_release(uint32_t port_base, uint16_t pins);
+void gpio_emu_drive_at(uint64_t cycle, uint32_t port_base, uint16_t pins, int level);
+uint16_t gpio_emu_pins(uint32_t port_base);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
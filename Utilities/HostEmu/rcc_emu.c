@@ -0,0 +1,93 @@
+#include <stddef.h>
+#include <sys/mman.h>
+#include <wb32l003.h>
+#include "rcc_emu.h"
+
+#define INFO_BASE               0x18000000UL
+#define INFO_SIZE               0x1000UL
+
+uint32_t SystemCoreClock = CORE_EMU_HCLK;
+
+static void rcc_reset(void)
+{
+    RCC_TypeDef* r = (RCC_TypeDef*)core_emu_regs(RCC_BASE);
+
+    r->HCLKEN = RCC_HCLKEN_FLASHCKEN;
+    r->SYSCLKCR = RCC_SYSCLKCR_HSIEN;
+    r->HSICR = RCC_HSITRIM_24M;
+    r->SYSCLKSEL = RCC_SYSCLKSource_HSI;
+    SystemCoreClock = CORE_EMU_HCLK;
+}
+
+static void rcc_sync(void)
+{
+    RCC_TypeDef* r = (RCC_TypeDef*)core_emu_regs(RCC_BASE);
+
+    /* oscillators are ready as soon as they are enabled */
+    r->HSICR = (r->SYSCLKCR & RCC_SYSCLKCR_HSIEN) ? (r->HSICR | RCC_HSICR_HSIRDY) : (r->HSICR & ~RCC_HSICR_HSIRDY);
+    r->HSECR = (r->SYSCLKCR & RCC_SYSCLKCR_HSEEN) ? (r->HSECR | RCC_HSECR_HSERDY) : (r->HSECR & ~RCC_HSECR_HSERDY);
+    r->LSICR = (r->SYSCLKCR & RCC_SYSCLKCR_LSIEN) ? (r->LSICR | RCC_LSICR_LSIRDY) : (r->LSICR & ~RCC_LSICR_LSIRDY);
+}
+
+static CoreEmuModel rcc_model = { rcc_reset, rcc_sync, NULL, NULL };
+
+static void info_map(void)
+{
+    void* info = mmap((void*)INFO_BASE, INFO_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (info != (void*)INFO_BASE)
+        core_emu_fatal("cannot map the information block at 0x%08lX", INFO_BASE);
+
+    /* not the factory values, one per trim so the selection shows */
+    *(uint16_t*)HSI24M_TRIM_ADDR = 0x600;
+    *(uint16_t*)HSI22M_TRIM_ADDR = 0x580;
+    *(uint16_t*)HSI16M_TRIM_ADDR = 0x400;
+    *(uint16_t*)HSI8M_TRIM_ADDR = 0x200;
+    *(uint16_t*)HSI4M_TRIM_ADDR = 0x100;
+    *(uint16_t*)LSI38K_TRIM_ADDR = 0x120;
+    *(uint16_t*)LSI32K_TRIM_ADDR = 0x0F0;
+}
+
+__attribute__((constructor)) static void rcc_emu_register(void)
+{
+    info_map();
+    core_emu_model(&rcc_model);
+}
+
+uint32_t rcc_emu_lsi_hz(void)
+{
+    RCC_TypeDef* r = (RCC_TypeDef*)core_emu_regs(RCC_BASE);
+
+    if ((r->LSICR & RCC_LSICR_LSITRIM) == RCC_LSITRIM_32K)
+        return 32768;
+    return 38400;
+}
+
+int rcc_emu_hclk_on(uint32_t mask)
+{
+    return (((RCC_TypeDef*)core_emu_regs(RCC_BASE))->HCLKEN & mask) == mask;
+}
+
+int rcc_emu_pclk_on(uint32_t mask)
+{
+    return (((RCC_TypeDef*)core_emu_regs(RCC_BASE))->PCLKEN & mask) == mask;
+}
+
+void SystemInit(void)
+{
+    RCC->SYSCLKCR = RCC->SYSCLKCR | RCC_SYSCLKCR_HSIEN;
+    RCC->HCLKDIV = 0x00000000;
+    RCC->PCLKDIV = 0x00000000;
+    RCC->HCLKEN = 0x00000100;
+    RCC->PCLKEN = 0x00000000;
+    RCC->MCOCR = 0x00000000;
+    RCC->SYSCLKSEL = RCC_SYSCLKSource_HSI;
+    RCC->HSICR = RCC_HSITRIM_24M;
+    SystemCoreClock = CORE_EMU_HCLK;
+}
+
+void SystemCoreClockUpdate(void)
+{
+    SystemCoreClock = CORE_EMU_HCLK;
+}
@@ -0,0 +1,33 @@
+#ifndef __RCC_EMU_H
+#define __RCC_EMU_H
+#include <stdint.h>
+
+/*
+ * RCC model: clock gates HCLKEN/PCLKEN that the other models consult,
+ * oscillators ready as soon as they are enabled, SYSCLKSEL following the
+ * selection. HCLK and PCLK stay at CORE_EMU_HCLK, LSI runs at the rate
+ * its trim selects, 32768 or 38400 Hz.
+ *
+ * The information block holding the factory trims is mapped at its
+ * device address with a distinct value per trim, so RCC_GetClocksFreq()
+ * and the LSI rate follow the trim the driver wrote.
+ *
+ * SystemInit() and SystemCoreClockUpdate() are provided here for host
+ * builds: the device's reads the HSI trim from the info flash, the host
+ * one does the same RCC resets (peripheral clock gates included) and
+ * keeps HSI at CORE_EMU_HCLK.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int rcc_emu_hclk_on(uint32_t hclken_mask);
+int rcc_emu_pclk_on(uint32_t pclken_mask);
+uint32_t rcc_emu_lsi_hz(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+#include <string.h>
+#include <wb32l003.h>
+#include "timer_emu.h"
+
+typedef struct {
+    uint32_t base;
+    int irqn;
+    uint32_t cr;                /* CR in effect since the last sync */
+    uint32_t hz;                /* count clock in effect, 0 stopped */
+    uint8_t on_pclk;            /* count clock stops in DEEPSLEEP */
+    uint64_t clock;             /* count clocks seen so far */
+    uint32_t cnt;
+    uint32_t shown;             /* counter as last presented */
+    uint32_t load;              /* LOAD as last presented */
+} Counter;
+
+static Counter basetim[2] = {
+    { TIM10_BASE, TIM10_IRQn },
+    { TIM11_BASE, TIM11_IRQn },
+};
+static Counter lptim = { LPTIM_BASE, LPTIM_IRQn };
+static Counter awk = { AWK_BASE, AWK_IRQn };
+
+static uint64_t clock_at(uint64_t cycle, uint32_t hz)
+{
+    return (uint64_t)((unsigned __int128)cycle * hz / CORE_EMU_HCLK);
+}
+
+/* First cycle at which the count clock reaches clock */
+static uint64_t cycle_at(uint64_t clock, uint32_t hz)
+{
+    return (uint64_t)(((unsigned __int128)clock * CORE_EMU_HCLK + hz - 1) / hz);
+}
+
+static int counting(const Counter* t)
+{
+    return t->hz && !(t->on_pclk && core_emu_sleep_mode() == CORE_EMU_DEEPSLEEP);
+}
+
+/* Count the clocks since the last sync, returns 1 when the counter overflowed */
+static int count(Counter* t, uint32_t top, uint32_t reload)
+{
+    uint64_t now = clock_at(core_emu_cycles(), t->hz);
+    uint64_t n = now - t->clock;
+    uint64_t to_top = (uint64_t)top - t->cnt + 1;
+
+    t->clock = now;
+    if (!counting(t) || n < to_top)
+    {
+        if (counting(t))
+            t->cnt += (uint32_t)n;
+        return 0;
+    }
+    n -= to_top;
+    reload &= top;
+    t->cnt = reload + (uint32_t)(n % ((uint64_t)top - reload + 1));
+    return 1;
+}
+
+static uint64_t overflow_cycle(const Counter* t, uint32_t top)
+{
+    if (!counting(t))
+        return CORE_EMU_NO_EVENT;
+    return cycle_at(t->clock + ((uint64_t)top - t->cnt + 1), t->hz);
+}
+
+static void rebase(Counter* t, uint32_t hz, uint8_t on_pclk)
+{
+    t->hz = hz;
+    t->on_pclk = on_pclk;
+    t->clock = clock_at(core_emu_cycles(), hz);
+}
+
+static uint32_t lsi_hz(void)
+{
+    RCC_TypeDef* r = (RCC_TypeDef*)core_emu_regs(RCC_BASE);
+
+    return (r->SYSCLKCR & RCC_SYSCLKCR_LSIEN) ? rcc_emu_lsi_hz() : 0;
+}
+
+/*-------------------------------------------------------------------------*/
+/* BASETIM                                                                 */
+/*-------------------------------------------------------------------------*/
+
+static uint32_t basetim_top(uint32_t cr)
+{
+    return (cr & BASETIM_CR_TMR_SIZE) ? 0xFFFFFFFFUL : 0xFFFFUL;
+}
+
+static void basetim_sync_one(Counter* t)
+{
+    BASETIM_TypeDef* r = (BASETIM_TypeDef*)core_emu_regs(t->base);
+    uint32_t top = basetim_top(t->cr);
+    uint32_t hz = 0;
+
+    if (count(t, top, (t->cr & BASETIM_CR_MODE) ? r->BGLOAD : r->LOAD))
+    {
+        r->RAWINTSR |= 0x1;
+        if (t->cr & BASETIM_CR_ONESHOT)
+            r->CR &= ~BASETIM_CR_TR;
+    }
+
+    /* starting or a write to LOAD or CNT loads the counter */
+    top = basetim_top(r->CR);
+    if (((r->CR & ~t->cr) & BASETIM_CR_TR) || r->LOAD != t->load)
+        t->cnt = r->LOAD & top;
+    if (r->CNT != t->shown)
+        t->cnt = r->CNT & top;
+    if (r->INTCLR)
+    {
+        r->RAWINTSR &= ~r->INTCLR;
+        r->INTCLR = 0;
+    }
+
+    if ((r->CR & BASETIM_CR_TR) && rcc_emu_pclk_on(RCC_APBPeriph_BASETIM))
+        hz = CORE_EMU_HCLK >> (r->CR & BASETIM_CR_TMR_PRSC);
+    if (r->CR != t->cr || hz != t->hz)
+    {
+        t->cr = r->CR;
+        rebase(t, hz, 1);
+    }
+
+    t->load = r->LOAD;
+    t->shown = r->CNT = t->cnt;
+    r->MSKINTSR = (r->CR & BASETIM_CR_INTEN) ? (r->RAWINTSR & 0x1) : 0;
+    core_emu_irq_level(t->irqn, r->MSKINTSR != 0);
+}
+
+/*-------------------------------------------------------------------------*/
+/* LPTIM                                                                   */
+/*-------------------------------------------------------------------------*/
+
+static void lptim_sync(void)
+{
+    Counter* t = &lptim;
+    LPTIM_TypeDef* r = (LPTIM_TypeDef*)core_emu_regs(t->base);
+    uint32_t sel = r->CR & LPTIM_CR_TCK_SEL;
+    uint32_t hz = 0;
+
+    if (count(t, 0xFFFF, (t->cr & LPTIM_CR_MODE) ? r->BGLOAD : r->LOAD))
+        r->INTSR |= LPTIM_INTSR_INTF;
+
+    if (((r->CR & ~t->cr) & LPTIM_CR_TIM_RUN) || r->LOAD != t->load)
+        t->cnt = r->LOAD & 0xFFFF;
+    if (r->INTCLR)
+    {
+        if (r->INTCLR & LPTIM_INTCLR_ICLR)
+            r->INTSR &= ~LPTIM_INTSR_INTF;
+        r->INTCLR = 0;
+    }
+    r->CR &= ~LPTIM_CR_WT_FLAG;
+
+    if ((r->CR & LPTIM_CR_TIM_RUN) && (r->CR & LPTIM_CR_TCK_EN) && rcc_emu_pclk_on(RCC_APBPeriph_LPTIM))
+    {
+        if (sel == LPTIM_CLOCK_SOURCE_LSI)
+            hz = lsi_hz();
+        else if (sel == LPTIM_CLOCK_SOURCE_LSE)
+            hz = TIMER_EMU_LSE_HZ;
+        else
+            hz = CORE_EMU_HCLK;
+    }
+    if (r->CR != t->cr || hz != t->hz)
+    {
+        t->cr = r->CR;
+        rebase(t, hz, sel != LPTIM_CLOCK_SOURCE_LSI && sel != LPTIM_CLOCK_SOURCE_LSE);
+    }
+
+    t->load = r->LOAD;
+    r->CNTVAL = t->cnt;
+    core_emu_irq_level(t->irqn, (r->INTSR & LPTIM_INTSR_INTF) && (r->CR & LPTIM_CR_INT_EN));
+}
+
+/*-------------------------------------------------------------------------*/
+/* AWK                                                                     */
+/*-------------------------------------------------------------------------*/
+
+static void awk_sync(void)
+{
+    Counter* t = &awk;
+    AWK_TypeDef* r = (AWK_TypeDef*)core_emu_regs(t->base);
+    uint32_t sel = r->CR & AWK_CR_TCLKSEL;
+    uint32_t hz = 0;
+
+    if (count(t, 0xFF, r->RLOAD))
+        r->SR |= AWK_SR_AWUF;
+
+    if (((r->CR & ~t->cr) & AWK_CR_AWKEN) || r->RLOAD != t->load)
+        t->cnt = r->RLOAD & 0xFF;
+    if (r->INTCLR)
+    {
+        if (r->INTCLR & AWK_INTCLR_INTCLR)
+            r->SR &= ~AWK_SR_AWUF;
+        r->INTCLR = 0;
+    }
+
+    if (r->CR & AWK_CR_AWKEN)
+    {
+        if (sel == AWK_CLK_SEL_LSI)
+            hz = lsi_hz();
+        else if (sel == AWK_CLK_SEL_LSE)
+            hz = TIMER_EMU_LSE_HZ;
+        hz >>= (r->CR & AWK_CR_DIVSEL) + 1;
+    }
+    if (r->CR != t->cr || hz != t->hz)
+    {
+        t->cr = r->CR;
+        rebase(t, hz, 0);
+    }
+
+    t->load = r->RLOAD;
+    core_emu_irq_level(t->irqn, (r->SR & AWK_SR_AWUF) != 0);
+}
+
+/*-------------------------------------------------------------------------*/
+/* Models                                                                  */
+/*-------------------------------------------------------------------------*/
+
+static void timer_reset(void)
+{
+    Counter* all[] = { &basetim[0], &basetim[1], &lptim, &awk };
+    uint32_t i;
+
+    for (i = 0; i < sizeof(all) / sizeof(all[0]); i++)
+    {
+        uint32_t base = all[i]->base;
+        int irqn = all[i]->irqn;
+
+        memset(all[i], 0, sizeof(Counter));
+        all[i]->base = base;
+        all[i]->irqn = irqn;
+    }
+}
+
+static void timer_sync(void)
+{
+    basetim_sync_one(&basetim[0]);
+    basetim_sync_one(&basetim[1]);
+    lptim_sync();
+    awk_sync();
+}
+
+static uint64_t timer_next_event(void)
+{
+    uint64_t next = CORE_EMU_NO_EVENT;
+    uint64_t at;
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (basetim[i].cr & BASETIM_CR_INTEN)
+        {
+            at = overflow_cycle(&basetim[i], basetim_top(basetim[i].cr));
+            if (at < next)
+                next = at;
+        }
+    }
+    if (lptim.cr & LPTIM_CR_INT_EN)
+    {
+        at = overflow_cycle(&lptim, 0xFFFF);
+        if (at < next)
+            next = at;
+    }
+    at = overflow_cycle(&awk, 0xFF);
+    if (at < next)
+        next = at;
+    return next;
+}
+
+static CoreEmuModel timer_model = { timer_reset, timer_sync, timer_next_event, NULL };
+
+__attribute__((constructor)) static void timer_emu_register(void)
+{
+    core_emu_model(&timer_model);
+}
+
+uint32_t timer_emu_count(uint32_t base)
+{
+    if (base == TIM10_BASE)
+        return basetim[0].cnt;
+    if (base == TIM11_BASE)
+        return basetim[1].cnt;
+    if (base == LPTIM_BASE)
+        return lptim.cnt;
+    if (base == AWK_BASE)
+        return awk.cnt;
+    core_emu_fatal("0x%08X is not a timer", (unsigned)base);
+}
@@ -0,0 +1,40 @@
+#ifndef __TIMER_EMU_H
+#define __TIMER_EMU_H
+#include <stdint.h>
+
+/*
+ * Timer models.
+ *
+ * TIM10/TIM11 BASETIM: PCLK/2^PRSC up counter, 16 or 32 bit, from the
+ * LOAD value to the top, reloading from BGLOAD with MODE set and from
+ * LOAD otherwise, ONESHOT clears TR at the overflow. Setting TR or
+ * writing a new LOAD or CNT value loads the counter. RAWINTSR sets at
+ * the overflow, MSKINTSR and the interrupt line follow INTEN. PCLK
+ * domain: stops in DEEPSLEEP and with its clock gate off.
+ *
+ * LPTIM: 16 bit up counter on PCLK, LSE or LSI (TCK_SEL, TCK_EN), the
+ * same LOAD/BGLOAD reload and loading on TIM_RUN, INTSR.INTF and
+ * INT_EN. On LSE or LSI it keeps counting in DEEPSLEEP, LSI needs LSIEN.
+ *
+ * AWK: 8 bit counter on LSI or LSE divided by 2^(DIVSEL+1), counting up
+ * from RLOAD, SR.AWUF and the interrupt line at the overflow. Setting
+ * AWKEN or writing a new RLOAD value loads the counter, each overflow
+ * reloads it. Runs in DEEPSLEEP.
+ *
+ * WT_FLAG never sets, register writes take effect on the next access.
+ */
+
+#define TIMER_EMU_LSE_HZ        32768UL
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counter as of the last access, without an access of its own */
+uint32_t timer_emu_count(uint32_t base);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,250 @@
+#include <string.h>
+#include <wb32l003.h>
+#include "uart_emu.h"
+
+typedef struct {
+    uint32_t base;
+    int irqn;
+    uint32_t pclk;              /* PCLKEN gate */
+    /* RX line, arrival cycle of each byte */
+    uint64_t rx_cycle[UART_EMU_QUEUE];
+    uint8_t rx_data[UART_EMU_QUEUE];
+    uint32_t rx_head, rx_tail;
+    uint64_t rx_free;           /* first cycle the line is idle again */
+    uint32_t rx_lost;
+    uint8_t rx_last;
+    /* TX shifter and log */
+    uint8_t tx_busy;
+    uint8_t tx_byte;
+    uint64_t tx_done;
+    uint8_t tx_log[UART_EMU_QUEUE];
+    uint32_t tx_head, tx_tail;
+    uint32_t shown;             /* SBUF as last presented */
+} Port;
+
+typedef struct {
+    volatile uint32_t* scon;
+    volatile uint32_t* sbuf;
+    volatile uint32_t* intsr;
+    volatile uint32_t* intclr;
+    volatile uint32_t* baudcr;
+} Regs;
+
+static Port ports[3] = {
+    { UART1_BASE, UART1_IRQn, RCC_APBPeriph_UART1 },
+    { UART2_BASE, UART2_IRQn, RCC_APBPeriph_UART2 },
+    { LPUART_BASE, LPUART_IRQn, RCC_APBPeriph_LPUART },
+};
+
+#define PORT_NUM                (sizeof(ports) / sizeof(ports[0]))
+
+static Port* port_of(uint32_t base)
+{
+    uint32_t i;
+
+    for (i = 0; i < PORT_NUM; i++)
+    {
+        if (ports[i].base == base)
+            return &ports[i];
+    }
+    core_emu_fatal("0x%08X is not a UART", (unsigned)base);
+}
+
+static Regs regs_of(const Port* p)
+{
+    Regs r;
+
+    if (p->base == LPUART_BASE)
+    {
+        LPUART_TypeDef* u = (LPUART_TypeDef*)core_emu_regs(p->base);
+        r.scon = &u->SCON;
+        r.sbuf = &u->SBUF;
+        r.intsr = &u->INTSR;
+        r.intclr = &u->INTCLR;
+        r.baudcr = &u->BAUDCR;
+    }
+    else
+    {
+        UART_TypeDef* u = (UART_TypeDef*)core_emu_regs(p->base);
+        r.scon = &u->SCON;
+        r.sbuf = &u->SBUF;
+        r.intsr = &u->INTSR;
+        r.intclr = &u->INTCLR;
+        r.baudcr = &u->BAUDCR;
+    }
+    return r;
+}
+
+/* Baud clock in Hz, 0 while the port cannot shift */
+static uint32_t clock_hz(const Port* p, uint32_t scon)
+{
+    if (!rcc_emu_pclk_on(p->pclk))
+        return 0;
+    if (p->base == LPUART_BASE)
+    {
+        uint32_t sel = scon & LPUART_SCON_SCLKSEL;
+
+        if (sel == LPUART_ClkSel_LSE)
+            return 32768;
+        if (sel == LPUART_ClkSel_LSI)
+            return rcc_emu_lsi_hz();
+    }
+    return core_emu_sleep_mode() == CORE_EMU_DEEPSLEEP ? 0 : CORE_EMU_HCLK;
+}
+
+static uint64_t byte_cycles(const Port* p)
+{
+    Regs r = regs_of(p);
+    uint32_t hz = clock_hz(p, *r.scon);
+    uint64_t div = 32ULL * ((*r.baudcr & UART_BAUDCR_BRG) + 1);
+
+    /* a port without clock still times the line with its divider */
+    if (hz == 0)
+        hz = CORE_EMU_HCLK;
+    return (10 * div * CORE_EMU_HCLK * ((*r.scon & UART_SCON_DBAUD) ? 1 : 2) + hz - 1) / (2ULL * hz);
+}
+
+static void port_sync(Port* p)
+{
+    Regs r = regs_of(p);
+    uint32_t scon = *r.scon;
+
+    /* the previous access: INTCLR and a byte written to SBUF */
+    if (*r.intclr)
+    {
+        *r.intsr &= ~(*r.intclr & (UART_INTSR_RI | UART_INTSR_TI | UART_INTSR_FE));
+        *r.intclr = 0;
+    }
+    if (*r.sbuf != p->shown)
+    {
+        if (p->tx_busy)
+            core_emu_fatal("UART 0x%08X: SBUF written at cycle %llu while shifting",
+                           (unsigned)p->base, (unsigned long long)core_emu_cycles());
+        p->tx_busy = 1;
+        p->tx_byte = (uint8_t)*r.sbuf;
+        p->tx_done = core_emu_cycles() + byte_cycles(p);
+    }
+
+    if (p->tx_busy && core_emu_cycles() >= p->tx_done)
+    {
+        p->tx_busy = 0;
+        *r.intsr |= UART_INTSR_TI;
+        if (p->tx_head - p->tx_tail < UART_EMU_QUEUE)
+            p->tx_log[p->tx_head++ % UART_EMU_QUEUE] = p->tx_byte;
+    }
+
+    while (p->rx_tail != p->rx_head && p->rx_cycle[p->rx_tail % UART_EMU_QUEUE] <= core_emu_cycles())
+    {
+        uint8_t ch = p->rx_data[p->rx_tail++ % UART_EMU_QUEUE];
+
+        if (!(scon & UART_SCON_REN) || !clock_hz(p, scon) || (*r.intsr & UART_INTSR_RI))
+        {
+            p->rx_lost++;
+            continue;
+        }
+        p->rx_last = ch;
+        *r.intsr |= UART_INTSR_RI;
+    }
+
+    p->shown = *r.sbuf = 0x100 | p->rx_last;
+    core_emu_irq_level(p->irqn, ((*r.intsr & UART_INTSR_RI) && (scon & UART_SCON_RIEN)) ||
+                                ((*r.intsr & UART_INTSR_TI) && (scon & UART_SCON_TIEN)));
+}
+
+static void uart_reset(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < PORT_NUM; i++)
+    {
+        Port* p = &ports[i];
+        uint32_t base = p->base, pclk = p->pclk;
+        int irqn = p->irqn;
+
+        memset(p, 0, sizeof(*p));
+        p->base = base;
+        p->irqn = irqn;
+        p->pclk = pclk;
+        p->shown = *regs_of(p).sbuf = 0x100;
+    }
+}
+
+static void uart_sync(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < PORT_NUM; i++)
+        port_sync(&ports[i]);
+}
+
+static uint64_t uart_next_event(void)
+{
+    uint64_t next = CORE_EMU_NO_EVENT;
+    uint32_t i;
+
+    for (i = 0; i < PORT_NUM; i++)
+    {
+        Port* p = &ports[i];
+
+        if (p->tx_busy && p->tx_done < next)
+            next = p->tx_done;
+        if (p->rx_tail != p->rx_head && p->rx_cycle[p->rx_tail % UART_EMU_QUEUE] < next)
+            next = p->rx_cycle[p->rx_tail % UART_EMU_QUEUE];
+    }
+    return next;
+}
+
+static CoreEmuModel uart_model = { uart_reset, uart_sync, uart_next_event, NULL };
+
+__attribute__((constructor)) static void uart_emu_register(void)
+{
+    core_emu_model(&uart_model);
+}
+
+/* Bytes on the RX line back to back, the first one starting at cycle */
+void uart_emu_rx_at(uint64_t cycle, uint32_t base, const uint8_t* data, uint32_t len)
+{
+    Port* p = port_of(base);
+    uint64_t per_byte = byte_cycles(p);
+    uint32_t i;
+
+    if (p->rx_head - p->rx_tail + len > UART_EMU_QUEUE)
+        core_emu_fatal("UART 0x%08X: more than %d RX bytes in flight", (unsigned)base, UART_EMU_QUEUE);
+    if (cycle < p->rx_free)
+        cycle = p->rx_free;
+    for (i = 0; i < len; i++)
+    {
+        cycle += per_byte;
+        p->rx_cycle[p->rx_head % UART_EMU_QUEUE] = cycle;
+        p->rx_data[p->rx_head % UART_EMU_QUEUE] = data[i];
+        p->rx_head++;
+    }
+    p->rx_free = cycle;
+}
+
+void uart_emu_rx(uint32_t base, const uint8_t* data, uint32_t len)
+{
+    uart_emu_rx_at(core_emu_cycles(), base, data, len);
+}
+
+uint32_t uart_emu_rx_lost(uint32_t base)
+{
+    return port_of(base)->rx_lost;
+}
+
+/* Take up to max bytes sent so far */
+uint32_t uart_emu_tx(uint32_t base, uint8_t* buf, uint32_t max)
+{
+    Port* p = port_of(base);
+    uint32_t n = 0;
+
+    while (n < max && p->tx_tail != p->tx_head)
+        buf[n++] = p->tx_log[p->tx_tail++ % UART_EMU_QUEUE];
+    return n;
+}
+
+/* One frame at the current configuration */
+uint64_t uart_emu_byte_cycles(uint32_t base)
+{
+    return byte_cycles(port_of(base));
+}
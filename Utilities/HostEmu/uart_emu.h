@@ -0,0 +1,41 @@
+#ifndef __UART_EMU_H
+#define __UART_EMU_H
+#include <stdint.h>
+
+/*
+ * UART1, UART2 and LPUART model: 8N1 frames, ten bit times per byte at
+ * (DBAUD + 1) * clock / (32 * (BRG + 1)), the clock being PCLK and for
+ * the LPUART the SCLKSEL one (PCLK, LSE or LSI).
+ *
+ * TX: a write to SBUF shifts the byte out, TI sets when its stop bit
+ * ends and the byte joins the log uart_emu_tx() takes from. A write
+ * while a byte is still shifting is a fatal error.
+ *
+ * RX: bytes scripted on the line arrive back to back, each one at the
+ * end of its stop bit. With REN set it lands in SBUF and sets RI. A byte
+ * arriving while RI is still set, with REN clear or with the port's
+ * clock off (PCLK ports in DEEPSLEEP included) is lost and counted.
+ *
+ * SBUF reads as 0x100 | the last byte received, so any byte written
+ * differs from it and is seen as a write. INTCLR clears the INTSR bits,
+ * the port IRQ line follows RI & RIEN | TI & TIEN. FE never sets, TX
+ * timing ignores DEEPSLEEP.
+ */
+
+#define UART_EMU_QUEUE          16384   /* RX bytes in flight and TX bytes logged, per port */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void uart_emu_rx(uint32_t base, const uint8_t* data, uint32_t len);
+void uart_emu_rx_at(uint64_t cycle, uint32_t base, const uint8_t* data, uint32_t len);
+uint32_t uart_emu_rx_lost(uint32_t base);
+uint32_t uart_emu_tx(uint32_t base, uint8_t* buf, uint32_t max);
+uint64_t uart_emu_byte_cycles(uint32_t base);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
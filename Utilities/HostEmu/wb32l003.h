@@ -0,0 +1,124 @@
+/*
+ * Host stand-in for the WB32L003 device header.
+ *
+ * It wraps the device header, found next on the include path, so the
+ * register layouts and bit definitions are the device's own, then points
+ * every peripheral at the emulator's register blocks. The modules and the
+ * StdPeriph drivers build unchanged on Linux against the models:
+ *
+ *   -IUtilities/HostEmu -ILibraries/CMSIS/Device/WB/WB32L003 ...
+ *
+ * Utilities/HostTest/Makefile has the full flags. The M8/M16/M32
+ * accessors go to the flash array model, the ones at the CRC block to
+ * the CRC data window model. The factory trims the
+ * drivers read through plain pointers are mapped at their addresses by
+ * the RCC model.
+ *
+ * The emulator sources include <wb32l003.h>: a quoted include would find
+ * this file next to them and #include_next would skip the device header.
+ */
+
+#ifndef __WB32L003_HOST_H
+#define __WB32L003_HOST_H
+
+#include_next "wb32l003.h"
+#include "core_emu.h"
+#include "crc_emu.h"
+#include "flash_emu.h"
+#include "gpio_emu.h"
+#include "rcc_emu.h"
+#include "timer_emu.h"
+#include "uart_emu.h"
+
+#define HOST_PERIPH(type, base) ((type *)core_emu_periph(base))
+
+#undef VCMP
+#undef LVD
+#undef ADC
+#undef RTC
+#undef CLKTRIM
+#undef OWIRE
+#undef SPI
+#undef I2C
+#undef LPUART
+#undef UART1
+#undef UART2
+#undef WWDG
+#undef IWDG
+#undef BEEP
+#undef AWK
+#undef LPTIM
+#undef TIM10
+#undef TIM11
+#undef PCA
+#undef TIM1
+#undef TIM2
+#undef CRC
+#undef FLASH
+#undef GPIOA
+#undef GPIOB
+#undef GPIOC
+#undef GPIOD
+#undef SYSCON
+#undef RCC
+#undef DBG
+#undef M8
+#undef M16
+#undef M32
+
+#define VCMP                    HOST_PERIPH(VCMP_TypeDef, VCMP_BASE)
+#define LVD                     HOST_PERIPH(LVD_TypeDef, LVD_BASE)
+#define ADC                     HOST_PERIPH(ADC_TypeDef, ADC_BASE)
+#define RTC                     HOST_PERIPH(RTC_TypeDef, RTC_BASE)
+#define CLKTRIM                 HOST_PERIPH(CLKTRIM_TypeDef, CLKTRIM_BASE)
+#define OWIRE                   HOST_PERIPH(OWIRE_TypeDef, OWIRE_BASE)
+#define SPI                     HOST_PERIPH(SPI_TypeDef, SPI_BASE)
+#define I2C                     HOST_PERIPH(I2C_TypeDef, I2C_BASE)
+#define LPUART                  HOST_PERIPH(LPUART_TypeDef, LPUART_BASE)
+#define UART1                   HOST_PERIPH(UART_TypeDef, UART1_BASE)
+#define UART2                   HOST_PERIPH(UART_TypeDef, UART2_BASE)
+#define WWDG                    HOST_PERIPH(WWDG_TypeDef, WWDG_BASE)
+#define IWDG                    HOST_PERIPH(IWDG_TypeDef, IWDG_BASE)
+#define BEEP                    HOST_PERIPH(BEEP_TypeDef, BEEP_BASE)
+#define AWK                     HOST_PERIPH(AWK_TypeDef, AWK_BASE)
+#define LPTIM                   HOST_PERIPH(LPTIM_TypeDef, LPTIM_BASE)
+#define TIM10                   HOST_PERIPH(BASETIM_TypeDef, TIM10_BASE)
+#define TIM11                   HOST_PERIPH(BASETIM_TypeDef, TIM11_BASE)
+#define PCA                     HOST_PERIPH(PCA_TypeDef, PCA_BASE)
+#define TIM1                    HOST_PERIPH(TIM_TypeDef, TIM1_BASE)
+#define TIM2                    HOST_PERIPH(TIM_TypeDef, TIM2_BASE)
+#define CRC                     HOST_PERIPH(CRC_TypeDef, CRC_BASE)
+#define FLASH                   HOST_PERIPH(FLASH_TypeDef, FLASH_BASE)
+#define GPIOA                   HOST_PERIPH(GPIO_TypeDef, GPIOA_BASE)
+#define GPIOB                   HOST_PERIPH(GPIO_TypeDef, GPIOB_BASE)
+#define GPIOC                   HOST_PERIPH(GPIO_TypeDef, GPIOC_BASE)
+#define GPIOD                   HOST_PERIPH(GPIO_TypeDef, GPIOD_BASE)
+#define SYSCON                  HOST_PERIPH(SYSCON_TypeDef, SYSCON_BASE)
+#define RCC                     HOST_PERIPH(RCC_TypeDef, RCC_BASE)
+#define DBG                     HOST_PERIPH(DBG_TypeDef, DBG_BASE)
+
+#define HOST_IS_CRC(adr)        ((uint32_t)(adr) - CRC_BASE < 0x400U)
+
+static inline volatile uint8_t* host_data8(uint32_t adr)
+{
+    return HOST_IS_CRC(adr) ? crc_emu_data8(adr) : flash_emu_data8(adr);
+}
+
+static inline volatile uint16_t* host_data16(uint32_t adr)
+{
+    return HOST_IS_CRC(adr) ? crc_emu_data16(adr) : flash_emu_data16(adr);
+}
+
+static inline volatile uint32_t* host_data32(uint32_t adr)
+{
+    return HOST_IS_CRC(adr) ? crc_emu_data32(adr) : flash_emu_data32(adr);
+}
+
+#define M8(adr)                 (*host_data8(adr))
+#define M16(adr)                (*host_data16(adr))
+#define M32(adr)                (*host_data32(adr))
+
+/* Code taking a GPIO port base as a constant, multi_button.hpp */
+#define MULTIBUTTON_GPIO_PORT(base) HOST_PERIPH(GPIO_TypeDef, base)
+
+#endif
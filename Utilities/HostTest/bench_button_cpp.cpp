@@ -0,0 +1,156 @@
+/*
+ * Tick cost of the C engine against the C++ front end, eight buttons.
+ *
+ * The pins are plain memory here, refreshed from a prerecorded trace
+ * before every tick, so the numbers are the engines and not the bus
+ * model. Host time, best of BENCH_RUNS: compare the two lines with each
+ * other, the Cortex-M0+ figures are not these.
+ */
+
+#include <wb32l003.h>
+#include "host_test.h"
+
+static GPIO_TypeDef sim_port[2];
+
+#undef MULTIBUTTON_GPIO_PORT
+#define MULTIBUTTON_GPIO_PORT(base) (&sim_port[(base) == GPIOD_BASE])
+#include "multi_button.hpp"
+
+#define BUTTONS                 8
+#define TRACE_TICKS             (1U << 16)
+#define BENCH_TICKS             (1U << 22)
+#define BENCH_RUNS              5
+
+using multibutton::Timing;
+using multibutton::LongStages;
+using multibutton::ButtonSet;
+
+using Set = ButtonSet<
+    multibutton::Button<GPIOC_BASE, GPIO_Pin_0, 0, Timing<>, LongStages<40, 120, 250> >,
+    multibutton::Button<GPIOC_BASE, GPIO_Pin_1, 1>,
+    multibutton::Button<GPIOC_BASE, GPIO_Pin_2, 0>,
+    multibutton::Button<GPIOC_BASE, GPIO_Pin_3, 1>,
+    multibutton::Button<GPIOD_BASE, GPIO_Pin_0, 0, Timing<>, LongStages<40, 120, 250> >,
+    multibutton::Button<GPIOD_BASE, GPIO_Pin_1, 1>,
+    multibutton::Button<GPIOD_BASE, GPIO_Pin_2, 0>,
+    multibutton::Button<GPIOD_BASE, GPIO_Pin_3, 1> >;
+
+static const uint8_t active[BUTTONS] = { 0, 1, 0, 1, 0, 1, 0, 1 };
+static const uint16_t stages[] = { 40, 120, 250 };
+
+static uint16_t trace[TRACE_TICKS][2];
+static struct Button c_btn[BUTTONS];
+static uint32_t events;
+
+static uint8_t c_level(uint16_t id)
+{
+    return (sim_port[id >> 2].IDR >> (id & 3)) & 1;
+}
+
+struct Counter {
+    template<typename Btn>
+    void operator()(const Btn&, PressEvent) { events++; }
+};
+
+/* Random presses of every length, or all buttons released */
+static void trace_build(int busy)
+{
+    uint32_t seed = 0x9E3779B9;
+    uint32_t next[BUTTONS] = { 0 };
+    uint8_t down[BUTTONS] = { 0 };
+    uint32_t t;
+    int i;
+
+    for (t = 0; t < TRACE_TICKS; t++)
+    {
+        trace[t][0] = trace[t][1] = 0;
+        for (i = 0; i < BUTTONS; i++)
+        {
+            uint32_t r = host_test_rand(&seed);
+
+            if (busy && t >= next[i])
+            {
+                down[i] = !down[i];
+                next[i] = t + 1 + r % (down[i] ? 2 * LONG_TICKS : 4 * SHORT_TICKS);
+            }
+            if (down[i] ? active[i] : !active[i])
+                trace[t][i >> 2] |= (uint16_t)(1U << (i & 3));
+        }
+    }
+}
+
+static double bench_c(void)
+{
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    uint64_t best = UINT64_MAX;
+    int run, i;
+
+    for (run = 0; run < BENCH_RUNS; run++)
+    {
+        uint64_t start;
+        uint32_t t;
+
+        for (i = 0; i < BUTTONS; i++)
+        {
+            button_stop(&c_btn[i]);
+            button_init(&c_btn[i], c_level, active[i], (uint16_t)i);
+            button_start(&c_btn[i]);
+        }
+        button_set_long_stages(&c_btn[0], stages, 3);
+        button_set_long_stages(&c_btn[4], stages, 3);
+
+        start = host_test_ns();
+        for (t = 0; t < BENCH_TICKS; t++)
+        {
+            sim_port[0].IDR = trace[t & (TRACE_TICKS - 1)][0];
+            sim_port[1].IDR = trace[t & (TRACE_TICKS - 1)][1];
+            button_ticks();
+            events += button_poll_events(ev, EVENT_QUEUE_SIZE, NULL);
+        }
+        if (host_test_ns() - start < best)
+            best = host_test_ns() - start;
+    }
+    return (double)best / BENCH_TICKS;
+}
+
+static double bench_cpp(void)
+{
+    uint64_t best = UINT64_MAX;
+    int run;
+
+    for (run = 0; run < BENCH_RUNS; run++)
+    {
+        Set set;
+        uint64_t start;
+        uint32_t t;
+
+        start = host_test_ns();
+        for (t = 0; t < BENCH_TICKS; t++)
+        {
+            sim_port[0].IDR = trace[t & (TRACE_TICKS - 1)][0];
+            sim_port[1].IDR = trace[t & (TRACE_TICKS - 1)][1];
+            set.ticks(Counter{});
+        }
+        if (host_test_ns() - start < best)
+            best = host_test_ns() - start;
+    }
+    return (double)best / BENCH_TICKS;
+}
+
+int main(void)
+{
+    static const char* const name[2] = { "idle", "busy" };
+    int busy;
+
+    for (busy = 0; busy < 2; busy++)
+    {
+        double c, cpp;
+
+        trace_build(busy);
+        c = bench_c();
+        cpp = bench_cpp();
+        printf("button_cpp %s, 8 buttons: C %.1f ns/tick, C++ %.1f ns/tick, C/C++ %.2f\n",
+               name[busy], c, cpp, c / cpp);
+    }
+    return events == 0;
+}
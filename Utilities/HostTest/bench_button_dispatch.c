@@ -0,0 +1,111 @@
+/*
+ * Cost of a dispatched callback, plain against context callbacks.
+ *
+ * Eight held buttons queue one LONG_PRESS_HOLD each per tick, two ticks
+ * fill the DEFER_QUEUE_SIZE deferred queue and one button_dispatch() call
+ * runs all of it. The median call, less the median call on an empty
+ * queue, over the callbacks run is the cost of one callback. Host time,
+ * for comparing the two kinds with each other.
+ */
+
+#include <stdlib.h>
+#include "multi_button.h"
+#include "host_test.h"
+
+#define BUTTONS                 8
+#define SAMPLES                 100000
+
+static struct Button btn[BUTTONS];
+static uint64_t sample[SAMPLES];
+static volatile uint32_t calls;
+
+static uint8_t read_level(uint16_t id)
+{
+    (void)id;
+    return 0;
+}
+
+static void plain_cb(void* handle)
+{
+    (void)handle;
+    calls++;
+}
+
+static void ctx_cb(void* user_data, const ButtonEvent* ev)
+{
+    (void)ev;
+    (*(volatile uint32_t*)user_data)++;
+}
+
+static int cmp_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t median(void)
+{
+    qsort(sample, SAMPLES, sizeof(sample[0]), cmp_u64);
+    return sample[SAMPLES / 2];
+}
+
+/* Median time of a button_dispatch() call, a full queue or an empty one */
+static uint64_t bench(int ctx, int full)
+{
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    int i;
+
+    for (i = 0; i < BUTTONS; i++)
+    {
+        button_stop(&btn[i]);
+        button_init(&btn[i], read_level, 0, (uint16_t)i);
+        if (ctx)
+            button_attach_ctx(&btn[i], LONG_PRESS_HOLD, ctx_cb, (void*)&calls);
+        else
+            button_attach(&btn[i], LONG_PRESS_HOLD, plain_cb);
+        button_start(&btn[i]);
+    }
+    for (i = 0; i < DEBOUNCE_TICKS + LONG_TICKS + 2; i++)
+    {
+        button_ticks();
+        button_dispatch();
+    }
+
+    calls = 0;
+    for (i = 0; i < SAMPLES; i++)
+    {
+        uint64_t start;
+
+        if (full)
+        {
+            button_ticks();
+            button_ticks();
+        }
+        start = host_test_ns();
+        button_dispatch();
+        sample[i] = host_test_ns() - start;
+        button_poll_events(ev, EVENT_QUEUE_SIZE, NULL);
+    }
+    if (calls != (full ? SAMPLES * 2 * BUTTONS : 0))
+        return UINT64_MAX;
+    return median();
+}
+
+int main(void)
+{
+    uint64_t plain, ctx, empty;
+
+    empty = bench(0, 0);
+    plain = bench(0, 1);
+    ctx = bench(1, 1);
+    if (plain == UINT64_MAX || ctx == UINT64_MAX || empty == UINT64_MAX)
+    {
+        printf("button_dispatch: callbacks lost\n");
+        return 1;
+    }
+
+    printf("button_dispatch, %d callbacks a call: plain %.1f ns/callback, ctx %.1f ns/callback\n",
+           2 * BUTTONS, (double)(plain - empty) / (2 * BUTTONS), (double)(ctx - empty) / (2 * BUTTONS));
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * button_start(), button_find() and button_stop() with all 65536 ids
+ * started, in random order. Built twice: with the default
+ * BUTTON_ID_HASH_SIZE and with 4096 buckets. Host time.
+ */
+
+#include <stdlib.h>
+#include "multi_button.h"
+#include "host_test.h"
+
+#define IDS                     65536
+
+static struct Button btn[IDS];
+static uint16_t order[IDS];
+
+static uint8_t read_level(uint16_t button_id)
+{
+    (void)button_id;
+    return 1;
+}
+
+int main(void)
+{
+    uint32_t seed = 0xC0FFEE;
+    uint64_t start, t_start, t_find, t_stop;
+    uint32_t found = 0;
+    int i;
+
+    for (i = 0; i < IDS; i++)
+        order[i] = (uint16_t)i;
+    for (i = IDS - 1; i > 0; i--)
+    {
+        int j = (int)(host_test_rand(&seed) % (uint32_t)(i + 1));
+        uint16_t v = order[i];
+
+        order[i] = order[j];
+        order[j] = v;
+    }
+    for (i = 0; i < IDS; i++)
+        button_init(&btn[i], read_level, 0, (uint16_t)i);
+
+    start = host_test_ns();
+    for (i = 0; i < IDS; i++)
+        button_start(&btn[order[i]]);
+    t_start = host_test_ns() - start;
+
+    start = host_test_ns();
+    for (i = 0; i < IDS; i++)
+        found += button_find(order[IDS - 1 - i]) != NULL;
+    t_find = host_test_ns() - start;
+
+    start = host_test_ns();
+    for (i = 0; i < IDS; i++)
+        button_stop(&btn[order[i]]);
+    t_stop = host_test_ns() - start;
+
+    printf("button_ids, %d ids, %d buckets: start %.1f ns, find %.1f ns, stop %.1f ns\n",
+           IDS, BUTTON_ID_HASH_SIZE, (double)t_start / IDS, (double)t_find / IDS, (double)t_stop / IDS);
+    return found != IDS;
+}
@@ -0,0 +1,71 @@
+/*
+ * CRC throughput on the CRC unit model in emulated cycles, every data
+ * window or register access one bus access: CRC_Calculate() with its
+ * reset and byte feed against a context fed with word bursts, for long
+ * buffers and for 64 byte frames in three scatter-gather segments.
+ * Loop and load instructions are not counted, the figures are the bus
+ * bound of each feed.
+ */
+
+#include <wb32l003.h>
+#include "wb32l003_crc.h"
+#include "wb32l003_rcc.h"
+#include "host_test.h"
+
+#define LONG_LEN                4096
+#define FRAME_LEN               64
+#define FRAMES                  (LONG_LEN / FRAME_LEN)
+
+static uint32_t words[LONG_LEN / 4];
+
+static void report(const char* name, uint64_t cycles, uint32_t bytes)
+{
+    printf("crc, %-28s: %6.2f cycles/byte, %5.3f bytes/cycle\n",
+           name, (double)cycles / bytes, (double)bytes / cycles);
+}
+
+int main(void)
+{
+    const uint8_t* data = (const uint8_t*)words;
+    CRC_ContextTypeDef ctx;
+    uint32_t seed = 0xBE4C;
+    uint64_t at;
+    uint32_t i, calc = 0, stream;
+
+    core_emu_reset();
+    SystemInit();
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_CRC, ENABLE);
+    for (i = 0; i < LONG_LEN / 4; i++)
+        words[i] = host_test_rand(&seed);
+
+    at = core_emu_cycles();
+    calc = CRC_Calculate(data, LONG_LEN);
+    report("CRC_Calculate 4 KB", core_emu_cycles() - at, LONG_LEN);
+
+    at = core_emu_cycles();
+    CRC_ContextInit(&ctx);
+    CRC_ContextUpdate(&ctx, data, LONG_LEN);
+    report("context 4 KB", core_emu_cycles() - at, LONG_LEN);
+    stream = CRC_ContextFinal(&ctx);
+
+    at = core_emu_cycles();
+    for (i = 0; i < FRAMES; i++)
+        calc ^= CRC_Calculate(data + i * FRAME_LEN, FRAME_LEN);
+    report("CRC_Calculate 64 B frames", core_emu_cycles() - at, FRAMES * FRAME_LEN);
+
+    at = core_emu_cycles();
+    for (i = 0; i < FRAMES; i++)
+    {
+        const uint8_t* frame = data + i * FRAME_LEN;
+
+        /* header, unaligned payload, trailer */
+        CRC_ContextInit(&ctx);
+        CRC_ContextUpdate(&ctx, frame, 5);
+        CRC_ContextUpdate(&ctx, frame + 5, FRAME_LEN - 9);
+        CRC_ContextUpdate(&ctx, frame + FRAME_LEN - 4, 4);
+        stream ^= CRC_ContextFinal(&ctx);
+    }
+    report("context 64 B frames, 3 segs", core_emu_cycles() - at, FRAMES * FRAME_LEN);
+
+    return calc != stream;
+}
@@ -0,0 +1,60 @@
+/*
+ * crc16_soft throughput on the host: bit at a time, slicing-by-8 and
+ * carry-less multiply, over a 64 KB image and over 64 byte frames.
+ */
+
+#include <wb32l003.h>
+#include "crc16_soft.h"
+#include "host_test.h"
+
+#define IMAGE_LEN               0x10000
+#define FRAME_LEN               64
+#define TOTAL                   (256UL << 20)   /* bytes per measurement */
+
+typedef uint16_t (*CrcFn)(uint16_t crc, const uint8_t* data, size_t len);
+
+static uint8_t image[IMAGE_LEN];
+static volatile uint16_t sink;
+
+static void measure(const char* name, CrcFn fn, size_t len, unsigned long total)
+{
+    unsigned long runs = total / len, i;
+    uint32_t off = 0;
+    uint16_t crc = 0;
+    uint64_t start = host_test_ns(), ns;
+
+    for (i = 0; i < runs; i++)
+    {
+        crc ^= fn(CRC16_SOFT_SEED, image + off, len);
+        off = (off + len) % IMAGE_LEN;
+    }
+    ns = host_test_ns() - start;
+    sink = crc;
+    printf("crc16_soft, %-8s %5u B: %8.1f MB/s, %6.2f ns/byte\n",
+           name, (unsigned)len, (double)runs * len * 1000.0 / ns, (double)ns / ((double)runs * len));
+}
+
+int main(void)
+{
+    uint32_t seed = 0xB16C;
+    uint32_t i;
+
+    for (i = 0; i < IMAGE_LEN; i++)
+        image[i] = (uint8_t)host_test_rand(&seed);
+
+    measure("bitwise", crc16_soft_bitwise, IMAGE_LEN, TOTAL / 16);
+    measure("table", crc16_soft_table, IMAGE_LEN, TOTAL);
+    measure("table", crc16_soft_table, FRAME_LEN, TOTAL);
+#if CRC16_SOFT_CLMUL
+    if (crc16_soft_clmul_supported())
+    {
+        measure("clmul", crc16_soft_clmul, IMAGE_LEN, TOTAL * 4);
+        measure("clmul", crc16_soft_clmul, FRAME_LEN, TOTAL);
+    }
+    else
+    {
+        printf("crc16_soft, no PCLMULQDQ on this host\n");
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * event_stream on the host: wire bytes per event and what a 115200 baud
+ * line carries, with full frames and with a frame per event (the pump
+ * without batching), and encode and decode time per event. 100000
+ * random events, ids below 8, deltas of a few ticks, stage and long
+ * durations now and then. Every event is checked after the decode.
+ */
+
+#include <string.h>
+#include "event_stream.h"
+#include "host_test.h"
+
+#define EVENTS                  100000
+#define BAUD                    115200
+#define PASSES                  20
+
+static ButtonEvent events[EVENTS];
+static ButtonEvent decoded[256];
+static uint8_t wire[EVENTS * 16];
+static uint32_t wire_len;
+static uint32_t decoded_count, mismatches;
+
+static void tx_write(const uint8_t* buf, uint16_t len)
+{
+    memcpy(wire + wire_len, buf, len);
+    wire_len += len;
+}
+
+static uint16_t tx_free(void)
+{
+    return 0xFFFF;
+}
+
+static void on_frame(const uint8_t* frame, uint16_t len, void* arg)
+{
+    int n = evstream_decode(frame, len, decoded, 256, 0), i;
+
+    (void)arg;
+    if (n < 0)
+    {
+        mismatches++;
+        return;
+    }
+    for (i = 0; i < n; i++, decoded_count++)
+    {
+        const ButtonEvent* a = &decoded[i];
+        const ButtonEvent* b = &events[decoded_count];
+
+        mismatches += a->timestamp != b->timestamp || a->button_id != b->button_id || a->event != b->event ||
+                      a->repeat != b->repeat || a->stage != b->stage || a->duration != b->duration;
+    }
+}
+
+/* Every event through the encoder, per_frame events per frame at most */
+static void encode(uint32_t per_frame)
+{
+    EvStream s;
+    uint32_t i;
+
+    wire_len = 0;
+    evstream_init(&s, tx_free, tx_write);
+    for (i = 0; i < EVENTS; i++)
+    {
+        if (s.count == per_frame || evstream_add(&s, &events[i]) != 0)
+        {
+            evstream_finish(&s);
+            tx_write(s.out, s.out_len);
+            s.out_len = 0;
+            evstream_add(&s, &events[i]);
+        }
+    }
+    evstream_finish(&s);
+    tx_write(s.out, s.out_len);
+}
+
+static void decode(void)
+{
+    static uint8_t buf[EVSTREAM_FRAME_MAX];
+    CobsDecoder dec;
+    uint32_t i;
+
+    decoded_count = 0;
+    cobs_decoder_init(&dec, buf, sizeof(buf), on_frame, 0);
+    for (i = 0; i < wire_len; i++)
+        cobs_decode_byte(&dec, wire[i]);
+}
+
+static void run(const char* name, uint32_t per_frame)
+{
+    uint64_t start, enc = 0, dec = 0;
+    uint32_t pass;
+
+    for (pass = 0; pass < PASSES; pass++)
+    {
+        start = host_test_ns();
+        encode(per_frame);
+        enc += host_test_ns() - start;
+        start = host_test_ns();
+        decode();
+        dec += host_test_ns() - start;
+    }
+    printf("event_stream, %-15s %5.2f bytes/event, %5.0f events/s at %u baud, "
+           "encode %5.1f ns/event, decode %5.1f ns/event\n",
+           name, (double)wire_len / EVENTS, (double)BAUD / 10 * EVENTS / wire_len, BAUD,
+           (double)enc / PASSES / EVENTS, (double)dec / PASSES / EVENTS);
+    if (decoded_count != EVENTS)
+        mismatches++;
+}
+
+int main(void)
+{
+    uint32_t seed = 0xE5B0, time = 0, i;
+
+    for (i = 0; i < EVENTS; i++)
+    {
+        uint32_t r = host_test_rand(&seed);
+        ButtonEvent* ev = &events[i];
+
+        time += r % 64;
+        ev->timestamp = time;
+        ev->button_id = (uint16_t)((r >> 6) % 8);
+        ev->event = (r >> 9) % 8;
+        ev->repeat = (r >> 12) & 3;
+        ev->stage = (r >> 14) % 16 == 0 ? (uint8_t)((r >> 18) % 4 + 1) : 0;
+        ev->duration = (uint16_t)((r >> 20) % 8 == 0 ? r % 2000 : (r >> 24) % 100);
+    }
+
+    run("full frames", 0xFF);
+    run("frame per event", 1);
+    printf("event_stream, decoded events %s\n", mismatches ? "WRONG" : "ok");
+    return mismatches != 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Programming a 512 byte page on the flash model in core cycles:
+ * FLASH_ProgramWord() per word, each unlocking and locking every sector,
+ * against FLASH_ProgramBuffer(), which unlocks its sector once, plus the
+ * BYPASS unlocks, locks and SLOCK writes and the longest interrupt
+ * masked window of each. Both keep the 0xFFF FLASH_OP_Delay() per word;
+ * loop instructions are free in the model, bus accesses and BUSY time
+ * are not, so the ratio is what dropping the unlocks saves.
+ */
+
+#include <wb32l003.h>
+#include "wb32l003_flash.h"
+#include "host_test.h"
+
+#define PAGE                    0x9000
+#define WORDS                   (FLASH_PAGE_SIZE / 4)
+#define US(cycles)              ((double)(cycles) / (CORE_EMU_HCLK / 1000000))
+
+static uint32_t data[WORDS];
+
+static void report(const char* name, uint64_t cycles)
+{
+    const FlashEmuStats* stats = flash_emu_stats();
+
+    printf("flash, %-19s: %8llu cycles (%7.1f us), %6.1f us/word, IRQs off at most %5.1f us\n",
+           name, (unsigned long long)cycles, US(cycles), US(cycles) / WORDS,
+           US(core_emu_stats()->irq_off_max));
+    printf("flash, %-19s: %4lu unlocks, %4lu locks, %4lu SLOCK writes\n", name,
+           (unsigned long)stats->unlocks, (unsigned long)stats->locks, (unsigned long)stats->slock_changes);
+}
+
+int main(void)
+{
+    uint64_t at, words, buffer;
+    uint32_t seed = 0xF1A5;
+    uint32_t i;
+
+    for (i = 0; i < WORDS; i++)
+        data[i] = host_test_rand(&seed);
+
+    core_emu_reset();
+    flash_emu_init(NULL);
+    at = core_emu_cycles();
+    for (i = 0; i < WORDS; i++)
+    {
+        if (FLASH_ProgramWord(PAGE + 4 * i, data[i]) != FLASH_COMPLETE)
+            return 1;
+    }
+    words = core_emu_cycles() - at;
+    report("ProgramWord x 128", words);
+
+    core_emu_reset();
+    flash_emu_init(NULL);
+    at = core_emu_cycles();
+    if (FLASH_ProgramBuffer(PAGE, data, WORDS) != FLASH_COMPLETE)
+        return 1;
+    buffer = core_emu_cycles() - at;
+    report("ProgramBuffer", buffer);
+
+    printf("flash, ProgramBuffer speedup %.2fx\n", (double)words / buffer);
+    return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * kv_cache on kv_store and the flash model: a click counter workload for
+ * one simulated hour, one click per 700 ms on average (400 to 1000 ms
+ * apart) spread over three counters, each click a kv_cache_set() of its
+ * counter. The soft timers tick every 1 ms and the idle loop runs
+ * kv_cache_idle() after each tick; a commit takes as long as its flash
+ * operations keep the model BUSY and the ticks catch up after it.
+ *
+ * Printed per hour: the updates, what the cache coalesced, the commits,
+ * the records, programs and erases they cost the flash, against the
+ * records of one kv_set() per click, and the longest commit in us.
+ */
+
+#include <wb32l003.h>
+#include "kv_cache.h"
+#include "kv_store.h"
+#include "soft_timer.h"
+#include "host_test.h"
+
+#define HOUR_MS                 3600000
+#define COUNTERS                3
+#define CLICK_MIN_MS            400
+#define CLICK_SPAN_MS           601     /* clicks 400 to 1000 ms apart */
+#define CYCLES_PER_MS           (CORE_EMU_HCLK / 1000)
+
+static uint32_t clock_us(void)
+{
+    return (uint32_t)(core_emu_cycles() / (CORE_EMU_HCLK / 1000000));
+}
+
+int main(void)
+{
+    const KvCacheStats* s = kv_cache_stats();
+    uint32_t counter[COUNTERS] = { 0 };
+    uint32_t seed = 0xC11C, next_click = 0, ms, i;
+    uint32_t programs, erases;
+
+    core_emu_reset();
+    flash_emu_init(NULL);
+    CHECK_EQ(kv_init(), 0);
+    kv_cache_init();
+    kv_cache_set_clock(clock_us);
+    programs = flash_emu_stats()->programs;
+    erases = flash_emu_stats()->erases;
+
+    for (ms = 0; ms < HOUR_MS; ms++)
+    {
+        uint64_t at = (uint64_t)ms * CYCLES_PER_MS;
+
+        if (core_emu_cycles() < at)
+            core_emu_run(at - core_emu_cycles());
+        soft_timer_ticks();
+        if (ms == next_click)
+        {
+            uint32_t r = host_test_rand(&seed);
+            uint16_t key = (uint16_t)(r % COUNTERS);
+
+            counter[key]++;
+            CHECK_EQ(kv_cache_set(key, &counter[key], sizeof(counter[key])), 0);
+            next_click += CLICK_MIN_MS + (r >> 8) % CLICK_SPAN_MS;
+        }
+        kv_cache_idle();
+    }
+    CHECK_EQ(kv_cache_commit(), 0);
+
+    for (i = 0; i < COUNTERS; i++)
+    {
+        uint32_t v = 0;
+
+        CHECK_EQ(kv_get((uint16_t)i, &v, sizeof(v)), sizeof(v));
+        CHECK_EQ(v, counter[i]);
+    }
+
+    printf("kv_cache, one hour: %u updates, %u coalesced, %u commits\n",
+           (unsigned)s->sets, (unsigned)s->coalesced, (unsigned)s->commits);
+    printf("kv_cache, flash writes/hour: %u records, %u programs, %u page erases "
+           "(a kv_set per click: %u records)\n",
+           (unsigned)s->writes, (unsigned)(flash_emu_stats()->programs - programs),
+           (unsigned)(flash_emu_stats()->erases - erases), (unsigned)s->sets);
+    printf("kv_cache, worst commit: %u us\n", (unsigned)s->commit_max);
+    return host_test_failures != 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * kv_store on the flash model: the cost of kv_get() on a full store, hits
+ * and misses, and of kv_init() on a full ring, as a boot after a clean
+ * shutdown and as the worst boot, after power was lost between opening a
+ * page and collecting the oldest one, which then collects at boot.
+ *
+ * Cycles are core_emu cycles: bus accesses and BUSY time of the flash
+ * operations. The index work itself runs free in the model and is given
+ * in host time where no flash operation runs. Flash operations are
+ * programs and erases.
+ */
+
+#include <string.h>
+#include <wb32l003.h>
+#include "kv_store.h"
+#include "host_test.h"
+
+#define FILL_WRITES             2000
+#define LOOKUPS                 1000000
+#define BOOTS                   20
+
+typedef struct {
+    uint64_t cycles;
+    uint32_t ops;
+    uint64_t ns;
+} Cost;
+
+static uint32_t seed = 0x4B5BE;
+
+static uint32_t flash_ops(void)
+{
+    return flash_emu_stats()->programs + flash_emu_stats()->erases;
+}
+
+/* Host time only without flash operations, with them it is the model's */
+static void report(const char* name, const Cost* c, uint32_t runs)
+{
+    printf("kv_store, %-27s: %8.0f cycles (%7.1f us), %5.1f flash ops", name,
+           (double)c->cycles / runs, (double)c->cycles / runs / (CORE_EMU_HCLK / 1000000),
+           (double)c->ops / runs);
+    if (c->ops == 0)
+        printf(", host %8.1f ns", (double)c->ns / runs);
+    printf("\n");
+}
+
+/* KV_MAX_KEYS keys rewritten until the ring has turned over many times */
+static void fill(void)
+{
+    uint8_t value[16];
+    uint32_t i;
+
+    core_emu_reset();
+    flash_emu_init(NULL);
+    if (kv_init() != 0)
+        CHECK(0);
+    for (i = 0; i < FILL_WRITES; i++)
+    {
+        uint32_t r = host_test_rand(&seed);
+        uint16_t len = (uint16_t)(1 + r % sizeof(value));
+
+        memset(value, (int)i, len);
+        CHECK_EQ(kv_set((uint16_t)(i < KV_MAX_KEYS ? i : (r >> 8) % KV_MAX_KEYS), value, len), 0);
+    }
+    CHECK_EQ(kv_count(), KV_MAX_KEYS);
+}
+
+static void lookups(void)
+{
+    uint8_t value[KV_VALUE_MAX];
+    Cost hit = { 0 }, miss = { 0 };
+    uint64_t at, start;
+    uint32_t ops, i, found = 0;
+
+    at = core_emu_cycles();
+    ops = flash_ops();
+    start = host_test_ns();
+    for (i = 0; i < LOOKUPS; i++)
+        found += kv_get((uint16_t)(i % KV_MAX_KEYS), value, sizeof(value)) > 0;
+    hit.ns = host_test_ns() - start;
+    hit.cycles = core_emu_cycles() - at;
+    hit.ops = flash_ops() - ops;
+    CHECK_EQ(found, LOOKUPS);
+
+    start = host_test_ns();
+    for (i = 0; i < LOOKUPS; i++)
+        found += kv_get((uint16_t)(KV_MAX_KEYS + i % 1000), value, sizeof(value)) > 0;
+    miss.ns = host_test_ns() - start;
+    miss.cycles = core_emu_cycles() - at - hit.cycles;
+    miss.ops = flash_ops() - ops - hit.ops;
+    CHECK_EQ(found, LOOKUPS);
+
+    report("kv_get, hit", &hit, LOOKUPS);
+    report("kv_get, miss", &miss, LOOKUPS);
+}
+
+/* One boot of the store as it is in flash now */
+static void boot(Cost* c)
+{
+    uint64_t at, start;
+    uint32_t ops;
+
+    core_emu_reset();
+    at = core_emu_cycles();
+    ops = flash_ops();
+    start = host_test_ns();
+    CHECK_EQ(kv_init(), 0);
+    c->ns += host_test_ns() - start;
+    c->cycles += core_emu_cycles() - at;
+    c->ops += flash_ops() - ops;
+    CHECK_EQ(kv_count(), KV_MAX_KEYS);
+}
+
+static uint8_t ring[KV_PAGES * FLASH_PAGE_SIZE];
+
+/* The erased spare opened as the newest page, nothing collected yet */
+static void open_spare(void)
+{
+    uint32_t page, newest = KV_PAGES, seq = 0, spare = KV_PAGES;
+
+    for (page = 0; page < KV_PAGES; page++)
+    {
+        uint32_t addr = KV_FLASH_BASE + page * FLASH_PAGE_SIZE;
+        uint32_t magic, s;
+
+        memcpy(&magic, flash_emu_mem(addr), 4);
+        memcpy(&s, flash_emu_mem(addr + 4), 4);
+        if (magic == 0xFFFFFFFF)
+            spare = page;
+        else if (newest == KV_PAGES || (int32_t)(s - seq) > 0)
+        {
+            newest = page;
+            seq = s;
+        }
+    }
+    CHECK(spare == (newest + 1) % KV_PAGES);
+    spare = KV_FLASH_BASE + spare * FLASH_PAGE_SIZE;
+    CHECK_EQ(FLASH_ProgramWord(spare + 4, seq + 1), FLASH_COMPLETE);
+    memcpy(&seq, flash_emu_mem(KV_FLASH_BASE + newest * FLASH_PAGE_SIZE), 4);
+    CHECK_EQ(FLASH_ProgramWord(spare, seq), FLASH_COMPLETE);
+}
+
+int main(void)
+{
+    Cost clean = { 0 }, cut = { 0 };
+    uint32_t i;
+
+    fill();
+    lookups();
+    memcpy(ring, flash_emu_mem(KV_FLASH_BASE), sizeof(ring));
+
+    for (i = 0; i < BOOTS; i++)
+    {
+        memcpy(flash_emu_mem(KV_FLASH_BASE), ring, sizeof(ring));
+        boot(&clean);
+        open_spare();
+        boot(&cut);
+    }
+    report("kv_init, full ring", &clean, BOOTS);
+    report("kv_init, cut before collect", &cut, BOOTS);
+    printf("kv_store, kv_init scans at most %u bytes and collects at most one page\n",
+           KV_PAGES * FLASH_PAGE_SIZE);
+    return host_test_failures != 0;
+}
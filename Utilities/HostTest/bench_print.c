@@ -0,0 +1,112 @@
+/*
+ * printf output on the LPUART model at 115200 baud: the time the caller
+ * is stalled per line, before (fputc waiting on TI for every character)
+ * and after (the TX ring fed by the TI interrupt), in emulated time. The
+ * formatting itself is not counted, only the character output.
+ *
+ *   40 char line       blocking fputc vs the ring
+ *   400 char burst     PRINT_OVERFLOW_BLOCK past the ring size, thread
+ *   40 char line       from an ISR on a full ring, polled
+ *
+ * Every run checks the bytes on the line.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <wb32l003.h>
+#include "bsp_lpuart1.h"
+#include "host_test.h"
+
+#define US(cycles)              ((double)(cycles) / (CORE_EMU_HCLK / 1000000))
+#define LINE_LEN                40
+#define BURST_LEN               400
+
+static uint8_t text[BURST_LEN];
+static uint8_t wire[BURST_LEN];
+static uint64_t isr_cycles;
+
+/* Retarget_lpuart1.c fputc() before the ring */
+static void blocking_putc(uint8_t ch)
+{
+    LPUART->SCON |= LPUART_SCON_TIEN;
+    LPUART->SBUF = ch;
+    while (!(LPUART->INTSR & LPUART_INTSR_TI));
+    LPUART->INTCLR |= LPUART_INTCLR_TICLR_Msk;
+    LPUART->SCON &= (~LPUART_SCON_TIEN);
+}
+
+/* The line drains, then what it carried must be text */
+static int line_carries(uint32_t len)
+{
+    print_flush();
+    core_emu_run(uart_emu_byte_cycles(LPUART_BASE));
+    return uart_emu_tx(LPUART_BASE, wire, sizeof(wire)) == len && memcmp(wire, text, len) == 0;
+}
+
+void LVD_IRQHandler(void)
+{
+    uint64_t start = core_emu_cycles();
+
+    print_write(text, LINE_LEN);
+    isr_cycles = core_emu_cycles() - start;
+}
+
+int main(void)
+{
+    uint64_t start, blocking, ring, burst, isr_off;
+    uint64_t byte = 0;
+    uint32_t i;
+    int ok = 1;
+
+    for (i = 0; i < BURST_LEN; i++)
+        text[i] = (uint8_t)(' ' + i % 95);
+
+    core_emu_reset();
+    SystemInit();
+    print_init(115200);
+    byte = uart_emu_byte_cycles(LPUART_BASE);
+
+    /* before: every character waits for its stop bit */
+    NVIC_DisableIRQ(LPUART_IRQn);
+    start = core_emu_cycles();
+    for (i = 0; i < LINE_LEN; i++)
+        blocking_putc(text[i]);
+    blocking = core_emu_cycles() - start;
+    ok &= line_carries(LINE_LEN);
+    print_init(115200);
+
+    /* after: the line is queued, the TX interrupt sends it */
+    start = core_emu_cycles();
+    print_write(text, LINE_LEN);
+    ring = core_emu_cycles() - start;
+    ok &= line_carries(LINE_LEN);
+
+    /* a burst past the ring blocks with interrupts on */
+    core_emu_clear_stats();
+    start = core_emu_cycles();
+    print_write(text, BURST_LEN);
+    burst = core_emu_cycles() - start;
+    isr_off = core_emu_stats()->irq_off_max;
+    ok &= line_carries(BURST_LEN);
+
+    /* an ISR printing on a full ring sends by polling */
+    print_write(text, PRINT_TX_RING_SIZE - 1);
+    NVIC_EnableIRQ(LVD_IRQn);
+    NVIC_SetPendingIRQ(LVD_IRQn);
+    core_emu_run(1);
+    print_flush();
+    core_emu_run(byte);
+    ok &= uart_emu_tx(LPUART_BASE, wire, sizeof(wire)) == PRINT_TX_RING_SIZE - 1 + LINE_LEN &&
+          memcmp(wire, text, PRINT_TX_RING_SIZE - 1) == 0 &&
+          memcmp(wire + PRINT_TX_RING_SIZE - 1, text, LINE_LEN) == 0;
+
+    printf("print, %d char line:  blocking fputc %8.1f us, ring %6.1f us, %.0fx less stall\n",
+           LINE_LEN, US(blocking), US(ring), (double)blocking / ring);
+    printf("print, %d char burst: %8.1f us stalled, %u bytes past the ring at %.1f us each, "
+           "longest IRQ-off window %.1f us\n",
+           BURST_LEN, US(burst), (unsigned)(BURST_LEN - (PRINT_TX_RING_SIZE - 1)), US(byte), US(isr_off));
+    printf("print, %d char line from an ISR on a full ring: %8.1f us in the handler, polled\n",
+           LINE_LEN, US(isr_cycles));
+    printf("print, line contents %s\n", ok ? "ok" : "WRONG");
+    return !ok;
+}
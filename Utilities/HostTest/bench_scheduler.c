@@ -0,0 +1,216 @@
+/*
+ * Scheduler workload, main.c's SCHEDULER setup plus a UART RX task and a
+ * timer expiry task, 10 s of emulated time:
+ *
+ *   prio 0  UART1 RX: a 24 byte COBS frame every 20 ms at 115200 baud,
+ *           the RX interrupt posts the task, 40 cycles per byte drained
+ *   prio 1  buttons: random presses, context callbacks post the task,
+ *           300 cycles per event drained
+ *   prio 2  timer: a 10 ms soft timer posts it, 2400 cycles of work
+ *
+ * Reports post to run latency and run time per task in emulated time,
+ * the idle share and what the RX path lost.
+ */
+
+#include <stdlib.h>
+#include <wb32l003.h>
+#include "bsp_button_tick.h"
+#include "bsp_timebase.h"
+#include "bsp_uart_rx.h"
+#include "cobs.h"
+#include "scheduler.h"
+#include "soft_timer.h"
+#include "multi_button.h"
+#include "host_test.h"
+
+#define US(us)                  ((uint64_t)(us) * (CORE_EMU_HCLK / 1000000))
+#define RUN_MS                  10000
+#define FRAME_LEN               24
+#define FRAME_MS                20
+#define BTN_PIN                 GPIO_Pin_3
+
+typedef struct {
+    SchedTask task;
+    const char* name;
+    uint64_t posted;            /* cycle of the post that queued it */
+    uint64_t latency_sum;
+    uint64_t latency_max;
+    uint32_t runs;
+} Job;
+
+static Job rx_job = { .name = "uart rx" };
+static Job btn_job = { .name = "buttons" };
+static Job tmr_job = { .name = "timer" };
+
+static struct Button btn;
+static SoftTimer tmr;
+static CobsDecoder dec;
+static uint8_t frame_buf[FRAME_LEN + 8];
+static uint32_t frames, events, seed = 0xBE11C4;
+static uint32_t start_us;
+
+static void post(Job* job)
+{
+    if (sched_post(&job->task) == 0)
+        job->posted = core_emu_cycles();
+}
+
+static void job_started(Job* job)
+{
+    uint64_t latency = core_emu_cycles() - job->posted;
+
+    job->runs++;
+    job->latency_sum += latency;
+    if (latency > job->latency_max)
+        job->latency_max = latency;
+}
+
+static void rx_notify(void* arg)
+{
+    post((Job*)arg);
+}
+
+static void btn_post(void* arg, const ButtonEvent* ev)
+{
+    (void)ev;
+    post((Job*)arg);
+}
+
+static void tmr_expired(void)
+{
+    post(&tmr_job);
+}
+
+static void on_frame(const uint8_t* frame, uint16_t len, void* arg)
+{
+    (void)frame;
+    (void)arg;
+    frames += len == FRAME_LEN;
+}
+
+static void report(void)
+{
+    const Job* jobs[] = { &rx_job, &btn_job, &tmr_job };
+    uint32_t total_us = Timebase_GetUs() - start_us;
+    uint32_t i;
+
+    for (i = 0; i < 3; i++)
+    {
+        const Job* j = jobs[i];
+        printf("scheduler, %-7s: %5u runs, latency mean %6.1f us max %6.1f us, run mean %6.1f us max %4u us\n",
+               j->name, (unsigned)j->runs,
+               j->runs ? (double)j->latency_sum / j->runs / US(1) : 0.0,
+               (double)j->latency_max / US(1),
+               j->task.run_count ? (double)j->task.run_time / j->task.run_count : 0.0,
+               (unsigned)j->task.run_max);
+    }
+    printf("scheduler, idle %.1f%%, %u/%u frames, %u events, ring overruns %u, line lost %u\n",
+           100.0 * sched_idle_time() / total_us, (unsigned)frames, RUN_MS / FRAME_MS - 1,
+           (unsigned)events, (unsigned)UartRx_Overruns(UART_RX_UART1),
+           (unsigned)uart_emu_rx_lost(UART1_BASE));
+}
+
+static void rx_task(void* arg)
+{
+    int ch;
+
+    job_started(&rx_job);
+    while ((ch = UartRx_Getc(UART_RX_UART1)) >= 0)
+    {
+        cobs_decode_byte(&dec, (uint8_t)ch);
+        core_emu_cost(40);
+    }
+}
+
+static void btn_task(void* arg)
+{
+    ButtonEvent buf[EVENT_QUEUE_SIZE];
+    uint16_t n;
+
+    job_started(&btn_job);
+    n = button_poll_events(buf, EVENT_QUEUE_SIZE, 0);
+    events += n;
+    core_emu_cost(300U * n);
+}
+
+static void tmr_task(void* arg)
+{
+    job_started(&tmr_job);
+    core_emu_cost(2400);
+    if (Timebase_GetMs() >= RUN_MS)
+    {
+        report();
+        exit(rx_job.runs == 0 || btn_job.runs == 0);
+    }
+}
+
+static uint8_t read_btn(uint16_t id)
+{
+    return GPIO_ReadInputDataBit(GPIOD, BTN_PIN);
+}
+
+static void script(void)
+{
+    uint8_t payload[FRAME_LEN], wire[COBS_MAX_ENCODED(FRAME_LEN)];
+    uint32_t ms, i;
+
+    for (ms = FRAME_MS; ms < RUN_MS; ms += FRAME_MS)
+    {
+        uint16_t len;
+
+        for (i = 0; i < FRAME_LEN; i++)
+            payload[i] = (uint8_t)host_test_rand(&seed);
+        len = cobs_encode(payload, FRAME_LEN, wire);
+        uart_emu_rx_at(US(ms * 1000), UART1_BASE, wire, len);
+    }
+    for (ms = 300; ms < RUN_MS - 1500; ms += 400 + host_test_rand(&seed) % 800)
+    {
+        uint32_t hold = 60 + host_test_rand(&seed) % 1400;
+
+        gpio_emu_drive_at(US(ms * 1000), GPIOD_BASE, BTN_PIN, 0);
+        gpio_emu_drive_at(US((ms + hold) * 1000), GPIOD_BASE, BTN_PIN, 1);
+        ms += hold;
+    }
+}
+
+int main(void)
+{
+    UART_InitTypeDef UART_InitStruct;
+    uint8_t ev;
+
+    core_emu_reset();
+    SystemInit();
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOD, ENABLE);
+    GPIO_Init(GPIOD, BTN_PIN, GPIO_MODE_IN | GPIO_SPEED_HIGH);
+    gpio_emu_drive(GPIOD_BASE, BTN_PIN, 1);
+
+    RCC_APBPeriphClockCmd(RCC_APBPeriph_UART1, ENABLE);
+    UART_StructInit(&UART_InitStruct);
+    UART_Init(UART1, &UART_InitStruct);
+    UART_Cmd(UART1, ENABLE);
+    cobs_decoder_init(&dec, frame_buf, sizeof(frame_buf), on_frame, 0);
+
+    sched_task_init(&rx_job.task, rx_task, 0, 0);
+    sched_task_init(&btn_job.task, btn_task, 0, 1);
+    sched_task_init(&tmr_job.task, tmr_task, 0, 2);
+
+    UartRx_Init(UART_RX_UART1);
+    UartRx_SetNotify(UART_RX_UART1, rx_notify, &rx_job);
+
+    button_init(&btn, read_btn, 0, 0);
+    for (ev = 0; ev < number_of_event; ev++)
+        button_attach_ctx(&btn, (PressEvent)ev, btn_post, &btn_job);
+    button_start(&btn);
+
+    Timebase_Init();
+    Timebase_AddPeriodic(soft_timer_ticks, 1);
+    ButtonTick_Init();
+    soft_timer_init(&tmr, tmr_expired, 10, 10);
+    soft_timer_start(&tmr);
+
+    script();
+    start_us = Timebase_GetUs();
+    sched_set_clock(Timebase_GetUs);
+    sched_run();
+}
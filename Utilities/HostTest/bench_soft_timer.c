@@ -0,0 +1,67 @@
+/*
+ * soft_timer with 1000 armed periodic timers, periods 1..1000 ticks:
+ * host time per soft_timer_ticks(), per expiry and per start/stop pair.
+ * Built with SOFT_TIMER_MAX 1024, a heap of 4 KB. Every PRIMASK write
+ * syncs the peripheral models in the emulator, its cost is printed apart.
+ */
+
+#include <wb32l003.h>
+#include "soft_timer.h"
+#include "host_test.h"
+
+#define TIMERS                  1000
+#define TICKS                   100000
+
+static SoftTimer timers[TIMERS];
+static uint32_t expiries;
+
+static void expired(void)
+{
+    expiries++;
+}
+
+int main(void)
+{
+    uint32_t seed = 0x1000;
+    uint64_t start, t_ticks, t_restart, t_mask;
+    int i;
+
+    core_emu_reset();
+    for (i = 0; i < TIMERS; i++)
+    {
+        uint32_t period = 1 + host_test_rand(&seed) % 1000;
+
+        soft_timer_init(&timers[i], expired, period, period);
+        if (soft_timer_start(&timers[i]))
+            return 1;
+    }
+
+    start = host_test_ns();
+    for (i = 0; i < TICKS; i++)
+        soft_timer_ticks();
+    t_ticks = host_test_ns() - start;
+
+    start = host_test_ns();
+    for (i = 0; i < TICKS; i++)
+    {
+        SoftTimer* t = &timers[host_test_rand(&seed) % TIMERS];
+
+        soft_timer_stop(t);
+        soft_timer_start(t);
+    }
+    t_restart = host_test_ns() - start;
+
+    start = host_test_ns();
+    for (i = 0; i < TICKS; i++)
+    {
+        __disable_irq();
+        __enable_irq();
+    }
+    t_mask = host_test_ns() - start;
+
+    printf("soft_timer, %d timers: tick %.1f ns, %.2f expiries/tick, %.1f ns/expiry, stop+start %.1f ns\n",
+           TIMERS, (double)t_ticks / TICKS, (double)expiries / TICKS,
+           (double)t_ticks / expiries, (double)t_restart / TICKS);
+    printf("soft_timer, emulated PRIMASK mask+unmask %.1f ns\n", (double)t_mask / TICKS);
+    return expiries == 0;
+}
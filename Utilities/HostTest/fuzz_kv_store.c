@@ -0,0 +1,266 @@
+/*
+ * kv_store fuzzer on the flash emulator: random sets, deletes and reads
+ * checked against a model of the store, with injected flash faults. A
+ * sweep first puts a fault on every flash operation of a write that
+ * collects a page full of live records, then the random run:
+ *
+ *   transient  one program or erase dropped somewhere in an operation,
+ *              which then fails and leaves the key as it was; the store
+ *              must mount to the same contents and go on working, the
+ *              collect abort and retry paths included
+ *   power cut  every operation dropped from some point on, then a reboot:
+ *              kv_init() must mount, the key being written holds its old
+ *              or its new value and every other key is exact
+ *
+ *   fuzz_kv_store [seed [operations]]   longer runs by hand
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <wb32l003.h>
+#include "kv_store.h"
+#include "host_test.h"
+
+#define KEYS                    20
+#define HOT_KEYS                4       /* most writes, the rest stay live in old pages */
+#define SWEEP_LEN               24
+#define SWEEP_AFTER             4       /* writes after the faulty one, all must land */
+#define OPS                     400     /* half a minute, every erase polls BUSY out on the model */
+
+static uint8_t model[KEYS][KV_VALUE_MAX];
+static uint16_t model_len[KEYS];        /* 0: no value */
+static uint32_t seed = 0x4B5F22;
+
+static uint16_t model_count(void)
+{
+    uint16_t n = 0, k;
+
+    for (k = 0; k < KEYS; k++)
+        n += model_len[k] != 0;
+    return n;
+}
+
+/* Whether a key holds a value, len 0 for none */
+static int key_holds(uint16_t key, const uint8_t* value, uint16_t len)
+{
+    uint8_t buf[KV_VALUE_MAX];
+    int n = kv_get(key, buf, sizeof(buf));
+
+    return len ? n == len && memcmp(buf, value, len) == 0 : n == KV_ERR_NOKEY;
+}
+
+static int store_matches(void)
+{
+    uint8_t buf[KV_VALUE_MAX];
+    uint16_t k;
+
+    for (k = 0; k < KEYS; k++)
+    {
+        int len = kv_get(k, buf, sizeof(buf));
+
+        if (model_len[k] ? len != model_len[k] || memcmp(buf, model[k], len) != 0 : len != KV_ERR_NOKEY)
+        {
+            fprintf(stderr, "key %u: %d bytes, model %u\n", k, len, model_len[k]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void reboot(void)
+{
+    core_emu_reset();
+    CHECK_EQ(kv_init(), 0);
+}
+
+static void blank(void)
+{
+    core_emu_reset();
+    flash_emu_init(NULL);
+    memset(model_len, 0, sizeof(model_len));
+    CHECK_EQ(kv_init(), 0);
+}
+
+static uint32_t flash_ops(void)
+{
+    return flash_emu_stats()->programs + flash_emu_stats()->erases + flash_emu_stats()->dropped;
+}
+
+/*
+ * One set, or a delete with len 0, under a fault: FAULT_NONE, a
+ * transient drop of the after-th flash operation, or a power cut there
+ * followed by a reboot. The model follows and the store is checked.
+ */
+enum { FAULT_NONE, FAULT_TRANSIENT, FAULT_CUT };
+
+static int step(uint16_t key, const uint8_t* value, uint16_t len, int fault, uint32_t after)
+{
+    int rc;
+
+    if (fault != FAULT_NONE)
+        flash_emu_fail(after, fault == FAULT_CUT ? FLASH_EMU_FAIL_ALL : 1);
+
+    if (len == 0)
+    {
+        rc = kv_delete(key);
+        if (rc == 0 || rc == KV_ERR_NOKEY)
+            CHECK_EQ(rc, model_len[key] ? 0 : KV_ERR_NOKEY);
+    }
+    else
+    {
+        rc = kv_set(key, value, len);
+    }
+
+    if (rc == KV_ERR_FLASH)
+        CHECK(fault != FAULT_NONE);
+    else if (rc != 0 && rc != KV_ERR_NOKEY)
+        CHECK_EQ(rc, KV_ERR_FULL);
+    if (rc == 0)
+    {
+        model_len[key] = len;
+        memcpy(model[key], value, len);
+    }
+
+    if (fault == FAULT_CUT)
+    {
+        /* power back: the write in flight may or may not have landed */
+        reboot();
+        if (rc != 0 && key_holds(key, value, len))
+        {
+            model_len[key] = len;
+            memcpy(model[key], value, len);
+        }
+    }
+    else if (fault == FAULT_TRANSIENT)
+    {
+        /* a failed operation left the key as it was */
+        flash_emu_fail(0, 0);
+    }
+
+    CHECK(store_matches());
+    CHECK_EQ(kv_count(), model_count());
+    return rc;
+}
+
+/* The n-th write of the sweep: every key once, then the first one over and over */
+static void sweep_step(uint32_t n, int fault, uint32_t after)
+{
+    uint8_t value[SWEEP_LEN];
+
+    memset(value, (uint8_t)n, sizeof(value));
+    step(n < KEYS ? n : 0, value, sizeof(value), fault, after);
+}
+
+/*
+ * The write that opens a page and collects the oldest one, full of the
+ * records of keys written once, with each of its flash operations
+ * dropped or cut in turn. The store must keep every key and, once the
+ * faults are over, go on writing without a reboot, then mount the same.
+ */
+static void sweep(void)
+{
+    static uint8_t flash[KV_PAGES * FLASH_EMU_PAGE_SIZE];
+    static uint8_t saved[KEYS][KV_VALUE_MAX];
+    static uint16_t saved_len[KEYS];
+    uint32_t n, i, ops, after, erases;
+    int fault;
+
+    /* the store as it is before the collecting write */
+    blank();
+    for (n = 0; ; n++)
+    {
+        memcpy(flash, flash_emu_mem(KV_FLASH_BASE), sizeof(flash));
+        memcpy(saved, model, sizeof(saved));
+        memcpy(saved_len, model_len, sizeof(saved_len));
+        erases = flash_emu_stats()->erases;
+        ops = flash_ops();
+        sweep_step(n, FAULT_NONE, 0);
+        if (flash_emu_stats()->erases != erases)
+            break;
+    }
+    ops = flash_ops() - ops;
+    CHECK(ops > KEYS);
+
+    for (fault = FAULT_TRANSIENT; fault <= FAULT_CUT; fault++)
+    {
+        for (after = 0; after < ops && !host_test_failures; after++)
+        {
+            memcpy(flash_emu_mem(KV_FLASH_BASE), flash, sizeof(flash));
+            memcpy(model, saved, sizeof(saved));
+            memcpy(model_len, saved_len, sizeof(saved_len));
+            reboot();
+            sweep_step(n, fault, after);
+            for (i = n + 1; i <= n + SWEEP_AFTER; i++)
+                sweep_step(i, FAULT_NONE, 0);
+            reboot();
+            CHECK(store_matches());
+        }
+    }
+    printf("kv_store fuzz, sweep: write %u collects with %u flash operations, each dropped and cut\n",
+           (unsigned)n, (unsigned)ops);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t ops = OPS, i, first, page;
+    uint32_t transients = 0, cuts = 0, failed = 0, wear = 0;
+
+    if (argc > 1)
+        seed = strtoul(argv[1], 0, 0);
+    if (argc > 2)
+        ops = strtoul(argv[2], 0, 0);
+    first = seed;
+
+    sweep();
+
+    blank();
+    for (i = 0; i < ops && !host_test_failures; i++)
+    {
+        uint32_t r = host_test_rand(&seed);
+        uint16_t key = (r & 3) ? r % HOT_KEYS : r % KEYS;
+        uint8_t value[KV_VALUE_MAX];
+        uint16_t len = 0, j;
+        uint32_t chance = (r >> 8) % 64;
+        int fault = FAULT_NONE;
+
+        /* one operation in 32 with a transient fault, one in 64 cut short */
+        if (chance < 2)
+        {
+            fault = FAULT_TRANSIENT;
+            transients++;
+        }
+        else if (chance == 2)
+        {
+            fault = FAULT_CUT;
+            cuts++;
+        }
+
+        if ((r >> 16) % 4 != 0)
+        {
+            len = 1 + host_test_rand(&seed) % (KV_VALUE_MAX / 2);
+            for (j = 0; j < len; j++)
+                value[j] = (uint8_t)host_test_rand(&seed);
+        }
+        failed += step(key, value, len, fault, host_test_rand(&seed) % 32) == KV_ERR_FLASH;
+
+        /* a mount after half the transient faults and now and then */
+        if (fault == FAULT_TRANSIENT ? (r >> 24) & 1 : (r >> 24) % 64 == 0)
+        {
+            reboot();
+            CHECK(store_matches());
+        }
+    }
+
+    for (page = 0; page < KV_PAGES; page++)
+    {
+        uint32_t n = flash_emu_erase_count(KV_FLASH_BASE / FLASH_EMU_PAGE_SIZE + page);
+
+        if (n > wear)
+            wear = n;
+    }
+    printf("kv_store fuzz, seed 0x%X: %u operations, %u transient faults, %u power cuts, "
+           "%u failed, %u erases of the busiest page\n",
+           (unsigned)first, (unsigned)i, (unsigned)transients, (unsigned)cuts, (unsigned)failed,
+           (unsigned)wear);
+    return host_test_done("fuzz_kv_store");
+}
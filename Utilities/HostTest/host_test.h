@@ -0,0 +1,69 @@
+#ifndef __HOST_TEST_H
+#define __HOST_TEST_H
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Checks and timing for the host tests, one program per module:
+ *
+ *   CHECK(cond);
+ *   CHECK_EQ(a, b);
+ *   return host_test_done("kv_store");
+ *
+ * A failed check prints its location and the run goes on, the exit code
+ * reports the failures.
+ */
+
+static int host_test_failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        long long a_ = (long long)(a), b_ = (long long)(b); \
+        if (a_ != b_) { \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+                    __FILE__, __LINE__, #a, #b, a_, b_); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+static inline int host_test_done(const char* name)
+{
+    if (host_test_failures)
+    {
+        printf("%s: %d check(s) failed\n", name, host_test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+/* Host monotonic time for the benchmarks */
+static inline uint64_t host_test_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* xorshift32, the traces are reproducible from the seed */
+static inline uint32_t host_test_rand(uint32_t* state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+#endif
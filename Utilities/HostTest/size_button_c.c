@@ -0,0 +1,37 @@
+/* Eight buttons on the C engine, for the size report of the Makefile */
+
+#include "wb32l003.h"
+#include "multi_button.h"
+
+static struct Button btn[8];
+static const uint8_t active[8] = { 0, 1, 0, 1, 0, 1, 0, 1 };
+static const uint16_t stages[] = { 40, 120, 250 };
+volatile uint32_t size_events;
+
+static uint8_t level(uint16_t id)
+{
+    GPIO_TypeDef* port = (id < 4) ? GPIOC : GPIOD;
+
+    return (port->IDR >> (id & 3)) & 1;
+}
+
+void size_init(void)
+{
+    uint16_t i;
+
+    for (i = 0; i < 8; i++)
+    {
+        button_init(&btn[i], level, active[i], i);
+        button_start(&btn[i]);
+    }
+    button_set_long_stages(&btn[0], stages, 3);
+    button_set_long_stages(&btn[4], stages, 3);
+}
+
+void size_tick(void)
+{
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+
+    button_ticks();
+    size_events += button_poll_events(ev, EVENT_QUEUE_SIZE, NULL);
+}
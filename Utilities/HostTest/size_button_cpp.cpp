@@ -0,0 +1,28 @@
+/* Eight buttons on the C++ front end, for the size report of the Makefile */
+
+#include "multi_button.hpp"
+
+namespace mb = multibutton;
+
+using Stages = mb::LongStages<40, 120, 250>;
+
+static mb::ButtonSet<
+    mb::Button<GPIOC_BASE, GPIO_Pin_0, 0, mb::Timing<>, Stages>,
+    mb::Button<GPIOC_BASE, GPIO_Pin_1, 1>,
+    mb::Button<GPIOC_BASE, GPIO_Pin_2, 0>,
+    mb::Button<GPIOC_BASE, GPIO_Pin_3, 1>,
+    mb::Button<GPIOD_BASE, GPIO_Pin_0, 0, mb::Timing<>, Stages>,
+    mb::Button<GPIOD_BASE, GPIO_Pin_1, 1>,
+    mb::Button<GPIOD_BASE, GPIO_Pin_2, 0>,
+    mb::Button<GPIOD_BASE, GPIO_Pin_3, 1> > buttons;
+volatile uint32_t size_events;
+
+struct Counter {
+    template<typename Btn>
+    void operator()(const Btn&, PressEvent) { size_events = size_events + 1; }
+};
+
+extern "C" void size_tick(void)
+{
+    buttons.ticks(Counter{});
+}
@@ -0,0 +1,240 @@
+/*
+ * binlog on the LPUART model: records leave as whole little endian words
+ * with the header layout of binlog.h, a full ring drops records and the
+ * next drain reports them with the marker, and a drain never splits a
+ * record when the TX ring is short.
+ *
+ * Then Utilities/HostTools/binlog_decode, built next to this program,
+ * on a stream of records pointing into an ELF32 image written here: it
+ * must print the text, and refuse images whose .binlog_fmt section
+ * starts at offset 0 of a 64 KB window or crosses into the next one.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <wb32l003.h>
+#include "binlog.h"
+#include "bsp_lpuart1.h"
+#include "host_test.h"
+
+#define WIRE_MAX                4096
+
+static uint8_t wire[WIRE_MAX];
+static uint32_t wire_len;
+static char dir[256];
+
+static uint32_t word_at(uint32_t offset)
+{
+    return wire[offset] | (wire[offset + 1] << 8) | (wire[offset + 2] << 16) | ((uint32_t)wire[offset + 3] << 24);
+}
+
+/* Drain until the line goes quiet, everything sent lands in wire */
+static void capture(void)
+{
+    uint32_t n;
+
+    wire_len = 0;
+    do
+    {
+        binlog_drain();
+        print_flush();
+        core_emu_run(uart_emu_byte_cycles(LPUART_BASE));
+        n = uart_emu_tx(LPUART_BASE, wire + wire_len, WIRE_MAX - wire_len);
+        wire_len += n;
+    } while (n);
+}
+
+/* Records in wire, each header checked for sync and a sane count */
+static uint32_t records(void)
+{
+    uint32_t offset = 0, n = 0;
+
+    while (offset + 4 <= wire_len)
+    {
+        uint32_t header = word_at(offset);
+
+        CHECK_EQ(header >> 24, BINLOG_SYNC);
+        CHECK(((header >> 16) & 0xFF) <= 4);
+        offset += 4 + 4 * ((header >> 16) & 0xFF);
+        n++;
+    }
+    CHECK_EQ(offset, wire_len);
+    return n;
+}
+
+/*
+ * A little endian ELF32 image with only a .binlog_fmt section at addr,
+ * holding the strings back to back, and the section name table.
+ */
+static void write_elf(const char* path, uint32_t addr, const char* const* fmts, uint32_t count)
+{
+    static const char names[] = "\0.binlog_fmt\0.shstrtab";
+    uint8_t image[1024] = { 0 };
+    uint32_t data = 52, size = 0, shoff, i;
+    FILE* f;
+
+    for (i = 0; i < count; i++)
+    {
+        strcpy((char*)image + data + size, fmts[i]);
+        size += strlen(fmts[i]) + 1;
+    }
+    memcpy(image + data + size, names, sizeof(names));
+    shoff = (data + size + sizeof(names) + 3) & ~3U;
+
+    memcpy(image, "\177ELF\1\1\1", 7);
+    image[16] = 2;                                      /* ET_EXEC */
+    image[18] = 40;                                     /* EM_ARM */
+    image[20] = 1;
+    memcpy(image + 32, &shoff, 4);
+    image[40] = 52;                                     /* e_ehsize */
+    image[46] = 40;                                     /* e_shentsize */
+    image[48] = 3;                                      /* e_shnum */
+    image[50] = 2;                                      /* e_shstrndx */
+
+    /* [1] .binlog_fmt, [2] .shstrtab, [0] stays null */
+    {
+        uint8_t* sh = image + shoff + 40;
+        uint32_t name = 1, type = 1, flags = 2;
+
+        memcpy(sh, &name, 4);
+        memcpy(sh + 4, &type, 4);
+        memcpy(sh + 8, &flags, 4);
+        memcpy(sh + 12, &addr, 4);
+        memcpy(sh + 16, &data, 4);
+        memcpy(sh + 20, &size, 4);
+        sh += 40;
+        name = 13;
+        type = 3;
+        data += size;
+        size = sizeof(names);
+        memcpy(sh, &name, 4);
+        memcpy(sh + 4, &type, 4);
+        memcpy(sh + 16, &data, 4);
+        memcpy(sh + 20, &size, 4);
+    }
+
+    f = fopen(path, "wb");
+    CHECK(f != NULL);
+    fwrite(image, 1, shoff + 3 * 40, f);
+    fclose(f);
+}
+
+/* Run the decoder on the image and the captured wire, its exit status */
+static int decode(const char* elf, char* out, size_t max)
+{
+    char cmd[1024], stream[300], text[300];
+    size_t n = 0;
+    FILE* f;
+
+    snprintf(stream, sizeof(stream), "%s/binlog_test.bin", dir);
+    snprintf(text, sizeof(text), "%s/binlog_test.txt", dir);
+    f = fopen(stream, "wb");
+    fwrite(wire, 1, wire_len, f);
+    fclose(f);
+
+    snprintf(cmd, sizeof(cmd), "%s/binlog_decode %s %s > %s 2>/dev/null", dir, elf, stream, text);
+    if (system(cmd) != 0)
+        return 1;
+    f = fopen(text, "rb");
+    if (f)
+    {
+        n = fread(out, 1, max - 1, f);
+        fclose(f);
+    }
+    out[n] = '\0';
+    return 0;
+}
+
+static void test_decoder(void)
+{
+    static const char* const fmts[] = { "boot\n", "btn %u event %u\n", "t %d %x %c\n" };
+    char elf[300], text[512];
+    uint32_t base = 0x1200, hdr = (uint32_t)BINLOG_SYNC << 24;
+
+    snprintf(elf, sizeof(elf), "%s/binlog_test.axf", dir);
+
+    /* the sites as the target would log them, from the section at base */
+    binlog_write(hdr | (0 << 16) | base, 0, 0, 0, 0);
+    binlog_write(hdr | (2 << 16) | (base + 6), 3, 6, 0, 0);
+    binlog_write(hdr | (3 << 16) | (base + 23), (uint32_t)-5, 0xBEEF, 'A', 0);
+    capture();
+
+    write_elf(elf, base, fmts, 3);
+    CHECK_EQ(decode(elf, text, sizeof(text)), 0);
+    CHECK(strcmp(text, "boot\nbtn 3 event 6\nt -5 beef A\n") == 0);
+
+    /* one window up: the same 16 bit offsets, still fine */
+    write_elf(elf, 0x10000 + base, fmts, 3);
+    CHECK_EQ(decode(elf, text, sizeof(text)), 0);
+    CHECK(strcmp(text, "boot\nbtn 3 event 6\nt -5 beef A\n") == 0);
+
+    /* a string at offset 0 would decode as the dropped marker */
+    write_elf(elf, 0x10000, fmts, 3);
+    CHECK(decode(elf, text, sizeof(text)) != 0);
+
+    /* a section crossing into the next window wraps its offsets */
+    write_elf(elf, 0xFFF0, fmts, 3);
+    CHECK(decode(elf, text, sizeof(text)) != 0);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t i, n, free_room;
+    char* slash;
+
+    snprintf(dir, sizeof(dir), "%s", argv[0]);
+    slash = strrchr(dir, '/');
+    if (slash)
+        *slash = '\0';
+    else
+        strcpy(dir, ".");
+
+    core_emu_reset();
+    SystemInit();
+    print_init(115200);
+
+    /* records go out whole, header then arguments */
+    BLOG0("boot\n");
+    BLOG2("btn %u event %u\n", 3, 6);
+    BLOG4("%u %u %u %u\n", 1, 2, 3, 0xA5A5A5A5);
+    capture();
+    CHECK_EQ(records(), 3);
+    CHECK_EQ(wire_len, 4 * (1 + 3 + 5));
+    CHECK_EQ((word_at(0) >> 16) & 0xFF, 0);
+    CHECK_EQ((word_at(4) >> 16) & 0xFF, 2);
+    CHECK_EQ(word_at(8), 3);
+    CHECK_EQ(word_at(12), 6);
+    CHECK_EQ(word_at(32), 0xA5A5A5A5);
+    CHECK(((word_at(0) ^ word_at(4)) & 0xFFFF) != 0);
+
+    /* a full ring drops, the marker reports the count first */
+    for (i = 0; i < BINLOG_RING_WORDS; i++)
+        BLOG1("n %u\n", i);
+    n = binlog_dropped();
+    CHECK(n > 0);
+    capture();
+    CHECK_EQ(records(), 1 + BINLOG_RING_WORDS - n);
+    CHECK_EQ(word_at(0), ((uint32_t)BINLOG_SYNC << 24) | (1UL << 16) | BINLOG_DROPPED);
+    CHECK_EQ(word_at(4), n);
+    CHECK_EQ(word_at(12), 0);
+    CHECK_EQ(word_at(20), 1);
+
+    /* a short TX ring takes whole records only */
+    NVIC_DisableIRQ(LPUART_IRQn);
+    while (print_free() >= 4 * 5)
+        print_putc('.');
+    free_room = print_free();
+    BLOG4("%u %u %u %u\n", 1, 2, 3, 4);
+    binlog_drain();
+    CHECK_EQ(print_free(), free_room);
+    NVIC_EnableIRQ(LPUART_IRQn);
+    print_flush();
+    core_emu_run(uart_emu_byte_cycles(LPUART_BASE));
+    uart_emu_tx(LPUART_BASE, wire, WIRE_MAX);
+    capture();
+    CHECK_EQ(records(), 1);
+    CHECK_EQ(wire_len, 4 * 5);
+
+    test_decoder();
+    return host_test_done("binlog");
+}
@@ -0,0 +1,245 @@
+/*
+ * button_await coroutines on the scheduler and soft timers, the engine
+ * ticked by hand: an event before the timeout resumes with the event and
+ * stops the timer, a timeout resumes with NONE_PRESS and drops the
+ * waiter, and two coroutines awaiting the same button both resume on one
+ * event while the timeout of one leaves the other waiting.
+ *
+ * Then cancel racing delivery on the interrupt models: the timeout runs
+ * from TIM10_IRQHandler and the event comes from GPIOA_IRQHandler at a
+ * higher priority, pended at every cycle across the timeout handler.
+ * The coroutine resumes exactly once, with the event when it won and
+ * NONE_PRESS otherwise, and leaves no waiter or armed timer behind.
+ */
+
+#include <wb32l003.h>
+#include "button_await.h"
+#include "host_test.h"
+
+#define RACE_SPAN               160     /* cycles swept across the timeout handler */
+#define RACE_TIMEOUT            4
+
+typedef struct {
+    BtnCoroutine co;            /* first member, the task arg casts back */
+    uint16_t mask;
+    uint32_t timeout;
+    uint32_t resumes;
+    uint8_t last;               /* event resumed with */
+    uint32_t at;                /* soft_timer_now() at the resume */
+} Awaiter;
+
+static struct Button btn;
+static uint8_t level = 1;
+static Awaiter a, b;
+static uint32_t press_ticks;    /* button_ticks() from the press to PRESS_DOWN */
+
+static uint8_t read_level(uint16_t id)
+{
+    (void)id;
+    return level;
+}
+
+/* One await, then done: the next round starts it again */
+static void await_task(void* arg)
+{
+    Awaiter* w = arg;
+
+    BTN_CO_BEGIN(&w->co);
+    BTN_AWAIT(&w->co, &btn, w->mask, w->timeout);
+    w->resumes++;
+    w->last = w->co.ev.event;
+    w->at = soft_timer_now();
+    BTN_CO_END(&w->co);
+}
+
+static void run_tasks(void)
+{
+    while (sched_run_once())
+        ;
+}
+
+static void await(Awaiter* w, uint16_t mask, uint32_t timeout)
+{
+    w->mask = mask;
+    w->timeout = timeout;
+    button_co_start(&w->co);
+    run_tasks();
+}
+
+static void tick(void)
+{
+    button_ticks();
+    soft_timer_ticks();
+    run_tasks();
+}
+
+/* Released and back to idle, nothing left waiting */
+static void settle(void)
+{
+    uint32_t t;
+
+    level = 1;
+    for (t = 0; t < 2 * SHORT_TICKS; t++)
+        tick();
+    CHECK(btn.waiters == NULL);
+}
+
+static void test_event_first(void)
+{
+    uint32_t t0, t;
+
+    a.resumes = 0;
+    await(&a, BTN_EVENT_MASK(PRESS_DOWN), 50);
+    t0 = soft_timer_now();
+    for (t = 0; t < 10; t++)
+        tick();
+    level = 0;
+    for (t = 0; t < 20 && a.resumes == 0; t++)
+        tick();
+    press_ticks = t;
+    CHECK_EQ(a.resumes, 1);
+    CHECK_EQ(a.last, PRESS_DOWN);
+    CHECK(a.at < t0 + 50);
+    CHECK_EQ(a.co.timer.heap_index, SOFT_TIMER_IDLE);
+    CHECK(btn.waiters == NULL);
+
+    /* the stopped timer never comes back */
+    for (t = 0; t < 60; t++)
+        tick();
+    CHECK_EQ(a.resumes, 1);
+    settle();
+}
+
+static void test_timeout(void)
+{
+    uint32_t t0, t;
+
+    a.resumes = 0;
+    await(&a, BTN_EVENT_MASK(PRESS_DOWN), 20);
+    t0 = soft_timer_now();
+    for (t = 0; t < 19; t++)
+        tick();
+    CHECK_EQ(a.resumes, 0);
+    tick();
+    CHECK_EQ(a.resumes, 1);
+    CHECK_EQ(a.last, NONE_PRESS);
+    CHECK_EQ(a.at, t0 + 20);
+    CHECK(btn.waiters == NULL);
+
+    /* the dropped waiter misses the press */
+    level = 0;
+    for (t = 0; t < 20; t++)
+        tick();
+    CHECK_EQ(a.resumes, 1);
+    settle();
+}
+
+static void test_two_awaiters(void)
+{
+    uint32_t t;
+
+    a.resumes = 0;
+    b.resumes = 0;
+    await(&a, BTN_EVENT_MASK(PRESS_DOWN), 0);
+    await(&b, BTN_EVENT_MASK(PRESS_DOWN) | BTN_EVENT_MASK(PRESS_UP), 30);
+    level = 0;
+    for (t = 0; t < 20; t++)
+        tick();
+    CHECK_EQ(a.resumes, 1);
+    CHECK_EQ(b.resumes, 1);
+    CHECK_EQ(a.last, PRESS_DOWN);
+    CHECK_EQ(b.last, PRESS_DOWN);
+    CHECK_EQ(b.co.timer.heap_index, SOFT_TIMER_IDLE);
+
+    /* both wait for the release, a times out first, b keeps waiting */
+    await(&b, BTN_EVENT_MASK(PRESS_UP), 0);
+    await(&a, BTN_EVENT_MASK(PRESS_UP), 5);
+    for (t = 0; t < 10; t++)
+        tick();
+    CHECK_EQ(a.resumes, 2);
+    CHECK_EQ(a.last, NONE_PRESS);
+    CHECK_EQ(b.resumes, 1);
+    CHECK(btn.waiters == &b.co.waiter && b.co.waiter.next == NULL);
+    level = 1;
+    for (t = 0; t < 10; t++)
+        tick();
+    CHECK_EQ(b.resumes, 2);
+    CHECK_EQ(b.last, PRESS_UP);
+    CHECK_EQ(a.resumes, 2);
+    settle();
+}
+
+void GPIOA_IRQHandler(void)
+{
+    button_ticks();
+}
+
+void TIM10_IRQHandler(void)
+{
+    soft_timer_ticks();
+}
+
+static void pend(void* arg)
+{
+    NVIC_SetPendingIRQ((IRQn_Type)(intptr_t)arg);
+}
+
+static void test_race(void)
+{
+    uint32_t d, t, won = 0, lost = 0;
+
+    core_emu_reset();
+    NVIC_SetPriority(GPIOA_IRQn, 0);
+    NVIC_SetPriority(TIM10_IRQn, 1);
+    NVIC_EnableIRQ(GPIOA_IRQn);
+    NVIC_EnableIRQ(TIM10_IRQn);
+
+    for (d = 0; d < RACE_SPAN && !host_test_failures; d++)
+    {
+        uint64_t at;
+
+        /* the press and the timeout both one tick away */
+        a.resumes = 0;
+        await(&a, BTN_EVENT_MASK(PRESS_DOWN), RACE_TIMEOUT);
+        for (t = 0; t < RACE_TIMEOUT - 1; t++)
+            soft_timer_ticks();
+        level = 0;
+        for (t = 0; t < press_ticks - 1; t++)
+            button_ticks();
+        run_tasks();
+        CHECK_EQ(a.resumes, 0);
+
+        at = core_emu_cycles() + 10;
+        core_emu_at(at + RACE_SPAN / 4, pend, (void*)(intptr_t)TIM10_IRQn);
+        core_emu_at(at + d, pend, (void*)(intptr_t)GPIOA_IRQn);
+        core_emu_run(2 * RACE_SPAN);
+        run_tasks();
+
+        CHECK_EQ(a.resumes, 1);
+        CHECK(a.last == PRESS_DOWN || a.last == NONE_PRESS);
+        CHECK(btn.waiters == NULL);
+        CHECK_EQ(a.co.timer.heap_index, SOFT_TIMER_IDLE);
+        if (a.last == PRESS_DOWN)
+            won++;
+        else
+            lost++;
+        settle();
+    }
+    printf("  race: event first %u times, timeout first %u times\n", (unsigned)won, (unsigned)lost);
+    CHECK(won > 0 && lost > 0);
+}
+
+int main(void)
+{
+    button_init(&btn, read_level, 0, 1);
+    CHECK_EQ(button_start(&btn), 0);
+    button_co_init(&a.co, await_task, 0);
+    button_co_init(&b.co, await_task, 1);
+    settle();
+
+    test_event_first();
+    test_timeout();
+    test_two_awaiters();
+    test_race();
+    return host_test_done("button_await");
+}
@@ -0,0 +1,310 @@
+/*
+ * The C++ front end against the C engine: eight buttons on emulated
+ * GPIOC/GPIOD pins, both engines sample the same pins every tick and
+ * must report the same events with the same repeat count and long press
+ * stage, in the same order per button.
+ */
+
+#include <vector>
+#include "wb32l003.h"
+#include "multi_button.hpp"
+#include "host_test.h"
+
+#define BUTTONS                 8
+#define RANDOM_TICKS            400000
+
+using multibutton::Timing;
+using multibutton::LongStages;
+using multibutton::ButtonSet;
+
+typedef struct {
+    uint8_t event;
+    uint8_t repeat;
+    uint8_t stage;
+} Rec;
+
+static const uint16_t stages0[] = { 40, 120, 250 };
+static const uint16_t stages1[] = { 100 };
+static const uint16_t stages4[] = { 1, 2, 3, 4 };
+
+using Btn0 = multibutton::Button<GPIOC_BASE, GPIO_Pin_0, 0, Timing<>, LongStages<40, 120, 250> >;
+using Btn1 = multibutton::Button<GPIOC_BASE, GPIO_Pin_1, 1, Timing<>, LongStages<100> >;
+using Btn2 = multibutton::Button<GPIOC_BASE, GPIO_Pin_2, 0>;
+using Btn3 = multibutton::Button<GPIOC_BASE, GPIO_Pin_3, 1>;
+using Btn4 = multibutton::Button<GPIOD_BASE, GPIO_Pin_0, 0, Timing<>, LongStages<1, 2, 3, 4> >;
+using Btn5 = multibutton::Button<GPIOD_BASE, GPIO_Pin_1, 1>;
+using Btn6 = multibutton::Button<GPIOD_BASE, GPIO_Pin_2, 0>;
+using Btn7 = multibutton::Button<GPIOD_BASE, GPIO_Pin_3, 1>;
+
+static const uint8_t active[BUTTONS] = { 0, 1, 0, 1, 0, 1, 0, 1 };
+
+static ButtonSet<Btn0, Btn1, Btn2, Btn3, Btn4, Btn5, Btn6, Btn7>* cpp_set;
+static struct Button c_btn[BUTTONS];
+static std::vector<Rec> cpp_rec[BUTTONS];
+static std::vector<Rec> c_rec[BUTTONS];
+static uint32_t c_count[number_of_event];
+
+static uint32_t port_of(int i)
+{
+    return i < 4 ? GPIOC_BASE : GPIOD_BASE;
+}
+
+static uint16_t pin_of(int i)
+{
+    return (uint16_t)(1U << (i & 3));
+}
+
+static uint8_t c_level(uint16_t id)
+{
+    GPIO_TypeDef* port = (id < 4) ? GPIOC : GPIOD;
+
+    return (port->IDR & pin_of(id)) ? 1 : 0;
+}
+
+struct Recorder {
+    template<typename Btn>
+    void operator()(const Btn& btn, PressEvent ev)
+    {
+        int i = (Btn::port_base == GPIOD_BASE ? 4 : 0) + __builtin_ctz(Btn::pin);
+        Rec r = { (uint8_t)ev, btn.repeat(), btn.long_stage() };
+
+        cpp_rec[i].push_back(r);
+    }
+};
+
+/* Last event of a C++ button, what event() reports between ticks */
+static PressEvent cpp_event(int i)
+{
+    switch (i)
+    {
+    case 0:  return cpp_set->get<0>().event();
+    case 1:  return cpp_set->get<1>().event();
+    case 2:  return cpp_set->get<2>().event();
+    case 3:  return cpp_set->get<3>().event();
+    case 4:  return cpp_set->get<4>().event();
+    case 5:  return cpp_set->get<5>().event();
+    case 6:  return cpp_set->get<6>().event();
+    default: return cpp_set->get<7>().event();
+    }
+}
+
+static void press(int i, int pressed)
+{
+    gpio_emu_drive(port_of(i), pin_of(i), pressed ? active[i] : !active[i]);
+}
+
+static void engines_init(void)
+{
+    static ButtonSet<Btn0, Btn1, Btn2, Btn3, Btn4, Btn5, Btn6, Btn7> set;
+    int i;
+
+    core_emu_reset();
+    set = {};
+    cpp_set = &set;
+    for (i = 0; i < BUTTONS; i++)
+    {
+        press(i, 0);
+        button_stop(&c_btn[i]);
+        button_init(&c_btn[i], c_level, active[i], (uint16_t)i);
+        CHECK_EQ(button_start(&c_btn[i]), 0);
+        cpp_rec[i].clear();
+        c_rec[i].clear();
+    }
+    button_set_long_stages(&c_btn[0], stages0, 3);
+    button_set_long_stages(&c_btn[1], stages1, 1);
+    button_set_long_stages(&c_btn[4], stages4, 4);
+}
+
+/* One tick of both engines, returns 0 on the first difference */
+static int tick_compare(uint32_t tick)
+{
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    uint16_t n, k;
+    int i;
+
+    button_ticks();
+    cpp_set->ticks(Recorder{});
+
+    n = button_poll_events(ev, EVENT_QUEUE_SIZE, NULL);
+    for (k = 0; k < n; k++)
+    {
+        Rec r = { ev[k].event, ev[k].repeat, ev[k].stage };
+        c_rec[ev[k].button_id].push_back(r);
+        c_count[ev[k].event]++;
+    }
+
+    for (i = 0; i < BUTTONS; i++)
+    {
+        size_t e;
+        int same = cpp_rec[i].size() == c_rec[i].size() &&
+                   cpp_event(i) == get_button_event(&c_btn[i]);
+
+        for (e = 0; same && e < c_rec[i].size(); e++)
+        {
+            same = cpp_rec[i][e].event == c_rec[i][e].event &&
+                   cpp_rec[i][e].repeat == c_rec[i][e].repeat &&
+                   cpp_rec[i][e].stage == c_rec[i][e].stage;
+        }
+        if (!same)
+        {
+            fprintf(stderr, "tick %u button %d, event C %d C++ %d:\n  C:  ", (unsigned)tick, i,
+                    get_button_event(&c_btn[i]), cpp_event(i));
+            for (e = 0; e < c_rec[i].size(); e++)
+                fprintf(stderr, " %u/%u/%u", c_rec[i][e].event, c_rec[i][e].repeat, c_rec[i][e].stage);
+            fprintf(stderr, "\n  C++:");
+            for (e = 0; e < cpp_rec[i].size(); e++)
+                fprintf(stderr, " %u/%u/%u", cpp_rec[i][e].event, cpp_rec[i][e].repeat, cpp_rec[i][e].stage);
+            fprintf(stderr, "\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Run both engines, keep the records of the last run for the scripted checks */
+static int run(uint32_t ticks)
+{
+    uint32_t t;
+    int i;
+
+    for (t = 0; t < ticks; t++)
+    {
+        for (i = 0; i < BUTTONS; i++)
+        {
+            cpp_rec[i].clear();
+            c_rec[i].clear();
+        }
+        if (!tick_compare(t))
+            return 0;
+    }
+    return 1;
+}
+
+/* Events of a button over a scripted run, holds left out */
+static std::vector<Rec> script(int i, const uint16_t* phases, int n)
+{
+    std::vector<Rec> out;
+    int p;
+
+    engines_init();
+    for (p = 0; p < n; p++)
+    {
+        uint32_t t;
+
+        press(i, !(p & 1));
+        for (t = 0; t < phases[p]; t++)
+        {
+            cpp_rec[i].clear();
+            c_rec[i].clear();
+            CHECK(tick_compare(t));
+            for (const Rec& r : cpp_rec[i])
+            {
+                if (r.event != LONG_PRESS_HOLD)
+                    out.push_back(r);
+            }
+        }
+    }
+    return out;
+}
+
+static void expect(const std::vector<Rec>& got, const Rec* want, size_t n)
+{
+    size_t e;
+
+    CHECK_EQ(got.size(), n);
+    for (e = 0; e < n && e < got.size(); e++)
+    {
+        CHECK_EQ(got[e].event, want[e].event);
+        CHECK_EQ(got[e].repeat, want[e].repeat);
+        CHECK_EQ(got[e].stage, want[e].stage);
+    }
+}
+
+static void test_long_press_stages(void)
+{
+    /* stage 3 at 250 ticks comes after LONG_PRESS_START at LONG_TICKS */
+    static const uint16_t phases[] = { 300, 100 };
+    static const Rec want[] = {
+        { PRESS_DOWN, 1, 0 }, { LONG_PRESS_STAGE, 1, 1 }, { LONG_PRESS_STAGE, 1, 2 },
+        { LONG_PRESS_START, 1, 2 }, { LONG_PRESS_STAGE, 1, 3 }, { PRESS_UP, 1, 3 },
+    };
+
+    expect(script(0, phases, 2), want, sizeof(want) / sizeof(want[0]));
+}
+
+static void test_multi_click(void)
+{
+    /* repeat counts the press before PRESS_DOWN, 3 presses: no click event */
+    static const uint16_t phases[] = { 10, 10, 10, 10, 10, 100 };
+    static const Rec want[] = {
+        { PRESS_DOWN, 1, 0 }, { PRESS_UP, 1, 0 },
+        { PRESS_DOWN, 2, 0 }, { PRESS_REPEAT, 2, 0 }, { PRESS_UP, 2, 0 },
+        { PRESS_DOWN, 3, 0 }, { PRESS_REPEAT, 3, 0 }, { PRESS_UP, 3, 0 },
+    };
+
+    expect(script(2, phases, 6), want, sizeof(want) / sizeof(want[0]));
+}
+
+static void test_double_click(void)
+{
+    static const uint16_t phases[] = { 10, 10, 10, 100 };
+    static const Rec want[] = {
+        { PRESS_DOWN, 1, 0 }, { PRESS_UP, 1, 0 },
+        { PRESS_DOWN, 2, 0 }, { PRESS_REPEAT, 2, 0 }, { PRESS_UP, 2, 0 },
+        { DOUBLE_CLICK, 2, 0 },
+    };
+
+    expect(script(5, phases, 4), want, sizeof(want) / sizeof(want[0]));
+}
+
+static void test_random_traces(void)
+{
+    uint32_t seed = 0x2545F491;
+    uint32_t next[BUTTONS] = { 0 };
+    uint8_t down[BUTTONS] = { 0 };
+    uint32_t t;
+    int i, e;
+
+    engines_init();
+    for (t = 0; t < RANDOM_TICKS; t++)
+    {
+        for (i = 0; i < BUTTONS; i++)
+        {
+            uint32_t r = host_test_rand(&seed);
+
+            if (t < next[i])
+                continue;
+            down[i] = !down[i];
+            press(i, down[i]);
+            /* bounces, clicks, presses around SHORT_TICKS and long holds */
+            switch (r % 8)
+            {
+            case 0:  next[i] = t + 1 + (r >> 8) % DEBOUNCE_TICKS; break;
+            case 1:
+            case 2:
+            case 3:  next[i] = t + 4 + (r >> 8) % (SHORT_TICKS + 20); break;
+            case 4:
+            case 5:  next[i] = t + SHORT_TICKS - 10 + (r >> 8) % (LONG_TICKS - SHORT_TICKS + 60); break;
+            default: next[i] = t + LONG_TICKS + (r >> 8) % 400; break;
+            }
+        }
+        if (!run(1))
+        {
+            CHECK(!"engines differ");
+            break;
+        }
+    }
+
+    CHECK_EQ(button_events_dropped(), 0);
+    for (e = 0; e < number_of_event; e++)
+        CHECK(c_count[e] > 0);
+}
+
+int main(void)
+{
+    test_long_press_stages();
+    test_multi_click();
+    test_double_click();
+    test_random_traces();
+    return host_test_done("button_cpp");
+}
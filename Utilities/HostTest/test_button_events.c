@@ -0,0 +1,133 @@
+/*
+ * The event queue of the C engine: held buttons take one slot each,
+ * records stay in order, changed_mask folds the high ids into bit 31.
+ */
+
+#include "multi_button.h"
+#include "host_test.h"
+
+#define HELD                    5
+
+static struct Button btn[HELD + 1];
+static uint8_t level[64];
+
+static uint8_t read_level(uint16_t id)
+{
+    return level[id];
+}
+
+static void engine_init(void)
+{
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    int i;
+
+    for (i = 0; i <= HELD; i++)
+        button_stop(&btn[i]);
+    while (button_poll_events(ev, EVENT_QUEUE_SIZE, NULL))
+        ;
+    for (i = 0; i < 64; i++)
+        level[i] = 1;
+}
+
+static void test_held_buttons(void)
+{
+    static const uint16_t stages[] = { 250 };
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    uint32_t last_time = 0;
+    uint32_t dropped = button_events_dropped();
+    uint32_t stage_seen = 0;
+    int i, t;
+
+    engine_init();
+    for (i = 0; i < HELD; i++)
+    {
+        button_init(&btn[i], read_level, 0, (uint16_t)i);
+        button_set_long_stages(&btn[i], stages, 1);
+        CHECK_EQ(button_start(&btn[i]), 0);
+        level[i] = 0;
+    }
+
+    /* a slow consumer: the holds would fill the queue within one poll */
+    for (t = 1; t <= 1000; t++)
+    {
+        uint32_t hold_time[HELD] = { 0 };
+        uint16_t n, k;
+
+        button_ticks();
+        if (t % 50)
+            continue;
+        n = button_poll_events(ev, EVENT_QUEUE_SIZE, NULL);
+        for (k = 0; k < n; k++)
+        {
+            CHECK(ev[k].timestamp >= last_time);
+            last_time = ev[k].timestamp;
+            if (ev[k].event == LONG_PRESS_HOLD)
+                hold_time[ev[k].button_id] = ev[k].timestamp;
+            if (ev[k].event == LONG_PRESS_STAGE)
+                stage_seen++;
+        }
+        /* refreshed in place: the last hold is the one of this tick */
+        if (t > LONG_TICKS + DEBOUNCE_TICKS)
+        {
+            for (i = 0; i < HELD; i++)
+                CHECK_EQ(hold_time[i], button_get_clock());
+        }
+    }
+    CHECK_EQ(stage_seen, HELD);
+    CHECK_EQ(button_events_dropped(), dropped);
+}
+
+static void test_hold_after_stage(void)
+{
+    /* a stage fires between two holds, the second is queued after it */
+    static const uint16_t stages[] = { LONG_TICKS + 5 };
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    uint16_t n, k;
+    int t;
+
+    engine_init();
+    button_init(&btn[0], read_level, 0, 0);
+    button_set_long_stages(&btn[0], stages, 1);
+    button_start(&btn[0]);
+    level[0] = 0;
+    for (t = 0; t < DEBOUNCE_TICKS + LONG_TICKS + 10; t++)
+        button_ticks();
+
+    n = button_poll_events(ev, EVENT_QUEUE_SIZE, NULL);
+    CHECK_EQ(n, 5);
+    CHECK_EQ(ev[0].event, PRESS_DOWN);
+    CHECK_EQ(ev[1].event, LONG_PRESS_START);
+    CHECK_EQ(ev[2].event, LONG_PRESS_HOLD);
+    CHECK_EQ(ev[3].event, LONG_PRESS_STAGE);
+    CHECK_EQ(ev[4].event, LONG_PRESS_HOLD);
+    for (k = 1; k < n; k++)
+        CHECK(ev[k].timestamp >= ev[k - 1].timestamp);
+}
+
+static void test_changed_mask(void)
+{
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    uint32_t mask = 0;
+    int t;
+
+    engine_init();
+    button_init(&btn[0], read_level, 0, 3);
+    button_init(&btn[1], read_level, 0, 40);
+    button_start(&btn[0]);
+    button_start(&btn[1]);
+    level[3] = 0;
+    level[40] = 0;
+    for (t = 0; t < DEBOUNCE_TICKS; t++)
+        button_ticks();
+
+    CHECK_EQ(button_poll_events(ev, EVENT_QUEUE_SIZE, &mask), 2);
+    CHECK_EQ(mask, (1UL << 3) | (1UL << 31));
+}
+
+int main(void)
+{
+    test_held_buttons();
+    test_hold_after_stage();
+    test_changed_mask();
+    return host_test_done("button_events");
+}
@@ -0,0 +1,81 @@
+/*
+ * Button ids over the whole 16 bit range: start, find, duplicate ids
+ * and stop in any order. button_init() refuses a started handle, takes
+ * a stopped one and a fresh one whatever its memory held.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "multi_button.h"
+#include "host_test.h"
+
+#define STARTED                 3000
+
+static struct Button btn[STARTED];
+static uint16_t id[STARTED];
+
+static uint8_t read_level(uint16_t button_id)
+{
+    (void)button_id;
+    return 1;
+}
+
+int main(void)
+{
+    static uint8_t used[65536];
+    struct Button dup;
+    uint32_t seed = 0x1234567;
+    int i;
+
+    /* both ends of the range and random sparse ids */
+    for (i = 0; i < STARTED; i++)
+    {
+        uint16_t v = i == 0 ? 0 : i == 1 ? 65535 : (uint16_t)host_test_rand(&seed);
+
+        while (used[v])
+            v++;
+        used[v] = 1;
+        id[i] = v;
+        button_init(&btn[i], read_level, 0, v);
+        CHECK_EQ(button_start(&btn[i]), 0);
+    }
+    CHECK_EQ(button_start(&btn[7]), -1);
+    memset(&dup, 0xA5, sizeof(dup));
+    CHECK_EQ(button_init(&dup, read_level, 0, id[42]), 0);
+    CHECK_EQ(button_start(&dup), -2);
+
+    /* a started handle stays linked and keeps its settings */
+    CHECK_EQ(button_init(&btn[7], read_level, 1, id[8]), -1);
+    CHECK(button_find(id[7]) == &btn[7]);
+    CHECK_EQ(btn[7].active_level, 0);
+
+    for (i = 0; i < STARTED; i++)
+        CHECK(button_find(id[i]) == &btn[i]);
+    for (i = 0; i < 65536; i++)
+    {
+        if (!used[i])
+            CHECK(button_find((uint16_t)i) == NULL);
+    }
+
+    /* stop every other one, middle of chains included */
+    for (i = 0; i < STARTED; i += 2)
+        button_stop(&btn[i]);
+    button_stop(&btn[0]);
+    for (i = 0; i < STARTED; i++)
+        CHECK(button_find(id[i]) == (i & 1 ? &btn[i] : NULL));
+    CHECK_EQ(button_init(&btn[0], read_level, 0, id[0]), 0);
+
+    /* the id is free again once its button stopped */
+    button_init(&dup, read_level, 0, id[43]);
+    CHECK_EQ(button_start(&dup), -2);
+    button_stop(&btn[43]);
+    CHECK_EQ(button_start(&dup), 0);
+    CHECK(button_find(id[43]) == &dup);
+    button_stop(&dup);
+
+    for (i = 0; i < STARTED; i++)
+        button_stop(&btn[i]);
+    for (i = 0; i < STARTED; i++)
+        CHECK(button_find(id[i]) == NULL);
+    return host_test_done("button_ids");
+}
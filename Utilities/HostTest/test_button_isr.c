@@ -0,0 +1,87 @@
+/*
+ * Worst case tick ISR with the SysTick tick source against the SysTick,
+ * SCB and NVIC models: 32 buttons pressed on the same tick, each PRESS_DOWN
+ * callback costing 5000 cycles. Built twice:
+ *
+ *   deferred (default)  the SysTick handler stays short, PendSV runs the
+ *                       callbacks, the ones beyond DEFER_QUEUE_SIZE are
+ *                       counted by button_dispatch_dropped()
+ *   BUTTON_DEFERRED_CB=0  the callbacks run inside the SysTick handler
+ */
+
+#include <wb32l003.h>
+#include "bsp_button_tick.h"
+#include "multi_button.h"
+#include "host_test.h"
+
+#define MS(ms)                  ((uint64_t)(ms) * (CORE_EMU_HCLK / 1000))
+#define BUTTONS                 32
+#define CB_CYCLES               5000
+
+static struct Button btn[BUTTONS];
+static uint8_t level[BUTTONS];
+static int calls;
+
+static uint8_t read_level(uint16_t id)
+{
+    return level[id];
+}
+
+static void on_press(void* b)
+{
+    calls++;
+    core_emu_cost(CB_CYCLES);
+}
+
+static void press_all(void* arg)
+{
+    memset(level, 0, sizeof(level));
+}
+
+static void print_isr(const char* name, int irqn)
+{
+    const CoreEmuIrqStats* st = core_emu_irq_stats(irqn);
+
+    printf("  %-8s %-7s worst %7llu cycles (%6.1f us), host %6llu ns, %llu taken\n",
+           BUTTON_DEFERRED_CB ? "deferred" : "inline", name,
+           (unsigned long long)st->max_cycles, (double)st->max_cycles / MS(1) * 1000,
+           (unsigned long long)st->max_host_ns, (unsigned long long)st->taken);
+}
+
+int main(void)
+{
+    const CoreEmuIrqStats* tick;
+    int i;
+
+    core_emu_reset();
+    SystemInit();
+    memset(level, 1, sizeof(level));
+    for (i = 0; i < BUTTONS; i++)
+    {
+        button_init(&btn[i], read_level, 0, (uint16_t)i);
+        button_attach(&btn[i], PRESS_DOWN, on_press);
+        button_start(&btn[i]);
+    }
+    ButtonTick_Init();
+
+    core_emu_run(MS(100));
+    core_emu_clear_stats();
+    core_emu_at(MS(100) + 1, press_all, 0);
+    core_emu_run(MS(100));
+
+    print_isr("SysTick", SysTick_IRQn);
+    tick = core_emu_irq_stats(SysTick_IRQn);
+#if BUTTON_DEFERRED_CB
+    print_isr("PendSV", PendSV_IRQn);
+    printf("  deferred %d callbacks run, %u dropped\n", calls, (unsigned)button_dispatch_dropped());
+    CHECK_EQ(calls, DEFER_QUEUE_SIZE);
+    CHECK_EQ(button_dispatch_dropped(), BUTTONS - DEFER_QUEUE_SIZE);
+    CHECK(tick->max_cycles < CB_CYCLES);
+    CHECK(core_emu_irq_stats(PendSV_IRQn)->max_cycles >= (uint64_t)DEFER_QUEUE_SIZE * CB_CYCLES);
+    CHECK_EQ(button_dispatch_pending(), 0);
+#else
+    CHECK_EQ(calls, BUTTONS);
+    CHECK(tick->max_cycles >= (uint64_t)BUTTONS * CB_CYCLES);
+#endif
+    return host_test_done("button_isr");
+}
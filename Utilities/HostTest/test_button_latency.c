@@ -0,0 +1,147 @@
+/*
+ * Edge to callback latency: a contact bounce keeps the stamp of the
+ * first edge until the debounce accepts the level, an EXTI stamp
+ * survives a bounce back on the first sample, a glitch that settles
+ * back is forgotten, and only the edge triggered events are measured.
+ * The engine is built with BUTTON_LATENCY 1, so is this file.
+ */
+
+#define BUTTON_LATENCY 1
+#include "multi_button.h"
+#include "host_test.h"
+
+#define TICK_US                 (TICKS_INTERVAL * 1000)
+
+static struct Button btn;
+static uint8_t level = 1;
+static uint32_t now_us;
+
+static uint8_t read_level(uint16_t id)
+{
+    return level;
+}
+
+static uint32_t clock_us(void)
+{
+    return now_us;
+}
+
+static void noop(void* b)
+{
+}
+
+/* One scan with the pin at lvl, callbacks run as PendSV would */
+static void tick(uint8_t lvl)
+{
+    level = lvl;
+    now_us += TICK_US;
+    button_ticks();
+    if (button_dispatch_pending())
+        button_dispatch();
+}
+
+static void ticks(uint8_t lvl, int n)
+{
+    while (n--)
+        tick(lvl);
+}
+
+static ButtonLatency latency_of(PressEvent ev)
+{
+    ButtonLatency lat;
+
+    button_get_latency(ev, &lat);
+    return lat;
+}
+
+static void setup(void)
+{
+    PressEvent ev;
+
+    button_stop(&btn);
+    button_init(&btn, read_level, 0, 0);
+    for (ev = PRESS_DOWN; ev < number_of_event; ev++)
+        button_attach(&btn, ev, noop);
+    button_start(&btn);
+    button_set_latency_clock(clock_us);
+    ticks(1, 100);
+    button_clear_latency();
+}
+
+/* down, bounce up, down for the debounce: measured from the first down */
+static void test_bounce_keeps_first_edge(void)
+{
+    uint32_t first;
+
+    setup();
+    tick(0);
+    first = now_us;
+    tick(1);
+    ticks(0, DEBOUNCE_TICKS);
+    CHECK_EQ(latency_of(PRESS_DOWN).count, 1);
+    CHECK_EQ(latency_of(PRESS_DOWN).max, now_us - first);
+    ticks(0, 20);
+    ticks(1, 200);
+}
+
+/* EXTI stamp 1 ms ahead of a sample that reads the bounce back up */
+static void test_exti_stamp_survives_bounce(void)
+{
+    uint32_t edge;
+
+    setup();
+    now_us += TICK_US - 1000;
+    edge = now_us;
+    button_mark_edge(&btn);
+    now_us -= TICK_US - 1000;
+    tick(1);
+    ticks(0, DEBOUNCE_TICKS);
+    CHECK_EQ(latency_of(PRESS_DOWN).max, now_us - edge);
+    ticks(0, 20);
+    ticks(1, 200);
+}
+
+/* a one sample glitch settles back, the next press has its own stamp */
+static void test_glitch_forgotten(void)
+{
+    uint32_t edge;
+
+    setup();
+    tick(0);
+    ticks(1, DEBOUNCE_TICKS + 2);
+    tick(0);
+    edge = now_us;
+    ticks(0, DEBOUNCE_TICKS - 1);
+    CHECK_EQ(latency_of(PRESS_DOWN).max, now_us - edge);
+    ticks(0, 20);
+
+    /* release: PRESS_UP measured, the click after the timeout is not */
+    tick(1);
+    edge = now_us;
+    ticks(1, DEBOUNCE_TICKS - 1);
+    CHECK_EQ(latency_of(PRESS_UP).count, 1);
+    CHECK_EQ(latency_of(PRESS_UP).max, now_us - edge);
+    ticks(1, 200);
+    CHECK_EQ(latency_of(SINGLE_CLICK).count, 0);
+}
+
+static void test_timeout_events_not_measured(void)
+{
+    setup();
+    ticks(0, LONG_TICKS + 50);
+    ticks(1, 200);
+    CHECK_EQ(latency_of(PRESS_DOWN).count, 1);
+    CHECK_EQ(latency_of(PRESS_UP).count, 1);
+    CHECK_EQ(latency_of(LONG_PRESS_START).count, 0);
+    CHECK_EQ(latency_of(LONG_PRESS_HOLD).count, 0);
+    CHECK_EQ(latency_of(SINGLE_CLICK).count, 0);
+}
+
+int main(void)
+{
+    test_bounce_keeps_first_edge();
+    test_exti_stamp_survives_bounce();
+    test_glitch_forgotten();
+    test_timeout_events_not_measured();
+    return host_test_done("button_latency");
+}
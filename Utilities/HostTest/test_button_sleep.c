@@ -0,0 +1,262 @@
+/*
+ * DEEPSLEEP between presses, main.c's CALLBACK setup with the SOFTTIMER
+ * tick: the core sleeps through most of a sparse press script, the
+ * engine clock keeps real time across the sleeps, a press racing the
+ * arming aborts the sleep, and the clock gates survive the wake.
+ *
+ * Armed soft timers wake the core at their deadlines: a one shot and a
+ * repeating timer expire at their real times, with soft_timer_now() and
+ * the timebase as far on as the time slept.
+ */
+
+#include <wb32l003.h>
+#include "bsp_button_sleep.h"
+#include "bsp_button_tick.h"
+#include "bsp_timebase.h"
+#include "soft_timer.h"
+#include "multi_button.h"
+#include "host_test.h"
+
+#define MS(ms)                  ((uint64_t)(ms) * (CORE_EMU_HCLK / 1000))
+#define BTN_PIN                 GPIO_Pin_3
+#define EVENT_MAX               32
+#define EXPIRY_MAX              16
+
+typedef struct {
+    PressEvent event;
+    uint32_t clock;
+    uint64_t cycle;
+} Seen;
+
+static struct Button btn;
+static ButtonWakePin wake_pins[1];
+static Seen seen[EVENT_MAX];
+static int seen_num;
+
+typedef struct {
+    uint64_t cycle;
+    uint32_t now;               /* soft_timer_now() */
+    uint32_t ms;                /* Timebase_GetMs() */
+} Expiry;
+
+static SoftTimer once, every;
+static Expiry once_at[EXPIRY_MAX], every_at[EXPIRY_MAX];
+static int once_num, every_num;
+
+static uint8_t read_btn(uint16_t id)
+{
+    return GPIO_ReadInputDataBit(GPIOD, BTN_PIN);
+}
+
+static void record(void* b)
+{
+    if (seen_num < EVENT_MAX)
+    {
+        seen[seen_num].event = button_current_event()->event;
+        seen[seen_num].clock = button_get_clock();
+        seen[seen_num].cycle = core_emu_cycles();
+        seen_num++;
+    }
+}
+
+static void press_at(uint32_t ms, uint32_t hold_ms)
+{
+    gpio_emu_drive_at(MS(ms), GPIOD_BASE, BTN_PIN, 0);
+    gpio_emu_drive_at(MS(ms + hold_ms), GPIOD_BASE, BTN_PIN, 1);
+}
+
+/* main()'s loop, a DEEPSLEEP lasts until the next press edge */
+static void run_main_until(uint32_t ms)
+{
+    while (core_emu_cycles() < MS(ms))
+        ButtonSleep_Enter();
+}
+
+static int count_of(PressEvent event)
+{
+    int i, n = 0;
+
+    for (i = 0; i < seen_num; i++)
+        n += seen[i].event == event;
+    return n;
+}
+
+static void expired(Expiry* at, int* num)
+{
+    if (*num < EXPIRY_MAX)
+    {
+        at[*num].cycle = core_emu_cycles();
+        at[*num].now = soft_timer_now();
+        at[*num].ms = Timebase_GetMs();
+        (*num)++;
+    }
+}
+
+static void once_expired(void)
+{
+    expired(once_at, &once_num);
+}
+
+static void every_expired(void)
+{
+    expired(every_at, &every_num);
+}
+
+static void setup(void)
+{
+    static int periodic = -1;
+
+    core_emu_reset();
+    SystemInit();
+    seen_num = 0;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOD | RCC_AHBPeriph_GPIOC, ENABLE);
+    GPIO_Init(GPIOD, BTN_PIN, GPIO_MODE_IN | GPIO_SPEED_HIGH);
+    gpio_emu_drive(GPIOD_BASE, BTN_PIN, 1);
+
+    button_stop(&btn);
+    button_init(&btn, read_btn, 0, 0);
+    button_attach(&btn, PRESS_DOWN, record);
+    button_attach(&btn, SINGLE_CLICK, record);
+    button_attach(&btn, DOUBLE_CLICK, record);
+    button_attach(&btn, LONG_PRESS_START, record);
+    button_start(&btn);
+
+    Timebase_Init();
+    if (periodic < 0)
+        periodic = Timebase_AddPeriodic(soft_timer_ticks, 1);
+    ButtonTick_Init();
+
+    wake_pins[0].port = GPIOD;
+    wake_pins[0].pin = BTN_PIN;
+    wake_pins[0].active_level = 0;
+    wake_pins[0].irqn = GPIOD_IRQn;
+    ButtonSleep_Init(wake_pins, 1);
+}
+
+/* Sparse presses over two minutes: asleep between them, clock on time */
+static void test_sleep_fraction(void)
+{
+    uint32_t pclken, hclken;
+    uint32_t ms;
+    int i;
+
+    setup();
+    pclken = RCC->PCLKEN;
+    hclken = RCC->HCLKEN;
+
+    press_at(3000, 100);
+    press_at(20000, 1500);
+    press_at(61700, 80);
+    press_at(61900, 80);
+    press_at(117000, 120);
+    /* the press ending the script wakes the last sleep */
+    press_at(120000, 200);
+    run_main_until(120000);
+    CHECK(core_emu_cycles() < MS(120000) + MS(1));
+
+    CHECK_EQ(count_of(PRESS_DOWN), 5);
+    CHECK_EQ(count_of(SINGLE_CLICK), 2);
+    CHECK_EQ(count_of(DOUBLE_CLICK), 1);
+    CHECK_EQ(count_of(LONG_PRESS_START), 1);
+
+    /* every event at the engine clock of its real time, within one tick */
+    for (i = 0; i < seen_num; i++)
+    {
+        uint32_t real = (uint32_t)(seen[i].cycle / MS(1));
+        uint32_t engine = seen[i].clock * TICKS_INTERVAL;
+        CHECK(engine + TICKS_INTERVAL >= real && engine <= real + TICKS_INTERVAL);
+    }
+
+    /* a 1000 ms hold makes the long press at the engine and in real time */
+    for (i = 0; i < seen_num; i++)
+    {
+        if (seen[i].event == LONG_PRESS_START)
+            CHECK(seen[i].cycle >= MS(21000) && seen[i].cycle < MS(21000 + 3 * TICKS_INTERVAL));
+    }
+
+    CHECK(core_emu_stats()->deepsleep_cycles > MS(120000) * 95 / 100);
+    CHECK(core_emu_stats()->sleep_cycles > 0);
+    printf("  asleep %.2f%% deep, %.2f%% light over 120 s\n",
+           100.0 * core_emu_stats()->deepsleep_cycles / MS(120000),
+           100.0 * core_emu_stats()->sleep_cycles / MS(120000));
+
+    /* the clock gates are back and the timebase runs after the wake */
+    CHECK_EQ(RCC->PCLKEN, pclken);
+    CHECK_EQ(RCC->HCLKEN, hclken);
+    ms = Timebase_GetMs();
+    run_main_until(120100);
+    CHECK(Timebase_GetMs() - ms >= 99);
+    CHECK_EQ(count_of(PRESS_DOWN), 6);
+}
+
+/* A press between the idle scan and the arming: no DEEPSLEEP, pins disarmed */
+static void test_press_races_arming(void)
+{
+    uint32_t clock;
+
+    setup();
+    CHECK(button_is_idle());
+    clock = button_get_clock();
+
+    core_emu_clear_stats();
+    gpio_emu_drive(GPIOD_BASE, BTN_PIN, 0);
+    CHECK_EQ(ButtonSleep_Enter(), 0);
+    CHECK_EQ(core_emu_stats()->deepsleep_cycles, 0);
+    CHECK_EQ(GPIOD->INTEN & BTN_PIN, 0);
+    CHECK_EQ(NVIC_GetEnableIRQ(GPIOD_IRQn), 0);
+
+    /* the tick kept running and sees the press */
+    run_main_until(100);
+    CHECK(button_get_clock() > clock);
+    CHECK_EQ(count_of(PRESS_DOWN), 1);
+    gpio_emu_drive(GPIOD_BASE, BTN_PIN, 1);
+}
+
+/* Soft timers of 5000 ms and every 1500 ms armed: woken within 1 ms, clocks on */
+static void test_soft_timer_wake(void)
+{
+    uint32_t now, ms;
+    int i;
+
+    setup();
+    once_num = every_num = 0;
+    soft_timer_init(&once, once_expired, 5000, 0);
+    soft_timer_init(&every, every_expired, 1500, 1500);
+    core_emu_clear_stats();
+    now = soft_timer_now();
+    ms = Timebase_GetMs();
+    CHECK_EQ(soft_timer_start(&once), 0);
+    CHECK_EQ(soft_timer_start(&every), 0);
+
+    /* the press wakes the last sleep, the next expiry is due at 10500 */
+    press_at(10000, 100);
+    run_main_until(10100);
+    soft_timer_stop(&every);
+
+    CHECK_EQ(once_num, 1);
+    CHECK_EQ(every_num, 6);
+    CHECK_EQ(once_at[0].now - now, 5000);
+    CHECK(once_at[0].cycle + MS(1) > MS(5000) && once_at[0].cycle < MS(5000 + 1));
+    CHECK(once_at[0].ms - ms >= 4999 && once_at[0].ms - ms <= 5001);
+    for (i = 0; i < every_num; i++)
+    {
+        uint32_t due = 1500 * (i + 1);
+
+        CHECK_EQ(every_at[i].now - now, due);
+        CHECK(every_at[i].cycle + MS(1) > MS(due) && every_at[i].cycle < MS(due + 1));
+        CHECK(every_at[i].ms - ms >= due - 1 && every_at[i].ms - ms <= due + 1);
+    }
+
+    /* asleep in between, not ticking through the deadlines */
+    CHECK(core_emu_stats()->deepsleep_cycles > MS(10000) * 95 / 100);
+    CHECK_EQ(count_of(PRESS_DOWN), 1);
+}
+
+int main(void)
+{
+    test_sleep_fraction();
+    test_press_races_arming();
+    test_soft_timer_wake();
+    return host_test_done("button_sleep");
+}
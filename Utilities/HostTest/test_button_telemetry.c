@@ -0,0 +1,150 @@
+/*
+ * Button telemetry: clicks, a double click, long presses and contact
+ * bounces on one button, then its counters, the log2 press duration and
+ * bounce length histograms, and the Telemetry_Encode() record byte by
+ * byte. Telemetry_Send() puts the same record on the LPUART model. The
+ * engine is built with BUTTON_TELEMETRY 1, so is this file.
+ */
+
+#define BUTTON_TELEMETRY 1
+#include <string.h>
+#include <wb32l003.h>
+#include "multi_button.h"
+#include "button_telemetry.h"
+#include "bsp_lpuart1.h"
+#include "host_test.h"
+
+#define BUTTON_ID               0x1234
+
+static struct Button btn;
+static uint8_t level = 1;
+
+static uint8_t read_level(uint16_t id)
+{
+    (void)id;
+    return level;
+}
+
+static void ticks(uint32_t n)
+{
+    while (n--)
+        button_ticks();
+}
+
+/* Held low for hold ticks, then released and left alone for gap ticks */
+static void press(uint32_t hold, uint32_t gap)
+{
+    level = 0;
+    ticks(hold);
+    level = 1;
+    ticks(gap);
+}
+
+/* The level flips for len ticks, shorter than the debounce */
+static void bounce(uint32_t len)
+{
+    level = !level;
+    ticks(len);
+    level = !level;
+    ticks(1);
+}
+
+static uint32_t u16_at(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t u32_at(const uint8_t* p)
+{
+    return u16_at(p) | (u16_at(p + 2) << 16);
+}
+
+int main(void)
+{
+    uint8_t record[TELEMETRY_RECORD_SIZE], wire[2 * TELEMETRY_RECORD_SIZE];
+    uint16_t press_hist[STATS_PRESS_BUCKETS] = { 0 };
+    ButtonStats stats;
+    uint32_t i, n;
+
+    core_emu_reset();
+    SystemInit();
+    print_init(115200);
+
+    button_init(&btn, read_level, 0, BUTTON_ID);
+    CHECK_EQ(button_start(&btn), 0);
+    ticks(10);
+
+    /* 5 clicks of 10 ticks: bucket 3 */
+    for (i = 0; i < 5; i++)
+        press(10, 2 * SHORT_TICKS);
+    press_hist[3] += 5;
+
+    /* a double click of 6 tick presses: 2 presses, bucket 2 */
+    press(6, 10);
+    press(6, 2 * SHORT_TICKS);
+    press_hist[2] += 2;
+
+    /* long presses of 300 ticks and of 70000, the last bucket collects it */
+    press(300, 2 * SHORT_TICKS);
+    press(70000, 2 * SHORT_TICKS);
+    press_hist[8]++;
+    press_hist[STATS_PRESS_BUCKETS - 1]++;
+
+    /* bounces while released and while held: 3 of 1 tick, 2 of 2 ticks */
+    bounce(1);
+    bounce(2);
+    level = 0;
+    ticks(20);
+    bounce(1);
+    bounce(2);
+    bounce(1);
+    level = 1;
+    ticks(2 * SHORT_TICKS);
+    press_hist[4]++;    /* the held one: 20 + 6 ticks of bounces */
+
+    button_get_stats(&btn, &stats);
+    CHECK_EQ(stats.presses, 5 + 2 + 2 + 1);
+    CHECK_EQ(stats.clicks, 5 + 1);
+    CHECK_EQ(stats.double_clicks, 1);
+    CHECK_EQ(stats.long_presses, 2);
+    CHECK_EQ(stats.bounces, 5);
+    CHECK_EQ(stats.bounce_hist[0], 3);
+    CHECK_EQ(stats.bounce_hist[1], 2);
+    for (i = 2; i < STATS_BOUNCE_BUCKETS; i++)
+        CHECK_EQ(stats.bounce_hist[i], 0);
+    for (i = 0; i < STATS_PRESS_BUCKETS; i++)
+        CHECK_EQ(stats.press_hist[i], press_hist[i]);
+
+    /* the record: header, clock, counters, then both histograms, little endian */
+    n = Telemetry_Encode(&btn, record);
+    CHECK_EQ(n, TELEMETRY_RECORD_SIZE);
+    CHECK_EQ(TELEMETRY_RECORD_SIZE, 60);
+    CHECK_EQ(record[0], TELEMETRY_MAGIC);
+    CHECK_EQ(record[1], TELEMETRY_VERSION);
+    CHECK_EQ(u16_at(record + 2), BUTTON_ID);
+    CHECK_EQ(u32_at(record + 4), button_get_clock());
+    CHECK_EQ(u32_at(record + 8), stats.presses);
+    CHECK_EQ(u32_at(record + 12), stats.clicks);
+    CHECK_EQ(u32_at(record + 16), stats.double_clicks);
+    CHECK_EQ(u32_at(record + 20), stats.long_presses);
+    CHECK_EQ(u32_at(record + 24), stats.bounces);
+    for (i = 0; i < STATS_PRESS_BUCKETS; i++)
+        CHECK_EQ(u16_at(record + 28 + 2 * i), press_hist[i]);
+    CHECK_EQ(u16_at(record + 52), 3);
+    CHECK_EQ(u16_at(record + 54), 2);
+    CHECK_EQ(u16_at(record + 56), 0);
+    CHECK_EQ(u16_at(record + 58), 0);
+
+    /* the same bytes on the line */
+    Telemetry_Send(&btn);
+    print_flush();
+    core_emu_run((TELEMETRY_RECORD_SIZE + 2) * uart_emu_byte_cycles(LPUART_BASE));
+    CHECK_EQ(uart_emu_tx(LPUART_BASE, wire, sizeof(wire)), TELEMETRY_RECORD_SIZE);
+    CHECK(memcmp(wire, record, TELEMETRY_RECORD_SIZE) == 0);
+
+    button_clear_stats(&btn);
+    button_get_stats(&btn, &stats);
+    CHECK_EQ(stats.presses + stats.bounces + stats.press_hist[3] + stats.bounce_hist[0], 0);
+
+    return host_test_done("button_telemetry");
+}
@@ -0,0 +1,117 @@
+/*
+ * Engine clock accuracy of each tick source, built once per
+ * BUTTON_TICK_SOURCE: across the slow idle scan, the period changes and
+ * the rounding of the periods to the LPTIM/AWK clock, the engine clock
+ * never runs ahead of real time and lags it by one idle period and one
+ * tick at most.
+ */
+
+#include <wb32l003.h>
+#include "bsp_button_tick.h"
+#include "bsp_timebase.h"
+#include "soft_timer.h"
+#include "multi_button.h"
+#include "host_test.h"
+
+#define MS(ms)                  ((uint64_t)(ms) * (CORE_EMU_HCLK / 1000))
+#define BTN_PIN                 GPIO_Pin_3
+#define SLOW_MS                 (TICKS_INTERVAL * BUTTON_TICK_IDLE_DIV)
+
+static const char* const source_name[] = {
+    "systick", "lptim", "awk", "timebase", "softtimer"
+};
+
+static struct Button btn;
+static uint64_t start;
+static uint64_t long_start_at;
+static int clicks, doubles, long_starts;
+
+static uint8_t read_btn(uint16_t id)
+{
+    return GPIO_ReadInputDataBit(GPIOD, BTN_PIN);
+}
+
+static void on_event(void* b)
+{
+    switch (button_current_event()->event)
+    {
+    case SINGLE_CLICK:
+        clicks++;
+        break;
+    case DOUBLE_CLICK:
+        doubles++;
+        break;
+    case LONG_PRESS_START:
+        long_starts++;
+        long_start_at = core_emu_cycles();
+        break;
+    default:
+        break;
+    }
+}
+
+static void press_at(uint32_t ms, uint32_t hold_ms)
+{
+    gpio_emu_drive_at(start + MS(ms), GPIOD_BASE, BTN_PIN, 0);
+    gpio_emu_drive_at(start + MS(ms + hold_ms), GPIOD_BASE, BTN_PIN, 1);
+}
+
+int main(void)
+{
+    double ahead = -1e9, behind = -1e9;
+    uint32_t ms;
+
+    core_emu_reset();
+    SystemInit();
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOD, ENABLE);
+    GPIO_Init(GPIOD, BTN_PIN, GPIO_MODE_IN | GPIO_SPEED_HIGH);
+    gpio_emu_drive(GPIOD_BASE, BTN_PIN, 1);
+
+    button_init(&btn, read_btn, 0, 0);
+    button_attach(&btn, SINGLE_CLICK, on_event);
+    button_attach(&btn, DOUBLE_CLICK, on_event);
+    button_attach(&btn, LONG_PRESS_START, on_event);
+    button_start(&btn);
+
+    Timebase_Init();
+    Timebase_AddPeriodic(soft_timer_ticks, 1);
+    start = core_emu_cycles();
+    ButtonTick_Init();
+
+    /* idle spans of every length around the period changes */
+    press_at(1000, 100);
+    press_at(3000, 2500);
+    press_at(9000, 80);
+    press_at(9200, 80);
+    press_at(9900, 60);
+    press_at(31000, 150);
+    press_at(45003, 150);
+
+    for (ms = 1; ms <= 60000; ms++)
+    {
+        double real, engine;
+
+        core_emu_run(start + MS(ms) - core_emu_cycles());
+        real = (double)(core_emu_cycles() - start) / MS(1);
+        engine = (double)button_get_clock() * TICKS_INTERVAL;
+        if (engine - real > ahead)
+            ahead = engine - real;
+        if (real - engine > behind)
+            behind = real - engine;
+    }
+
+    printf("  %-9s engine clock: at most %.3f ms ahead, %.3f ms behind\n",
+           source_name[BUTTON_TICK_SOURCE], ahead, behind);
+    CHECK(ahead <= 0.01);
+    CHECK(behind <= SLOW_MS + TICKS_INTERVAL);
+
+    CHECK_EQ(clicks, 4);
+    CHECK_EQ(doubles, 1);
+    CHECK_EQ(long_starts, 1);
+    /* LONG_TICKS after the press, late by the idle scan and the debounce at most */
+    CHECK(long_start_at >= start + MS(3000 + 1000));
+    CHECK(long_start_at <= start + MS(3000 + 1000 + SLOW_MS + (DEBOUNCE_TICKS + 2) * TICKS_INTERVAL));
+
+    return host_test_done("button_tick");
+}
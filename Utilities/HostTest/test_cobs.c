@@ -0,0 +1,143 @@
+/*
+ * COBS codec: the encodings of the reference examples, a round trip of
+ * random frames with runs of zeros and 254 byte blocks, and the streaming
+ * decoder on a damaged stream: oversized and truncated frames are counted
+ * and dropped, the frames after the next delimiter come through.
+ */
+
+#include <string.h>
+#include "cobs.h"
+#include "host_test.h"
+
+#define FRAME_MAX               600
+#define ROUNDS                  20000
+
+static uint8_t got[16][FRAME_MAX];
+static uint16_t got_len[16];
+static uint32_t got_count;
+
+static void on_frame(const uint8_t* frame, uint16_t len, void* arg)
+{
+    (void)arg;
+    if (got_count < 16)
+    {
+        memcpy(got[got_count], frame, len);
+        got_len[got_count] = len;
+    }
+    got_count++;
+}
+
+/* The encoding of src must be exactly want, delimiter included */
+static void check_encode(const uint8_t* src, uint16_t len, const uint8_t* want, uint16_t want_len)
+{
+    uint8_t out[COBS_MAX_ENCODED(FRAME_MAX)];
+    uint16_t n = cobs_encode(src, len, out);
+
+    CHECK_EQ(n, want_len);
+    CHECK(n <= COBS_MAX_ENCODED(len));
+    CHECK(memcmp(out, want, want_len) == 0);
+}
+
+static void feed(CobsDecoder* dec, const uint8_t* data, uint16_t len)
+{
+    while (len--)
+        cobs_decode_byte(dec, *data++);
+}
+
+int main(void)
+{
+    static uint8_t frame[FRAME_MAX], wire[COBS_MAX_ENCODED(FRAME_MAX)], buf[FRAME_MAX];
+    CobsDecoder dec;
+    uint32_t seed = 0xC0B5, i, j;
+
+    /* the examples of the COBS paper */
+    {
+        static const uint8_t z1[] = { 0x00 }, e1[] = { 0x01, 0x01, 0x00 };
+        static const uint8_t z2[] = { 0x00, 0x00 }, e2[] = { 0x01, 0x01, 0x01, 0x00 };
+        static const uint8_t z3[] = { 0x11, 0x22, 0x00, 0x33 }, e3[] = { 0x03, 0x11, 0x22, 0x02, 0x33, 0x00 };
+        static const uint8_t z4[] = { 0x11, 0x00, 0x00, 0x00 }, e4[] = { 0x02, 0x11, 0x01, 0x01, 0x01, 0x00 };
+        static const uint8_t e0[] = { 0x01, 0x00 };
+
+        check_encode(z1, 0, e0, sizeof(e0));
+        check_encode(z1, sizeof(z1), e1, sizeof(e1));
+        check_encode(z2, sizeof(z2), e2, sizeof(e2));
+        check_encode(z3, sizeof(z3), e3, sizeof(e3));
+        check_encode(z4, sizeof(z4), e4, sizeof(e4));
+    }
+
+    /* 254 and 255 non-zero bytes: one full block, then a block of one */
+    for (i = 0; i < 255; i++)
+        frame[i] = (uint8_t)(i + 1);
+    frame[254] = 0xFF;
+    wire[0] = 0xFF;
+    memcpy(wire + 1, frame, 254);
+    wire[255] = 0x01;
+    wire[256] = 0x00;
+    check_encode(frame, 254, wire, 257);
+    wire[255] = 0x02;
+    wire[256] = 0xFF;
+    wire[257] = 0x00;
+    check_encode(frame, 255, wire, 258);
+
+    /* random frames, zeros and long non-zero runs mixed */
+    cobs_decoder_init(&dec, buf, sizeof(buf), on_frame, 0);
+    for (i = 0; i < ROUNDS && !host_test_failures; i++)
+    {
+        uint32_t r = host_test_rand(&seed);
+        uint16_t len = (uint16_t)(r % FRAME_MAX), n;
+
+        for (j = 0; j < len; j++)
+        {
+            uint32_t b = host_test_rand(&seed);
+            frame[j] = (r >> 16) & 1 ? (uint8_t)(b | 1) : (b & 7) == 0 ? 0 : (uint8_t)b;
+        }
+        n = cobs_encode(frame, len, wire);
+        CHECK(n <= COBS_MAX_ENCODED(len));
+        CHECK(memchr(wire, 0, n - 1) == NULL);
+        got_count = 0;
+        feed(&dec, wire, n);
+        CHECK_EQ(got_count, 1);
+        CHECK_EQ(got_len[0], len);
+        CHECK(memcmp(got[0], frame, len) == 0);
+    }
+    CHECK_EQ(dec.errors, 0);
+
+    /* a damaged stream: garbage, an oversized frame, a truncated one */
+    {
+        static const uint8_t a[] = { 1, 2, 3 }, b[] = { 0, 9, 0 };
+        uint8_t small[8];
+        uint16_t n;
+
+        cobs_decoder_init(&dec, small, sizeof(small), on_frame, 0);
+        got_count = 0;
+
+        /* empty delimiters and an encoded frame cut by a delimiter */
+        feed(&dec, (const uint8_t*)"\0\0\x05\x11\x22\0", 6);
+        CHECK_EQ(got_count, 0);
+        CHECK_EQ(dec.errors, 1);
+
+        for (j = 0; j < 20; j++)
+            frame[j] = (uint8_t)(j + 1);
+        n = cobs_encode(frame, 20, wire);
+        feed(&dec, wire, n);
+        CHECK_EQ(got_count, 0);
+        CHECK_EQ(dec.errors, 2);
+
+        n = cobs_encode(a, sizeof(a), wire);
+        feed(&dec, wire, n);
+        n = cobs_encode(b, sizeof(b), wire);
+        feed(&dec, wire, n);
+        n = cobs_encode(frame, sizeof(small), wire);
+        feed(&dec, wire, n);
+        CHECK_EQ(got_count, 3);
+        CHECK_EQ(got_len[0], sizeof(a));
+        CHECK(memcmp(got[0], a, sizeof(a)) == 0);
+        CHECK_EQ(got_len[1], sizeof(b));
+        CHECK(memcmp(got[1], b, sizeof(b)) == 0);
+        CHECK_EQ(got_len[2], sizeof(small));
+        CHECK(memcmp(got[2], frame, sizeof(small)) == 0);
+        CHECK_EQ(dec.errors, 2);
+    }
+
+    return host_test_done("cobs");
+}
@@ -0,0 +1,92 @@
+/*
+ * crc16_soft against its own generation rule and the CRC unit model:
+ * the checked in tables match the bit at a time register, the table,
+ * carry-less multiply and dispatched paths agree with it at every length
+ * and alignment, and crc16_soft() matches CRC_Calculate() on the model.
+ */
+
+#include <string.h>
+#include <wb32l003.h>
+#include "wb32l003_crc.h"
+#include "wb32l003_rcc.h"
+#include "crc16_soft.h"
+#include "crc16_soft_table.h"
+#include "host_test.h"
+
+#define BUF_LEN                 2100
+#define RUNS                    2000
+
+static uint8_t buf[BUF_LEN + 16];
+
+static void check_tables(void)
+{
+    uint8_t msg[8] = { 0 };
+    int k, n;
+
+    for (k = 0; k < CRC16_SOFT_SLICES; k++)
+    {
+        for (n = 0; n < 256; n++)
+        {
+            msg[0] = (uint8_t)n;
+            CHECK_EQ(crc_table[k][n], crc16_soft_bitwise(0, msg, k + 1));
+        }
+    }
+}
+
+static void check_paths(uint32_t* seed)
+{
+    uint32_t off = host_test_rand(seed) % 16;
+    uint32_t len = host_test_rand(seed) % 4 ? host_test_rand(seed) % 200 : host_test_rand(seed) % BUF_LEN;
+    uint16_t crc = (uint16_t)host_test_rand(seed);
+    uint16_t ref = crc16_soft_bitwise(crc, buf + off, len);
+    uint32_t split = len ? host_test_rand(seed) % len : 0;
+
+    CHECK_EQ(crc16_soft_table(crc, buf + off, len), ref);
+#if CRC16_SOFT_CLMUL
+    if (crc16_soft_clmul_supported())
+        CHECK_EQ(crc16_soft_clmul(crc, buf + off, len), ref);
+#endif
+    CHECK_EQ(crc16_soft_update(crc16_soft_update(crc, buf + off, split), buf + off + split, len - split), ref);
+}
+
+static void check_model(uint32_t* seed)
+{
+    uint32_t off = host_test_rand(seed) % 4;
+    uint32_t len = host_test_rand(seed) % 300;
+    CRC_ContextTypeDef ctx;
+
+    CHECK_EQ(CRC_Calculate(buf + off, len), crc16_soft(buf + off, len));
+    CRC_ContextInit(&ctx);
+    CRC_ContextUpdate(&ctx, buf + off, len);
+    CHECK_EQ(ctx.State, crc16_soft_update(CRC16_SOFT_SEED, buf + off, len));
+}
+
+int main(void)
+{
+    static const uint8_t check[] = "123456789";
+    uint32_t seed = 0x51C16;
+    uint32_t i;
+
+    core_emu_reset();
+    SystemInit();
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_CRC, ENABLE);
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)host_test_rand(&seed);
+
+    check_tables();
+    CHECK_EQ(crc16_soft(check, 9), CRC16_SOFT_CHECK);
+    CHECK_EQ(crc16_soft_bitwise(CRC16_SOFT_SEED, check, 9) ^ CRC16_SOFT_XOROUT, CRC16_SOFT_CHECK);
+    CHECK_EQ(CRC_Calculate(check, 9), CRC16_SOFT_CHECK);
+
+    for (i = 0; i < RUNS; i++)
+        check_paths(&seed);
+    for (i = 0; i < RUNS / 10; i++)
+        check_model(&seed);
+
+#if CRC16_SOFT_CLMUL
+    if (!crc16_soft_clmul_supported())
+        printf("  no PCLMULQDQ on this host, carry-less multiply path not checked\n");
+#endif
+    return host_test_done("crc16_soft");
+}
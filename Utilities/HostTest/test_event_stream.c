@@ -0,0 +1,280 @@
+/*
+ * event_stream: random events round trip through the encoder, COBS and
+ * the decoder with every field, the stage included; the trailer is the
+ * CRC-16/X-25 of crc16_soft() and a flipped bit is refused; a finish
+ * while the last frame waits for the transport leaves it alone.
+ *
+ * evstream_pump() on the engine with a capture transport: presses a few
+ * ticks apart share one frame, closed EVSTREAM_BATCH_TICKS after its
+ * first event, and a stalled transport raises backpressure, then every
+ * frame arrives in sequence once it drains.
+ */
+
+#include <string.h>
+#include "multi_button.h"
+#include "event_stream.h"
+#include "crc16_soft.h"
+#include "host_test.h"
+
+#define BUTTONS                 4
+#define ROUNDS                  20000
+
+static struct Button btn[BUTTONS];
+static uint8_t level[BUTTONS];
+
+/* the capture transport */
+static uint8_t line[8192];
+static uint16_t line_len;
+static uint16_t room;
+
+static uint16_t tx_free(void)
+{
+    return room;
+}
+
+static void tx_write(const uint8_t* buf, uint16_t len)
+{
+    CHECK(len <= room);
+    memcpy(line + line_len, buf, len);
+    line_len += len;
+    room -= len;
+}
+
+/* what came out of the line, decoded */
+static ButtonEvent got[256];
+static uint16_t got_count;
+static uint8_t frame_count, frame_seq[64];
+
+static void on_frame(const uint8_t* frame, uint16_t len, void* arg)
+{
+    uint8_t seq;
+    int n = evstream_decode(frame, len, got + got_count, 256 - got_count, &seq);
+
+    (void)arg;
+    CHECK(n > 0);
+    if (n <= 0)
+        return;
+    got_count += n;
+    frame_seq[frame_count & 63] = seq;
+    frame_count++;
+}
+
+static void decode_line(void)
+{
+    static uint8_t buf[EVSTREAM_FRAME_MAX];
+    CobsDecoder dec;
+    uint16_t i;
+
+    got_count = 0;
+    frame_count = 0;
+    cobs_decoder_init(&dec, buf, sizeof(buf), on_frame, 0);
+    for (i = 0; i < line_len; i++)
+        cobs_decode_byte(&dec, line[i]);
+    CHECK_EQ(dec.errors, 0);
+    line_len = 0;
+}
+
+static uint8_t read_level(uint16_t id)
+{
+    return level[id];
+}
+
+static void random_event(ButtonEvent* ev, uint32_t* time, uint32_t* seed)
+{
+    uint32_t r = host_test_rand(seed);
+
+    memset(ev, 0, sizeof(ButtonEvent));
+    *time += r & 1 ? r % 50 : r % 100000;
+    ev->timestamp = *time;
+    ev->button_id = (uint16_t)(r >> 16 & 1 ? host_test_rand(seed) : r % 8);
+    ev->event = (r >> 8) & 0xF;
+    ev->repeat = (r >> 12) & 0xF;
+    ev->stage = (uint8_t)((r >> 17) & 1 ? host_test_rand(seed) : 0);
+    ev->duration = (uint16_t)host_test_rand(seed);
+}
+
+static int same_event(const ButtonEvent* a, const ButtonEvent* b)
+{
+    return a->timestamp == b->timestamp && a->button_id == b->button_id && a->event == b->event &&
+           a->repeat == b->repeat && a->stage == b->stage && a->duration == b->duration;
+}
+
+static void test_codec(void)
+{
+    static ButtonEvent sent[256];
+    EvStream s;
+    uint32_t seed = 0xE5E5, time = 0, i, in_frame = 0, checked = 0;
+    int n;
+
+    room = sizeof(line);
+    evstream_init(&s, tx_free, tx_write);
+    for (i = 0; i < ROUNDS && !host_test_failures; i++)
+    {
+        random_event(&sent[in_frame], &time, &seed);
+        if (evstream_add(&s, &sent[in_frame]) == 0)
+        {
+            in_frame++;
+            continue;
+        }
+
+        /* full: the frame goes out, the event opens the next one */
+        n = evstream_finish(&s);
+        CHECK(n > 0 && n <= COBS_MAX_ENCODED(EVSTREAM_FRAME_MAX));
+        line_len = 0;
+        room = sizeof(line);
+        tx_write(s.out, s.out_len);
+        s.out_len = 0;
+        decode_line();
+        CHECK_EQ(got_count, in_frame);
+        for (n = 0; n < (int)in_frame; n++)
+            CHECK(same_event(&got[n], &sent[n]));
+        checked += in_frame;
+        sent[0] = sent[in_frame];
+        in_frame = 1;
+        CHECK_EQ(evstream_add(&s, &sent[0]), 0);
+    }
+    CHECK(checked > ROUNDS / 2);
+
+    /* the trailer is crc16_soft() of the frame, one flipped bit fails */
+    {
+        ButtonEvent ev = { 0 };
+        uint8_t raw[EVSTREAM_FRAME_MAX];
+        uint16_t len;
+
+        evstream_init(&s, tx_free, tx_write);
+        ev.timestamp = 1234;
+        ev.stage = 2;
+        CHECK_EQ(evstream_add(&s, &ev), 0);
+        len = s.len;
+        memcpy(raw, s.frame, len);
+        raw[2] = 1;
+        CHECK(evstream_finish(&s) > 0);
+        line_len = 0;
+        room = sizeof(line);
+        tx_write(s.out, s.out_len);
+        decode_line();
+        CHECK_EQ(got_count, 1);
+        CHECK_EQ(got[0].stage, 2);
+
+        {
+            uint16_t crc = crc16_soft(raw, len);
+            ButtonEvent out;
+
+            raw[len] = (uint8_t)crc;
+            raw[len + 1] = (uint8_t)(crc >> 8);
+            CHECK_EQ(evstream_decode(raw, len + 2, &out, 1, 0), 1);
+            raw[len - 1] ^= 0x10;
+            CHECK_EQ(evstream_decode(raw, len + 2, &out, 1, 0), -1);
+        }
+    }
+
+    /* finish with the last frame still waiting keeps both */
+    {
+        ButtonEvent ev = { 0 };
+        uint8_t pending[COBS_MAX_ENCODED(EVSTREAM_FRAME_MAX)];
+        uint16_t pending_len;
+
+        evstream_init(&s, tx_free, tx_write);
+        ev.button_id = 1;
+        evstream_add(&s, &ev);
+        pending_len = (uint16_t)evstream_finish(&s);
+        memcpy(pending, s.out, pending_len);
+        ev.button_id = 2;
+        CHECK_EQ(evstream_add(&s, &ev), 0);
+        CHECK_EQ(evstream_finish(&s), -1);
+        CHECK_EQ(s.out_len, pending_len);
+        CHECK(memcmp(s.out, pending, pending_len) == 0);
+        CHECK_EQ(s.count, 1);
+    }
+}
+
+static void engine_init(void)
+{
+    ButtonEvent ev[EVENT_QUEUE_SIZE];
+    int i;
+
+    for (i = 0; i < BUTTONS; i++)
+    {
+        button_stop(&btn[i]);
+        level[i] = 1;
+        button_init(&btn[i], read_level, 0, (uint16_t)i);
+        CHECK_EQ(button_start(&btn[i]), 0);
+    }
+    while (button_poll_events(ev, EVENT_QUEUE_SIZE, NULL))
+        ;
+    button_set_backpressure(0);
+}
+
+/* A tick of the engine, then the pump as a main loop would run it */
+static void tick(EvStream* s)
+{
+    button_ticks();
+    evstream_pump(s);
+}
+
+static void test_pump(void)
+{
+    EvStream s;
+    uint32_t t, first;
+    int i;
+
+    /* presses 2 ticks apart, a fast transport: one frame of 3 */
+    engine_init();
+    evstream_init(&s, tx_free, tx_write);
+    room = sizeof(line);
+    line_len = 0;
+    for (i = 0; i < 3; i++)
+    {
+        level[i] = 0;
+        tick(&s);
+        tick(&s);
+    }
+    for (t = 0; t < DEBOUNCE_TICKS && line_len == 0; t++)
+        tick(&s);
+    CHECK_EQ(line_len, 0);
+    CHECK_EQ(s.count, 3);
+    first = s.first_time;
+    while (line_len == 0)
+        tick(&s);
+    CHECK_EQ(button_get_clock() - first, EVSTREAM_BATCH_TICKS);
+    decode_line();
+    CHECK_EQ(frame_count, 1);
+    CHECK_EQ(got_count, 3);
+    for (i = 0; i < 3; i++)
+    {
+        CHECK_EQ(got[i].button_id, i);
+        CHECK_EQ(got[i].event, PRESS_DOWN);
+    }
+
+    /* no room: the frame waits, backpressure is up, nothing overwritten */
+    for (i = 0; i < 3; i++)
+        level[i] = 1;
+    room = 0;
+    for (t = 0; t < 4 * SHORT_TICKS; t++)
+    {
+        level[3] = (t / 8) & 1;
+        tick(&s);
+    }
+    CHECK_EQ(line_len, 0);
+    CHECK(s.out_len > 0);
+    CHECK_EQ(s.frames, 2);
+    room = sizeof(line);
+    for (t = 0; t < 4 * EVSTREAM_BATCH_TICKS; t++)
+        tick(&s);
+    decode_line();
+    CHECK(frame_count >= 2);
+    for (i = 1; i < frame_count; i++)
+        CHECK_EQ((uint8_t)(frame_seq[i] - frame_seq[i - 1]), 1);
+    CHECK_EQ(frame_seq[0], 1);
+    for (i = 1; i < got_count; i++)
+        CHECK(got[i].timestamp >= got[i - 1].timestamp);
+    CHECK_EQ(s.count, 0);
+    CHECK_EQ(s.out_len, 0);
+}
+
+int main(void)
+{
+    test_codec();
+    test_pump();
+    return host_test_done("event_stream");
+}
@@ -0,0 +1,92 @@
+/*
+ * Flash controller model on core_emu time: SLOCK writes without the
+ * BYPASS unlock are reverted, the unmodified driver's program and erase
+ * calls take the BUSY latency in cycles and leave the controller locked
+ * with OP cleared, a read with OP selected programs nothing, and a
+ * protected sector stays intact.
+ */
+
+#include <wb32l003.h>
+#include "wb32l003_flash.h"
+#include "host_test.h"
+
+#define US(us)                  ((uint64_t)(us) * (CORE_EMU_HCLK / 1000000))
+#define PAGE                    0x9000
+
+static uint64_t elapsed(uint64_t since)
+{
+    return core_emu_cycles() - since;
+}
+
+int main(void)
+{
+    uint64_t at;
+
+    core_emu_reset();
+    flash_emu_init(NULL);
+
+    /* locked: SLOCK writes are counted and do not take, CR is not protected */
+    FLASH->CR = FLASH_CR_OP_0;
+    FLASH->SLOCK0 = 0xFFFFFFFF;
+    CHECK_EQ(FLASH->CR & FLASH_CR_OP, FLASH_CR_OP_0);
+    CHECK_EQ(FLASH->SLOCK0, 0);
+    CHECK_EQ(flash_emu_stats()->locked_writes, 1);
+    FLASH->CR = 0;
+
+    /* unlocked they do, until the lock sequence */
+    FLASH_Unlock();
+    FLASH->SLOCK1 = 0x1;
+    FLASH_Lock();
+    FLASH->SLOCK1 = 0;
+    CHECK_EQ(FLASH->SLOCK1, 0x1);
+    FLASH_Unlock();
+    FLASH->SLOCK1 = 0;
+    FLASH_Lock();
+    CHECK_EQ(FLASH->SLOCK1, 0);
+    CHECK_EQ(flash_emu_stats()->locked_writes, 2);
+
+    /* a word: the BUSY polls wait out the 20 us program time */
+    flash_emu_clear_stats();
+    at = core_emu_cycles();
+    CHECK_EQ(FLASH_ProgramWord(PAGE, 0xA5A5F00F), FLASH_COMPLETE);
+    CHECK(elapsed(at) >= US(20));
+    CHECK(elapsed(at) < US(20) + 200);
+    CHECK_EQ(*(uint32_t*)flash_emu_mem(PAGE), 0xA5A5F00F);
+    CHECK_EQ(M32(PAGE), 0xA5A5F00F);
+    CHECK_EQ(FLASH->CR & (FLASH_CR_OP | FLASH_CR_BUSY), 0);
+    CHECK_EQ(FLASH->SLOCK0 | FLASH->SLOCK1, 0);
+    CHECK_EQ(flash_emu_stats()->programs, 1);
+    CHECK_EQ(flash_emu_stats()->locked_writes, 0);
+
+    /* reads with OP selected program nothing */
+    FLASH->CR = FLASH_CR_OP_0;
+    CHECK_EQ(M32(PAGE), 0xA5A5F00F);
+    CHECK_EQ(M8(PAGE + 8), 0xFF);
+    FLASH->CR = 0;
+    CHECK_EQ(flash_emu_stats()->programs, 1);
+    CHECK_EQ(flash_emu_stats()->busy_faults, 0);
+
+    /* a page erase waits out BUSY without timing out */
+    at = core_emu_cycles();
+    CHECK_EQ(FLASH_ErasePage(PAGE), FLASH_COMPLETE);
+    CHECK(elapsed(at) >= US(4000));
+    CHECK_EQ(*(uint32_t*)flash_emu_mem(PAGE), 0xFFFFFFFF);
+    CHECK_EQ(flash_emu_erase_count(PAGE / FLASH_EMU_PAGE_SIZE), 1);
+    CHECK_EQ(flash_emu_stats()->busy_cycles, US(20) + US(4000));
+
+    /* a sector left locked: no program, counted */
+    FLASH_Unlock();
+    FLASH->CR = FLASH_CR_OP_0;
+    M32(PAGE) = 0;
+    FLASH->CR = 0;
+    FLASH_Lock();
+    CHECK_EQ(*(uint32_t*)flash_emu_mem(PAGE), 0xFFFFFFFF);
+    CHECK_EQ(flash_emu_stats()->protect_faults, 1);
+
+    /* the array survives a core reset */
+    CHECK_EQ(FLASH_ProgramWord(PAGE + 4, 0x1234), FLASH_COMPLETE);
+    core_emu_reset();
+    CHECK_EQ(M32(PAGE + 4), 0x1234);
+
+    return host_test_done("flash_emu");
+}
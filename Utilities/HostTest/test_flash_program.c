@@ -0,0 +1,103 @@
+/*
+ * FLASH_ProgramBuffer() on the flash emulator: a buffer across a sector
+ * boundary programs and leaves its sectors locked, with one BYPASS
+ * unlock per word and one SLOCK unlock and lock per sector, where
+ * FLASH_ProgramWord() takes five unlocks and four SLOCK writes a word.
+ * An interrupt handler programming a word between two buffer words
+ * (which locks every sector) does not lose the rest of the buffer, and
+ * a word that does not read back is reported.
+ */
+
+#include <string.h>
+#include <wb32l003.h>
+#include "wb32l003_flash.h"
+#include "host_test.h"
+
+#define BUF_ADDR                0x8F00  /* across the 0x9000 sector boundary */
+#define BUF_WORDS               128
+#define BUF_SECTORS             2
+#define ISR_ADDR                0xA000
+#define ISR_DATA                0x12345678UL
+
+static uint32_t data[BUF_WORDS];
+static FLASH_Status isr_status;
+static int isr_calls;
+
+void LVD_IRQHandler(void)
+{
+    isr_calls++;
+    isr_status = FLASH_ProgramWord(ISR_ADDR, ISR_DATA);
+}
+
+static void pend_lvd(void* arg)
+{
+    (void)arg;
+    NVIC_SetPendingIRQ(LVD_IRQn);
+}
+
+static int buffer_programmed(uint32_t addr)
+{
+    return memcmp(flash_emu_mem(addr), data, sizeof(data)) == 0;
+}
+
+static void setup(void)
+{
+    core_emu_reset();
+    flash_emu_init(NULL);
+    NVIC_EnableIRQ(LVD_IRQn);
+    isr_calls = 0;
+}
+
+int main(void)
+{
+    uint32_t seed = 0xF1A54;
+    uint32_t i;
+
+    for (i = 0; i < BUF_WORDS; i++)
+        data[i] = host_test_rand(&seed);
+
+    /* plain buffer, two sectors unlocked once and locked again */
+    setup();
+    CHECK_EQ(FLASH_ProgramBuffer(BUF_ADDR, data, BUF_WORDS), FLASH_COMPLETE);
+    CHECK(buffer_programmed(BUF_ADDR));
+    CHECK_EQ(flash_emu_stats()->programs, BUF_WORDS);
+    CHECK_EQ(flash_emu_stats()->protect_faults, 0);
+    CHECK_EQ(flash_emu_stats()->unlocks, BUF_WORDS + 2 * BUF_SECTORS);
+    CHECK_EQ(flash_emu_stats()->locks, BUF_WORDS + 2 * BUF_SECTORS);
+    CHECK_EQ(flash_emu_stats()->slock_changes, 2 * BUF_SECTORS);
+    CHECK_EQ(flash_emu_stats()->locked_writes, 0);
+    CHECK_EQ(FLASH->SLOCK0 | FLASH->SLOCK1, 0);
+    CHECK_EQ(FLASH->CR & FLASH_CR_OP, 0);
+
+    /* the same words one FLASH_ProgramWord() each */
+    setup();
+    for (i = 0; i < BUF_WORDS; i++)
+        CHECK_EQ(FLASH_ProgramWord(BUF_ADDR + 4 * i, data[i]), FLASH_COMPLETE);
+    CHECK(buffer_programmed(BUF_ADDR));
+    CHECK_EQ(flash_emu_stats()->unlocks, 5 * BUF_WORDS);
+    CHECK_EQ(flash_emu_stats()->locks, 5 * BUF_WORDS);
+    CHECK_EQ(flash_emu_stats()->slock_changes, 4 * BUF_WORDS);
+
+    /* a handler uses the single word API halfway through the buffer */
+    setup();
+    core_emu_at(core_emu_cycles() + 200, pend_lvd, 0);
+    CHECK_EQ(FLASH_ProgramBuffer(BUF_ADDR, data, BUF_WORDS), FLASH_COMPLETE);
+    CHECK_EQ(isr_calls, 1);
+    CHECK_EQ(isr_status, FLASH_COMPLETE);
+    CHECK_EQ(*(uint32_t*)flash_emu_mem(ISR_ADDR), ISR_DATA);
+    CHECK(buffer_programmed(BUF_ADDR));
+    CHECK_EQ(flash_emu_stats()->programs, BUF_WORDS + 1);
+    CHECK_EQ(FLASH->SLOCK0 | FLASH->SLOCK1, 0);
+    CHECK_EQ(FLASH->CR & FLASH_CR_OP, 0);
+
+    /* the handler's five unlocks, then each sector unlocked once more */
+    CHECK_EQ(flash_emu_stats()->unlocks, BUF_WORDS + 2 * BUF_SECTORS + 5 + BUF_SECTORS);
+    CHECK_EQ(flash_emu_stats()->slock_changes, 2 * BUF_SECTORS + 4 + BUF_SECTORS);
+
+    /* a word programmed over non erased bits does not read back */
+    setup();
+    CHECK_EQ(FLASH_ProgramWord(BUF_ADDR + 8, 0), FLASH_COMPLETE);
+    CHECK_EQ(FLASH_ProgramBuffer(BUF_ADDR, data, BUF_WORDS), FLASH_ERROR_ERPROT);
+
+    return host_test_done("flash_program");
+}
@@ -0,0 +1,195 @@
+/*
+ * kv_cache on kv_store and the flash emulator: updates coalesce, commits
+ * run from kv_cache_idle() on the dirty count, the delay timer and a
+ * request, and an interrupt handler never reaches the store: it fills a
+ * slot or gets an error, reads cached values only and turns a commit into
+ * a request. An update from a handler racing a commit is not lost.
+ */
+
+#include <string.h>
+#include <wb32l003.h>
+#include "kv_store.h"
+#include "kv_cache.h"
+#include "soft_timer.h"
+#include "host_test.h"
+
+#define STORED_KEY              100     /* in the store, not in the cache */
+
+static void (*isr_action)(void);
+static uint32_t isr_flash_ops;
+
+static uint32_t flash_ops(void)
+{
+    return flash_emu_stats()->programs + flash_emu_stats()->erases;
+}
+
+void LVD_IRQHandler(void)
+{
+    uint32_t before = flash_ops();
+
+    isr_action();
+    isr_flash_ops += flash_ops() - before;
+}
+
+static void pend_lvd(void* arg)
+{
+    (void)arg;
+    NVIC_SetPendingIRQ(LVD_IRQn);
+}
+
+/* Run the action in the LVD handler, cycles from now */
+static void in_isr(void (*action)(void), uint32_t cycles)
+{
+    isr_action = action;
+    core_emu_at(core_emu_cycles() + cycles, pend_lvd, 0);
+}
+
+static uint32_t value32(uint16_t key)
+{
+    uint32_t v = 0;
+
+    CHECK_EQ(kv_get(key, &v, sizeof(v)), sizeof(v));
+    return v;
+}
+
+static void setup(void)
+{
+    uint32_t v = 0x5709ED;
+
+    core_emu_reset();
+    flash_emu_init(NULL);
+    NVIC_EnableIRQ(LVD_IRQn);
+    isr_flash_ops = 0;
+    CHECK_EQ(kv_init(), 0);
+    CHECK_EQ(kv_set(STORED_KEY, &v, sizeof(v)), 0);
+    kv_cache_init();
+}
+
+/* the cache is full of dirty slots, keys 0 to KV_CACHE_SLOTS - 1 */
+static void fill(void)
+{
+    uint32_t v;
+
+    for (v = 0; v < KV_CACHE_SLOTS; v++)
+        CHECK_EQ(kv_cache_set((uint16_t)v, &v, sizeof(v)), 0);
+    CHECK_EQ(kv_cache_dirty(), KV_CACHE_SLOTS);
+}
+
+static int isr_results[6];
+
+static void isr_uses_cache(void)
+{
+    uint8_t large[KV_CACHE_VALUE_MAX + 1] = { 0 };
+    uint32_t v = 0xCAFE;
+
+    isr_results[0] = kv_cache_set(KV_CACHE_SLOTS, &v, sizeof(v));
+    isr_results[1] = kv_cache_set(2, &v, sizeof(v));
+    isr_results[2] = kv_cache_set(3, large, sizeof(large));
+    isr_results[3] = kv_cache_get(2, &v, sizeof(v));
+    isr_results[4] = kv_cache_get(STORED_KEY, &v, sizeof(v));
+    isr_results[5] = kv_cache_commit();
+}
+
+static void isr_updates_key0(void)
+{
+    uint32_t v = 0xAB;
+
+    isr_results[0] = kv_cache_set(0, &v, sizeof(v));
+}
+
+static void isr_requests(void)
+{
+    kv_cache_request();
+}
+
+int main(void)
+{
+    uint32_t v, i;
+
+    /* repeated updates of a key coalesce into one record */
+    setup();
+    for (v = 0; v < 100; v++)
+        CHECK_EQ(kv_cache_set(1, &v, sizeof(v)), 0);
+    CHECK_EQ(kv_cache_stats()->coalesced, 99);
+    CHECK_EQ(kv_cache_get(1, &v, sizeof(v)), sizeof(v));
+    CHECK_EQ(v, 99);
+    CHECK_EQ(kv_get(1, &v, sizeof(v)), KV_ERR_NOKEY);
+    CHECK_EQ(kv_cache_commit(), 0);
+    CHECK_EQ(kv_cache_stats()->writes, 1);
+    CHECK_EQ(value32(1), 99);
+
+    /* KV_CACHE_MAX_DIRTY dirty slots make a commit due */
+    setup();
+    for (v = 0; v < KV_CACHE_MAX_DIRTY - 1; v++)
+        CHECK_EQ(kv_cache_set((uint16_t)v, &v, sizeof(v)), 0);
+    kv_cache_idle();
+    CHECK_EQ(kv_cache_stats()->commits, 0);
+    CHECK_EQ(kv_cache_set((uint16_t)v, &v, sizeof(v)), 0);
+    kv_cache_idle();
+    CHECK_EQ(kv_cache_stats()->commits, 1);
+    CHECK_EQ(kv_cache_dirty(), 0);
+
+    /* one dirty slot waits for the delay timer */
+    setup();
+    v = 7;
+    CHECK_EQ(kv_cache_set(7, &v, sizeof(v)), 0);
+    for (i = 1; i < KV_CACHE_DELAY; i++)
+        soft_timer_ticks();
+    kv_cache_idle();
+    CHECK_EQ(kv_cache_dirty(), 1);
+    soft_timer_ticks();
+    kv_cache_idle();
+    CHECK_EQ(kv_cache_dirty(), 0);
+    CHECK_EQ(value32(7), 7);
+
+    /* a handler fills slots and reads the cache, it never reaches the store */
+    setup();
+    fill();
+    in_isr(isr_uses_cache, 10);
+    core_emu_run(100);
+    CHECK_EQ(isr_results[0], KV_ERR_FULL);
+    CHECK_EQ(isr_results[1], 0);
+    CHECK_EQ(isr_results[2], KV_ERR_PARAM);
+    CHECK_EQ(isr_results[3], sizeof(v));
+    CHECK_EQ(isr_results[4], KV_ERR_NOKEY);
+    CHECK_EQ(isr_results[5], 0);
+    CHECK_EQ(isr_flash_ops, 0);
+    CHECK_EQ(kv_cache_stats()->commits, 0);
+    CHECK_EQ(kv_get(KV_CACHE_SLOTS, &v, sizeof(v)), KV_ERR_NOKEY);
+
+    /* the same from the thread: the new key and the large value go through */
+    v = 0xCAFE;
+    CHECK_EQ(kv_cache_set(KV_CACHE_SLOTS, &v, sizeof(v)), 0);
+    CHECK_EQ(value32(KV_CACHE_SLOTS), 0xCAFE);
+    kv_cache_idle();
+    CHECK_EQ(kv_cache_stats()->commits, 1);
+    CHECK_EQ(value32(2), 0xCAFE);
+    CHECK_EQ(kv_cache_get(STORED_KEY, &v, sizeof(v)), sizeof(v));
+    CHECK_EQ(v, 0x5709ED);
+
+    /* a handler update landing in the middle of a commit stays dirty */
+    setup();
+    fill();
+    in_isr(isr_updates_key0, 2000);
+    CHECK_EQ(kv_cache_commit(), 0);
+    CHECK_EQ(isr_results[0], 0);
+    CHECK_EQ(isr_flash_ops, 0);
+    CHECK_EQ(value32(0), 0);
+    CHECK_EQ(kv_cache_dirty(), 1);
+    CHECK_EQ(kv_cache_commit(), 0);
+    CHECK_EQ(value32(0), 0xAB);
+    CHECK_EQ(kv_cache_dirty(), 0);
+
+    /* a low-voltage handler asks, the idle loop commits */
+    setup();
+    v = 3;
+    CHECK_EQ(kv_cache_set(3, &v, sizeof(v)), 0);
+    in_isr(isr_requests, 10);
+    core_emu_run(100);
+    CHECK_EQ(kv_cache_dirty(), 1);
+    kv_cache_idle();
+    CHECK_EQ(kv_cache_dirty(), 0);
+    CHECK_EQ(value32(3), 3);
+
+    return host_test_done("kv_cache");
+}
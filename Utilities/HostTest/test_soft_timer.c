@@ -0,0 +1,174 @@
+/*
+ * soft_timer against a reference: random timers started and stopped in
+ * and out of the callbacks expire on their ticks, one shots once, in
+ * deadline order. start/stop/ticks keep the caller's PRIMASK, the
+ * callbacks run with it. soft_timer_advance() over missed ticks expires
+ * what came due in them, a repeating timer once per period.
+ */
+
+#include <wb32l003.h>
+#include "soft_timer.h"
+#include "host_test.h"
+
+#define TICKS                   20000
+
+typedef struct {
+    uint32_t due;               /* reference deadline, 0: disarmed */
+    uint32_t fired;
+} Ref;
+
+static SoftTimer timers[SOFT_TIMER_MAX];
+static Ref ref[SOFT_TIMER_MAX];
+static uint32_t seed = 0x5EED;
+static int late, early, order, masked_cb;
+static uint32_t last_due;
+
+static void expired(void)
+{
+    SoftTimer* t = soft_timer_current();
+    int i = (int)(t - timers);
+
+    if (__get_PRIMASK())
+        masked_cb++;
+    if (ref[i].due < soft_timer_now())
+        late++;
+    else if (ref[i].due > soft_timer_now())
+        early++;
+    if (ref[i].due < last_due)
+        order++;
+    last_due = ref[i].due;
+    ref[i].fired++;
+    ref[i].due = t->repeat ? ref[i].due + t->repeat : 0;
+
+    /* a callback restarting another timer */
+    if ((host_test_rand(&seed) & 7) == 0)
+    {
+        int j = (int)(host_test_rand(&seed) % SOFT_TIMER_MAX);
+
+        soft_timer_stop(&timers[j]);
+        if (soft_timer_start(&timers[j]) == 0)
+            ref[j].due = soft_timer_now() + timers[j].timeout;
+    }
+}
+
+static void test_against_reference(void)
+{
+    uint32_t tick;
+    int i;
+
+    for (i = 0; i < SOFT_TIMER_MAX; i++)
+        soft_timer_init(&timers[i], expired, 1 + host_test_rand(&seed) % 60,
+                        (i & 1) ? 1 + host_test_rand(&seed) % 40 : 0);
+
+    for (tick = 0; tick < TICKS; tick++)
+    {
+        int j = (int)(host_test_rand(&seed) % SOFT_TIMER_MAX);
+
+        if (host_test_rand(&seed) & 1)
+        {
+            if (soft_timer_start(&timers[j]) == 0)
+                ref[j].due = soft_timer_now() + timers[j].timeout;
+        }
+        else if ((host_test_rand(&seed) & 3) == 0)
+        {
+            soft_timer_stop(&timers[j]);
+            ref[j].due = 0;
+        }
+        last_due = 0;
+        soft_timer_ticks();
+
+        for (i = 0; i < SOFT_TIMER_MAX; i++)
+        {
+            if (ref[i].due && ref[i].due <= soft_timer_now())
+                late++;
+            CHECK_EQ(ref[i].due != 0, timers[i].heap_index != SOFT_TIMER_IDLE);
+        }
+    }
+
+    CHECK_EQ(late, 0);
+    CHECK_EQ(early, 0);
+    CHECK_EQ(order, 0);
+    CHECK_EQ(masked_cb, 0);
+    for (i = 0; i < SOFT_TIMER_MAX; i++)
+        CHECK(ref[i].fired > 0);
+}
+
+static void test_primask(void)
+{
+    SoftTimer t, extra;
+    int i;
+
+    for (i = 0; i < SOFT_TIMER_MAX; i++)
+        soft_timer_stop(&timers[i]);
+    soft_timer_init(&t, expired, 5, 0);
+
+    __disable_irq();
+    CHECK_EQ(soft_timer_start(&t), 0);
+    CHECK_EQ(__get_PRIMASK(), 1);
+    soft_timer_stop(&t);
+    CHECK_EQ(__get_PRIMASK(), 1);
+    soft_timer_ticks();
+    CHECK_EQ(__get_PRIMASK(), 1);
+    __enable_irq();
+
+    CHECK_EQ(soft_timer_start(&t), 0);
+    CHECK_EQ(soft_timer_start(&t), -1);
+    CHECK_EQ(__get_PRIMASK(), 0);
+    CHECK_EQ(soft_timer_next(), 5);
+    soft_timer_stop(&t);
+    CHECK_EQ(soft_timer_next(), 0xFFFFFFFF);
+    CHECK_EQ(__get_PRIMASK(), 0);
+
+    /* a full heap refuses the next timer */
+    for (i = 0; i < SOFT_TIMER_MAX; i++)
+        CHECK_EQ(soft_timer_start(&timers[i]), 0);
+    soft_timer_init(&extra, expired, 1, 0);
+    CHECK_EQ(soft_timer_start(&extra), -1);
+    CHECK_EQ(__get_PRIMASK(), 0);
+}
+
+static uint32_t advanced;
+
+static void count_expiry(void)
+{
+    advanced++;
+}
+
+static void test_advance(void)
+{
+    SoftTimer once, every;
+    uint32_t now;
+    int i;
+
+    for (i = 0; i < SOFT_TIMER_MAX; i++)
+        soft_timer_stop(&timers[i]);
+    soft_timer_init(&once, count_expiry, 100, 0);
+    soft_timer_init(&every, count_expiry, 30, 30);
+    now = soft_timer_now();
+    CHECK_EQ(soft_timer_start(&once), 0);
+    CHECK_EQ(soft_timer_start(&every), 0);
+
+    /* up to the tick before the first deadline: nothing */
+    soft_timer_advance(29);
+    soft_timer_advance(0);
+    CHECK_EQ(soft_timer_now() - now, 29);
+    CHECK_EQ(advanced, 0);
+    CHECK_EQ(soft_timer_next(), 1);
+
+    /* to 100: the one shot and the repeats at 30, 60 and 90 */
+    soft_timer_advance(71);
+    CHECK_EQ(soft_timer_now() - now, 100);
+    CHECK_EQ(advanced, 4);
+    CHECK_EQ(once.heap_index, SOFT_TIMER_IDLE);
+    CHECK_EQ(soft_timer_next(), 20);
+    soft_timer_stop(&every);
+}
+
+int main(void)
+{
+    core_emu_reset();
+    test_against_reference();
+    test_primask();
+    test_advance();
+    return host_test_done("soft_timer");
+}
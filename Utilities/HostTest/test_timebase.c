@@ -0,0 +1,92 @@
+/*
+ * Timebase delays against the BASETIM model: accurate to the counter
+ * clock with interrupts running, with PRIMASK set and inside the
+ * timebase interrupt, where the ms count stands still.
+ */
+
+#include <unistd.h>
+#include <wb32l003.h>
+#include "bsp_timebase.h"
+#include "host_test.h"
+
+#define US(us)                  ((uint64_t)(us) * (CORE_EMU_HCLK / 1000000))
+/* the poll loop: two CNT reads per pass */
+#define SLACK                   US(2)
+
+static uint64_t isr_delay_cycles;
+static int isr_calls;
+static int delay_id;
+
+static uint64_t delay_us(uint32_t us)
+{
+    uint64_t at = core_emu_cycles();
+
+    Timebase_DelayUs(us);
+    return core_emu_cycles() - at;
+}
+
+static void delay_in_isr(void)
+{
+    uint64_t at = core_emu_cycles();
+
+    isr_calls++;
+    Timebase_DelayMs(3);
+    isr_delay_cycles = core_emu_cycles() - at;
+    Timebase_SetPeriod(delay_id, 0);
+}
+
+static void setup(void)
+{
+    core_emu_reset();
+    SystemInit();
+    Timebase_Init();
+}
+
+static void test_delay_running(void)
+{
+    static const uint32_t us[] = { 1, 7, 250, 999, 1000, 1001, 2500, 40000 };
+    uint32_t i;
+
+    setup();
+    for (i = 0; i < sizeof(us) / sizeof(us[0]); i++)
+    {
+        uint64_t took = delay_us(us[i]);
+        CHECK(took >= US(us[i]) && took <= US(us[i]) + SLACK);
+    }
+}
+
+/* 2 ms and more with the overflow unserved: the ms count never moves */
+static void test_delay_masked(void)
+{
+    uint32_t ms;
+    uint64_t took;
+
+    setup();
+    ms = Timebase_GetMs();
+    __disable_irq();
+    took = delay_us(5000);
+    CHECK(took >= US(5000) && took <= US(5000) + SLACK);
+    took = delay_us(123456);
+    CHECK(took >= US(123456) && took <= US(123456) + SLACK);
+    CHECK_EQ(Timebase_GetMs(), ms);
+    __enable_irq();
+}
+
+static void test_delay_in_isr(void)
+{
+    setup();
+    delay_id = Timebase_AddPeriodic(delay_in_isr, 2);
+    core_emu_run(US(10000));
+    CHECK_EQ(isr_calls, 1);
+    CHECK(isr_delay_cycles >= US(3000) && isr_delay_cycles <= US(3000) + 3 * SLACK);
+}
+
+int main(void)
+{
+    /* a delay that never ends fails the run */
+    alarm(10);
+    test_delay_running();
+    test_delay_masked();
+    test_delay_in_isr();
+    return host_test_done("timebase");
+}
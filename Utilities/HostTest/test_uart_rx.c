@@ -0,0 +1,175 @@
+/*
+ * bsp_uart_rx on the UART1 model, with the line on a pseudo terminal:
+ * the test writes COBS requests to the slave side in raw mode, as a PC
+ * tool writes to /dev/ttyUSB0, and a bridge moves the master side bytes
+ * onto the model's RX line and the model's TX bytes back. The firmware
+ * side drains the ring into the decoder and answers each frame from the
+ * TI interrupt through UartRx_SetTxDone(), TI is cleared by the module's
+ * handler or its IRQ line would never drop.
+ *
+ * Also: no overruns at 115200 baud with the ring polled every 8 bytes,
+ * an overrun counted when it is not, and garbage between frames.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wb32l003.h>
+#include "bsp_uart_rx.h"
+#include "cobs.h"
+#include "host_test.h"
+#include <termios.h>    /* after the device header, its CR0.. macros clash with register names */
+
+#define FRAME_MAX               200
+#define FRAMES                  200
+
+static int master, slave;
+
+/* the firmware side: decoder and the reply sent from the TI interrupt */
+static CobsDecoder dec;
+static uint8_t frame_buf[FRAME_MAX];
+static uint8_t reply[COBS_MAX_ENCODED(FRAME_MAX)];
+static uint16_t reply_len, reply_pos;
+static uint32_t frames_in;
+
+static void tx_done(void* arg)
+{
+    (void)arg;
+    if (reply_pos < reply_len)
+        UART_WriteData(UART1, reply[reply_pos++]);
+    else
+        UART_ITConfig(UART1, UART_IT_TI, DISABLE);
+}
+
+/* The reply is the frame with every byte complemented */
+static void on_frame(const uint8_t* frame, uint16_t len, void* arg)
+{
+    uint8_t out[FRAME_MAX];
+    uint16_t i;
+
+    (void)arg;
+    frames_in++;
+    for (i = 0; i < len; i++)
+        out[i] = (uint8_t)~frame[i];
+    reply_len = cobs_encode(out, len, reply);
+    reply_pos = 1;
+    UART_ITConfig(UART1, UART_IT_TI, ENABLE);
+    UART_WriteData(UART1, reply[0]);
+}
+
+/* The line for a while: bytes from the pty to the model and back */
+static void bridge(uint32_t bytes, int poll)
+{
+    uint8_t buf[256];
+    uint32_t i;
+    ssize_t n;
+
+    for (i = 0; i < bytes; i += 8)
+    {
+        n = read(master, buf, sizeof(buf));
+        if (n > 0)
+            uart_emu_rx(UART1_BASE, buf, (uint32_t)n);
+        core_emu_run(8 * uart_emu_byte_cycles(UART1_BASE));
+        if (poll)
+            UartRx_Poll(UART_RX_UART1, &dec);
+        n = uart_emu_tx(UART1_BASE, buf, sizeof(buf));
+        if (n > 0)
+            CHECK_EQ(write(master, buf, (size_t)n), n);
+    }
+}
+
+/* What the PC side reads back, decoded */
+static uint8_t answer[FRAME_MAX];
+static uint16_t answer_len;
+static uint32_t answers;
+
+static void on_answer(const uint8_t* frame, uint16_t len, void* arg)
+{
+    (void)arg;
+    memcpy(answer, frame, len);
+    answer_len = len;
+    answers++;
+}
+
+static void open_pty(void)
+{
+    struct termios tio;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    CHECK(master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0);
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    CHECK(slave >= 0);
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, O_NONBLOCK);
+    fcntl(slave, F_SETFL, O_NONBLOCK);
+}
+
+int main(void)
+{
+    static uint8_t frame[FRAME_MAX], wire[COBS_MAX_ENCODED(FRAME_MAX)];
+    UART_InitTypeDef UART_InitStruct;
+    CobsDecoder pc;
+    uint8_t pc_buf[FRAME_MAX], buf[256];
+    uint32_t seed = 0x7E1E, i, j;
+    ssize_t n;
+
+    open_pty();
+    core_emu_reset();
+    SystemInit();
+    RCC_APBPeriphClockCmd(RCC_APBPeriph_UART1, ENABLE);
+    UART_StructInit(&UART_InitStruct);
+    UART_Init(UART1, &UART_InitStruct);
+    UART_Cmd(UART1, ENABLE);
+
+    cobs_decoder_init(&dec, frame_buf, sizeof(frame_buf), on_frame, 0);
+    cobs_decoder_init(&pc, pc_buf, sizeof(pc_buf), on_answer, 0);
+    UartRx_Init(UART_RX_UART1);
+    UartRx_SetTxDone(UART_RX_UART1, tx_done, 0);
+
+    /* request and answer over the pty, garbage in front now and then */
+    for (i = 0; i < FRAMES && !host_test_failures; i++)
+    {
+        uint32_t r = host_test_rand(&seed);
+        uint16_t len = 1 + r % (FRAME_MAX - 1), wlen;
+        uint32_t before = answers;
+
+        for (j = 0; j < len; j++)
+            frame[j] = (r >> 12) & 1 ? (uint8_t)host_test_rand(&seed) : (uint8_t)(j & 3);
+        wlen = cobs_encode(frame, len, wire);
+        if ((r >> 20) % 8 == 0)
+            CHECK_EQ(write(slave, "\x05garbage", 9), 9);
+        CHECK_EQ(write(slave, wire, wlen), wlen);
+
+        /* the request in, the answer out, with some slack */
+        bridge(2 * (wlen + 8) + 16, 1);
+        while ((n = read(slave, buf, sizeof(buf))) > 0)
+        {
+            for (j = 0; j < (uint32_t)n; j++)
+                cobs_decode_byte(&pc, buf[j]);
+        }
+        CHECK_EQ(answers, before + 1);
+        CHECK_EQ(answer_len, len);
+        for (j = 0; j < len; j++)
+            CHECK_EQ(answer[j], (uint8_t)~frame[j]);
+    }
+    CHECK_EQ(frames_in, FRAMES);
+    CHECK_EQ(UartRx_Overruns(UART_RX_UART1), 0);
+    CHECK_EQ(uart_emu_rx_lost(UART1_BASE), 0);
+    CHECK_EQ(pc.errors, 0);
+
+    /* a frame longer than the ring, nobody draining: the ring overruns */
+    memset(frame, 0x5A, UART_RX_RING_SIZE * 2);
+    CHECK_EQ(write(slave, frame, UART_RX_RING_SIZE * 2), UART_RX_RING_SIZE * 2);
+    bridge(UART_RX_RING_SIZE * 2 + 8, 0);
+    CHECK_EQ(UartRx_Available(UART_RX_UART1), UART_RX_RING_SIZE - 1);
+    CHECK_EQ(UartRx_Overruns(UART_RX_UART1), UART_RX_RING_SIZE + 1);
+    CHECK_EQ(uart_emu_rx_lost(UART1_BASE), 0);
+
+    close(slave);
+    close(master);
+    return host_test_done("uart_rx");
+}
@@ -0,0 +1,218 @@
+/*
+ * Host decoder of the binlog stream, see Utilities/Common/binlog.h.
+ *
+ *   gcc -o binlog_decode Utilities/HostTools/binlog_decode.c
+ *   stty -F /dev/ttyUSB0 115200 raw
+ *   ./binlog_decode Objects/MultiButton.axf /dev/ttyUSB0
+ *
+ * The format strings are looked up by address in the .binlog_fmt section
+ * of the ELF image, the stream is read from a file, a tty or stdin. An
+ * image whose section leaves its 64 KB window or starts at offset 0 of it
+ * is refused, its records would decode to the wrong strings.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BINLOG_SYNC             0xB1
+#define BINLOG_DROPPED          0x0000
+#define BINLOG_WINDOW           0x10000
+#define FMT_SECTION             ".binlog_fmt"
+
+static uint8_t* fmt_data;
+static uint32_t fmt_addr;
+static uint32_t fmt_size;
+
+static uint32_t rd16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t rd32(const uint8_t* p) { return rd16(p) | (rd16(p + 2) << 16); }
+
+/* Load the format section of a little endian ELF32 image */
+static int load_elf(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    uint8_t* elf;
+    long size;
+    uint32_t shoff, shentsize, shnum, shstrndx, strtab, i;
+
+    if (!f)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    elf = malloc(size);
+    if (!elf || fread(elf, 1, size, f) != (size_t)size)
+    {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    if (size < 52 || memcmp(elf, "\177ELF", 4) != 0 || elf[4] != 1 || elf[5] != 1)
+        return -1;
+
+    shoff = rd32(elf + 32);
+    shentsize = rd16(elf + 46);
+    shnum = rd16(elf + 48);
+    shstrndx = rd16(elf + 50);
+    if (shoff + shnum * shentsize > (uint32_t)size)
+        return -1;
+    strtab = rd32(elf + shoff + shstrndx * shentsize + 16);
+
+    for (i = 0; i < shnum; i++)
+    {
+        const uint8_t* sh = elf + shoff + i * shentsize;
+        if (strcmp((const char*)elf + strtab + rd32(sh), FMT_SECTION) == 0)
+        {
+            fmt_addr = rd32(sh + 12);
+            fmt_size = rd32(sh + 20);
+            fmt_data = elf + rd32(sh + 16);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Records carry the low 16 bits of a string address: the section must lie
+ * in one window, and a string at offset 0 would read as BINLOG_DROPPED.
+ */
+static int fmt_in_window(void)
+{
+    uint32_t start = fmt_addr & (BINLOG_WINDOW - 1);
+
+    return start != BINLOG_DROPPED && start + fmt_size <= BINLOG_WINDOW;
+}
+
+static const char* find_format(uint32_t addr16)
+{
+    uint32_t offset = (addr16 - fmt_addr) & (BINLOG_WINDOW - 1);
+
+    return offset < fmt_size ? (const char*)fmt_data + offset : NULL;
+}
+
+/* printf with 32 bit integer arguments, one conversion at a time */
+static void print_record(const char* fmt, const uint32_t* args, uint32_t nargs)
+{
+    char spec[32];
+
+    while (*fmt)
+    {
+        size_t n;
+
+        if (*fmt != '%')
+        {
+            putchar(*fmt++);
+            continue;
+        }
+        if (fmt[1] == '%')
+        {
+            putchar('%');
+            fmt += 2;
+            continue;
+        }
+
+        /* flags, width, precision and length up to the conversion */
+        n = strspn(fmt + 1, "-+ #0123456789.hlz") + 1;
+        if (!fmt[n] || n + 2 > sizeof(spec))
+            break;
+        memcpy(spec, fmt, n);
+        /* drop the length modifiers, every argument is 32 bit */
+        while (n > 1 && strchr("hlz", spec[n - 1]))
+            n--;
+        spec[n] = fmt[n + (strspn(fmt + n, "hlz"))];
+        spec[n + 1] = '\0';
+        fmt += n + strspn(fmt + n, "hlz") + 1;
+
+        if (!nargs)
+        {
+            fputs("<?>", stdout);
+            continue;
+        }
+        nargs--;
+        switch (spec[n])
+        {
+        case 'd': case 'i':
+            printf(spec, (int32_t)*args++);
+            break;
+        case 'u': case 'x': case 'X': case 'o': case 'c':
+            printf(spec, *args++);
+            break;
+        case 'p':
+            printf("0x%08x", *args++);
+            break;
+        default:
+            printf("<%%%c:%08x>", spec[n], *args++);
+            break;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    FILE* in = stdin;
+    uint8_t win[4];
+    uint32_t have = 0;
+
+    if (argc < 2 || load_elf(argv[1]) != 0)
+    {
+        fprintf(stderr, "usage: %s image.axf [stream]\n  no %s section found\n", argv[0], FMT_SECTION);
+        return 1;
+    }
+    if (!fmt_in_window())
+    {
+        fprintf(stderr, "%s: %s at 0x%08x, %u bytes, is not inside a 64 KB window above its offset 0\n",
+                argv[1], FMT_SECTION, fmt_addr, fmt_size);
+        return 1;
+    }
+    if (argc > 2 && !(in = fopen(argv[2], "rb")))
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    while (1)
+    {
+        uint32_t header, nargs, args[4], i;
+        const char* fmt;
+        int c;
+
+        /* slide byte by byte until a header word lines up */
+        while (have < 4)
+        {
+            if ((c = fgetc(in)) == EOF)
+                return 0;
+            win[have++] = (uint8_t)c;
+        }
+        header = rd32(win);
+        nargs = (header >> 16) & 0xFF;
+        if ((header >> 24) != BINLOG_SYNC || nargs > 4)
+        {
+            memmove(win, win + 1, 3);
+            have = 3;
+            continue;
+        }
+        have = 0;
+
+        for (i = 0; i < nargs; i++)
+        {
+            uint8_t word[4];
+            if (fread(word, 1, 4, in) != 4)
+                return 0;
+            args[i] = rd32(word);
+        }
+
+        if ((header & 0xFFFF) == BINLOG_DROPPED && nargs == 1)
+        {
+            printf("<%u records dropped>\n", args[0]);
+            continue;
+        }
+        fmt = find_format(header & 0xFFFF);
+        if (fmt)
+            print_record(fmt, args, nargs);
+        else
+            printf("<unknown site 0x%04x>\n", header & 0xFFFF);
+        fflush(stdout);
+    }
+}
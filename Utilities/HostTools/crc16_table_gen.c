@@ -0,0 +1,103 @@
+/*
+ * Generator of Utilities/Common/crc16_soft_table.h, the slicing tables
+ * and carry-less multiply fold constants of crc16_soft.c:
+ *
+ *   gcc -o crc16_table_gen Utilities/HostTools/crc16_table_gen.c
+ *   ./crc16_table_gen > Utilities/Common/crc16_soft_table.h
+ *
+ * Everything is derived from the bit at a time shift register, the same
+ * one as crc16_soft_bitwise(), so a change of polynomial is one define.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define POLY                    0x1021  /* normal form, 0x8408 reflected */
+#define SLICES                  8
+
+static uint16_t table[SLICES][256];
+
+static uint16_t reflect16(uint16_t v)
+{
+    uint16_t r = 0;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        r |= ((v >> i) & 1) << (15 - i);
+    return r;
+}
+
+/* One byte through the reflected register, seed 0 */
+static uint16_t byte_crc(uint8_t byte)
+{
+    uint16_t crc = byte;
+    int bit;
+
+    for (bit = 0; bit < 8; bit++)
+        crc = (crc & 1) ? (crc >> 1) ^ reflect16(POLY) : crc >> 1;
+    return crc;
+}
+
+/* x^n mod P, normal form */
+static uint16_t xpow_mod(uint32_t n)
+{
+    uint16_t r = 1;
+
+    while (n--)
+        r = (r & 0x8000) ? (uint16_t)(r << 1) ^ POLY : (uint16_t)(r << 1);
+    return r;
+}
+
+/*
+ * Fold constant for a reflected 64 bit lane: coefficient d at bit 63 - d,
+ * one power short to absorb the bit the reflected product is shifted by.
+ */
+static uint64_t fold_k(uint32_t n)
+{
+    return (uint64_t)reflect16(xpow_mod(n - 1)) << 48;
+}
+
+static void fold_pair(uint32_t bits)
+{
+    printf("#define CRC16_SOFT_K%u_HI      0x%016llXULL  /* x^%u mod P */\n",
+           bits, (unsigned long long)fold_k(bits + 64), bits + 63);
+    printf("#define CRC16_SOFT_K%u_LO      0x%016llXULL  /* x^%u mod P */\n",
+           bits, (unsigned long long)fold_k(bits), bits - 1);
+}
+
+int main(void)
+{
+    int k, n;
+
+    for (n = 0; n < 256; n++)
+        table[0][n] = byte_crc((uint8_t)n);
+    for (k = 1; k < SLICES; k++)
+    {
+        for (n = 0; n < 256; n++)
+            table[k][n] = (table[k - 1][n] >> 8) ^ table[0][table[k - 1][n] & 0xFF];
+    }
+
+    printf("/*\n"
+           " * Generated by Utilities/HostTools/crc16_table_gen.c, do not edit.\n"
+           " *\n"
+           " * Row k of crc_table is the CRC of byte n followed by k zero bytes,\n"
+           " * seed 0. The fold constants are for the carry-less multiply path.\n"
+           " */\n\n"
+           "#ifndef __CRC16_SOFT_TABLE_H\n"
+           "#define __CRC16_SOFT_TABLE_H\n\n");
+    fold_pair(128);
+    fold_pair(512);
+
+    printf("\nstatic const uint16_t crc_table[CRC16_SOFT_SLICES][256] = {\n");
+    for (k = 0; k < SLICES; k++)
+    {
+        if (k == 1)
+            printf("#if CRC16_SOFT_SLICES == 8\n");
+        printf("{\n");
+        for (n = 0; n < 256; n++)
+            printf("%s0x%04X,%s", n % 8 ? " " : "    ", table[k][n], n % 8 == 7 ? "\n" : "");
+        printf("},\n");
+    }
+    printf("#endif\n};\n\n#endif\n");
+    return 0;
+}
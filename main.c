@@ -1,12 +1,22 @@
 /* Includes ------------------------------------------------------------------*/
 #include "wb32l003.h"
 #include "bsp_lpuart1.h"
+#include "bsp_button_tick.h"
+#include "bsp_button_sleep.h"
+#include "bsp_timebase.h"
+#include "soft_timer.h"
+#include "scheduler.h"
+#include "button_await.h"
 #include "multi_button.h"
 
 #define POLLING     1
 #define CALLBACK    2
+#define SCHEDULER   3
 #define METHOD      (CALLBACK)
 
+//CALLBACK方式下, 按键全部空闲时进入DEEPSLEEP, 由按键边沿唤醒
+#define DEEPSLEEP_ENABLE    1
+
 //控制按键
 #define BTN1_PORT       GPIOD
 #define BTN1_PIN        GPIO_Pin_3
@@ -23,15 +33,23 @@
 #define LED3_TOGGLE     GPIO_ToggleBits(  LED3_PORT, LED3_PIN)
 
 
-const uint8_t btn1_id = 0;
+const uint16_t btn1_id = 0;
 struct Button btn1;
 uint8_t btn_state = 0;
 
+//长按分级: 1s / 3s / 10s
+const uint16_t btn1_long_stages[] = {
+    1000 / TICKS_INTERVAL,
+    3000 / TICKS_INTERVAL,
+    10000 / TICKS_INTERVAL,
+};
+
 void BTN1_SINGLE_Click_Handler(void* btn);
 void BTN1_DOUBLE_Click_Handler(void* btn);
 void BTN1_LONG_PRESS_HOLD_Handler(void* btn);
+void BTN1_LONG_PRESS_STAGE_Handler(void* btn);
 
-uint8_t read_button_GPIO(uint8_t button_id)
+uint8_t read_button_GPIO(uint16_t button_id)
 {
 	/* you can share the GPIO read function with multiple Buttons */
 	switch(button_id)
@@ -44,14 +62,12 @@ uint8_t read_button_GPIO(uint8_t button_id)
 	}
 }
 
-void ButtonTicks_Init(void)
-{   
-    // Configure SysTick to run at 200Hz
-    if(SysTick_Config(SystemCoreClock/200))
-    {
-        while(1);
-    }
-}
+#if (DEEPSLEEP_ENABLE)
+//按键按下的电平边沿唤醒DEEPSLEEP
+const ButtonWakePin btn_wake_pins[] = {
+    { BTN1_PORT, BTN1_PIN, 0, GPIOD_IRQn },
+};
+#endif
 
 #if (METHOD == POLLING)
 int main()
@@ -70,10 +86,12 @@ int main()
 
 	/* 
      * make the timer invoking the button_ticks() interval 5ms.
-	 * This function is implemented by yourself.
+	 * The soft timers run on the 1ms timebase, ButtonTick_Init() starts
+	 * a TICKS_INTERVAL soft timer invoking button_ticks().
     */
-	// __timer_start(button_ticks, 0, 5);
-    ButtonTicks_Init();
+    Timebase_Init();
+    Timebase_AddPeriodic(soft_timer_ticks, 1);
+    ButtonTick_Init();
 
 	while(1)
 	{
@@ -108,18 +126,138 @@ int main()
 	button_attach(&btn1, SINGLE_CLICK,     BTN1_SINGLE_Click_Handler);
 	button_attach(&btn1, DOUBLE_CLICK,     BTN1_DOUBLE_Click_Handler);
 	button_attach(&btn1, LONG_PRESS_HOLD,  BTN1_LONG_PRESS_HOLD_Handler);
+	button_attach(&btn1, LONG_PRESS_STAGE, BTN1_LONG_PRESS_STAGE_Handler);
+	button_set_long_stages(&btn1, btn1_long_stages, sizeof(btn1_long_stages) / sizeof(btn1_long_stages[0]));
 
 	button_start(&btn1);
 
 	/* 
      * make the timer invoking the button_ticks() interval 5ms.
-	 * This function is implemented by yourself.
+	 * The soft timers run on the 1ms timebase, ButtonTick_Init() starts
+	 * a TICKS_INTERVAL soft timer invoking button_ticks().
     */
-	// __timer_start(button_ticks, 0, 5);
-    ButtonTicks_Init();
+    Timebase_Init();
+    Timebase_AddPeriodic(soft_timer_ticks, 1);
+    ButtonTick_Init();
+#if (DEEPSLEEP_ENABLE)
+    ButtonSleep_Init(btn_wake_pins, sizeof(btn_wake_pins) / sizeof(btn_wake_pins[0]));
+#endif
 
 	while(1)
-	{}
+	{
+#if (DEEPSLEEP_ENABLE)
+        ButtonSleep_Enter();
+#endif
+    }
+}
+#elif (METHOD == SCHEDULER)
+SchedTask btn_task;
+
+// 按键事件在中断中投递任务, 任务中批量处理事件
+void Button_Post_Handler(void* task, const ButtonEvent* ev)
+{
+    sched_post((SchedTask*)task);
+}
+
+void Button_Task(void* arg)
+{
+    ButtonEvent events[EVENT_QUEUE_SIZE];
+    uint16_t i, n;
+
+    n = button_poll_events(events, EVENT_QUEUE_SIZE, 0);
+    for(i = 0; i < n; i++)
+    {
+        switch(events[i].event)
+        {
+            case SINGLE_CLICK:
+                LED1_TOGGLE;
+                break;
+            case DOUBLE_CLICK:
+                LED2_TOGGLE;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+SchedTask load_task;
+SoftTimer load_timer;
+uint8_t cpu_load = 0;   // 0~100, busy share of the last second
+
+void Load_Post_Handler(void)
+{
+    sched_post(&load_task);
+}
+
+// 定时器到期任务: 每秒统计CPU负载
+void Load_Task(void* arg)
+{
+    static uint32_t last_us = 0, last_idle = 0;
+    uint32_t now = Timebase_GetUs(), idle = sched_idle_time();
+
+    if(now != last_us)
+    {
+        cpu_load = (uint8_t)(100 - (uint64_t)(idle - last_idle) * 100 / (now - last_us));
+    }
+    last_us = now;
+    last_idle = idle;
+}
+
+BtnCoroutine combo_co;
+
+// 单击后2s内长按: LED3
+void Combo_Task(void* arg)
+{
+    BtnCoroutine* co = (BtnCoroutine*)arg;
+
+    BTN_CO_BEGIN(co);
+    while(1)
+    {
+        BTN_AWAIT(co, &btn1, BTN_EVENT_MASK(SINGLE_CLICK), 0);
+        BTN_AWAIT(co, &btn1, BTN_EVENT_MASK(LONG_PRESS_START), 2000);
+        if(co->ev.event == LONG_PRESS_START)
+        {
+            LED3_TOGGLE;
+        }
+    }
+    BTN_CO_END(co);
+}
+
+int main()
+{
+    uint8_t ev;
+
+    // Init btn1/LED GPIO
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOD|RCC_AHBPeriph_GPIOC, ENABLE);
+    GPIO_Init(BTN1_PORT, BTN1_PIN, GPIO_MODE_IN | GPIO_SPEED_HIGH);
+    GPIO_Init(LED1_PORT, LED1_PIN, GPIO_MODE_OUT | GPIO_OTYPE_PP | GPIO_PUPD_UP | GPIO_DRV_HIGH | GPIO_SPEED_HIGH);
+    GPIO_Init(LED2_PORT, LED2_PIN, GPIO_MODE_OUT | GPIO_OTYPE_PP | GPIO_PUPD_UP | GPIO_DRV_HIGH | GPIO_SPEED_HIGH);
+    GPIO_Init(LED3_PORT, LED3_PIN, GPIO_MODE_OUT | GPIO_OTYPE_PP | GPIO_PUPD_UP | GPIO_DRV_HIGH | GPIO_SPEED_HIGH);
+
+
+    sched_task_init(&btn_task, Button_Task, 0, 1);
+    sched_task_init(&load_task, Load_Task, 0, 3);
+
+    // every event posts the task so the event queue is drained in time
+    button_init(&btn1, read_button_GPIO, 0, btn1_id);
+    for(ev = 0; ev < number_of_event; ev++)
+    {
+        button_attach_ctx(&btn1, (PressEvent)ev, Button_Post_Handler, &btn_task);
+    }
+    button_start(&btn1);
+
+    button_co_init(&combo_co, Combo_Task, 2);
+    button_co_start(&combo_co);
+
+    Timebase_Init();
+    Timebase_AddPeriodic(soft_timer_ticks, 1);
+    ButtonTick_Init();
+    soft_timer_init(&load_timer, Load_Post_Handler, 1000, 1000);
+    soft_timer_start(&load_timer);
+
+    sched_set_clock(Timebase_GetUs);
+    sched_run();
 }
 #endif
 
@@ -141,9 +279,21 @@ void BTN1_LONG_PRESS_HOLD_Handler(void* btn)
 	//do something...
 }
 
-void SysTick_Handler(void)
+void BTN1_LONG_PRESS_STAGE_Handler(void* btn)
 {
-    button_ticks();
+	// the stage travels with the event, deferred callbacks may run after the next stage
+	switch(button_current_event()->stage)
+	{
+		case 1: //hold 1s: power
+			break;
+		case 2: //hold 3s: pair
+			break;
+		case 3: //hold 10s: factory reset
+			break;
+		default:
+			break;
+	}
+	//do something...
 }
 
 /*********************************************END OF FILE**********************/